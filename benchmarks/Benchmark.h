@@ -0,0 +1,164 @@
+#ifndef COMAD_BENCHMARK_H_
+#define COMAD_BENCHMARK_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace comad::bench {
+	struct BenchmarkResult {
+		std::string name;
+		std::size_t operations;
+		double ns_per_op;
+		double allocations_per_op;
+	};
+
+	// incremented by the global operator new of the ComadBench executable
+	inline std::atomic<std::size_t> allocation_count{ 0 };
+
+	template <typename T>
+	inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static const volatile void* sink;
+		sink = &value;
+#endif
+	}
+
+	class BenchmarkRunner {
+	public:
+		explicit BenchmarkRunner(std::string_view filter = {},
+		                         std::chrono::nanoseconds min_time = std::chrono::milliseconds{ 200 }) :
+			filter_{ filter },
+			min_time_{ min_time }
+		{}
+
+		// runs body once per call, doubling the iteration count until a batch takes min_time.
+		// a body that performs several operations per call passes their count as ops_per_call
+		template <typename F>
+		void Run(std::string_view name, F&& body, std::size_t ops_per_call = 1) {
+			using clock = std::chrono::steady_clock;
+
+			if (name.find(filter_) == std::string_view::npos) {
+				return;
+			}
+
+			std::size_t iterations = 1;
+			clock::duration elapsed{};
+			std::size_t allocations = 0;
+			while (true) {
+				const std::size_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+				const clock::time_point start = clock::now();
+				for (std::size_t i = 0; i < iterations; ++i) {
+					body();
+				}
+				elapsed = clock::now() - start;
+				allocations = allocation_count.load(std::memory_order_relaxed) - allocations_before;
+
+				if (elapsed >= min_time_) {
+					break;
+				}
+				iterations *= 2;
+			}
+
+			Record(name, iterations * ops_per_call, elapsed, allocations);
+		}
+
+		// runs body on thread_count threads at once; ns_per_op is wall time over the operations of all
+		// threads, so it drops as throughput scales with the threads
+		template <typename F>
+		void RunParallel(std::string_view name, std::size_t thread_count, F&& body) {
+			using clock = std::chrono::steady_clock;
+
+			if (name.find(filter_) == std::string_view::npos) {
+				return;
+			}
+
+			std::size_t iterations = 1;
+			clock::duration elapsed{};
+			std::size_t allocations = 0;
+			while (true) {
+				std::vector<std::thread> threads{};
+				threads.reserve(thread_count);
+				const std::size_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+				const clock::time_point start = clock::now();
+				for (std::size_t t = 0; t < thread_count; ++t) {
+					threads.emplace_back([&body, iterations] {
+						for (std::size_t i = 0; i < iterations; ++i) {
+							body();
+						}
+					});
+				}
+				for (std::thread& thread : threads) {
+					thread.join();
+				}
+				elapsed = clock::now() - start;
+				allocations = allocation_count.load(std::memory_order_relaxed) - allocations_before;
+
+				if (elapsed >= min_time_) {
+					break;
+				}
+				iterations *= 2;
+			}
+
+			Record(name, iterations * thread_count, elapsed, allocations);
+		}
+
+		[[nodiscard]] const std::vector<BenchmarkResult>& GetResults() const noexcept {
+			return results_;
+		}
+
+		void Print(std::ostream& stream) const {
+			for (const BenchmarkResult& result : results_) {
+				stream << std::left << std::setw(56) << result.name
+					<< std::right << std::setw(14) << std::fixed << std::setprecision(2) << result.ns_per_op << " ns/op"
+					<< std::setw(10) << result.allocations_per_op << " allocs/op"
+					<< std::setw(14) << result.operations << " operations\n";
+			}
+		}
+
+		// one object per result, so runs of different releases can be diffed by name
+		void PrintJson(std::ostream& stream, std::string_view version, bool verbose) const {
+			stream << "{\n  \"version\": \"" << version << "\",\n  \"verbose\": " << (verbose ? "true" : "false")
+				<< ",\n  \"results\": [";
+			for (std::size_t i = 0; i < results_.size(); ++i) {
+				const BenchmarkResult& result = results_[i];
+				stream << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << result.name << "\""
+					<< ", \"operations\": " << result.operations
+					<< ", \"ns_per_op\": " << std::fixed << std::setprecision(3) << result.ns_per_op
+					<< ", \"allocations_per_op\": " << result.allocations_per_op << "}";
+			}
+			stream << "\n  ]\n}\n";
+		}
+
+	private:
+		void Record(std::string_view name, std::size_t operations, std::chrono::nanoseconds elapsed, std::size_t allocations) {
+			const double ops = static_cast<double>(operations);
+			results_.push_back(BenchmarkResult{ std::string{ name }, operations,
+				std::chrono::duration<double, std::nano>(elapsed).count() / ops, static_cast<double>(allocations) / ops });
+		}
+
+		std::string_view filter_;
+		std::chrono::nanoseconds min_time_;
+		std::vector<BenchmarkResult> results_{};
+	};
+
+	void RunDispatchBenchmarks(BenchmarkRunner& runner);
+	void RunLoggingBenchmarks(BenchmarkRunner& runner);
+	void RunConcurrencyBenchmarks(BenchmarkRunner& runner);
+	void RunStreamBenchmarks(BenchmarkRunner& runner);
+	void RunOptionBenchmarks(BenchmarkRunner& runner);
+	void RunValueBenchmarks(BenchmarkRunner& runner);
+	void RunSchemaBenchmarks(BenchmarkRunner& runner);
+	void RunExecutorBenchmarks(BenchmarkRunner& runner);
+	void RunStartupBenchmarks(BenchmarkRunner& runner);
+}
+
+#endif
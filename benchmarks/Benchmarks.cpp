@@ -0,0 +1,114 @@
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "Benchmark.h"
+#include "Comad.h"
+
+// every form that the replaced operator delete may free is replaced, including the nothrow and array
+// ones the standard library uses for temporary buffers
+void* operator new(std::size_t size) {
+	comad::bench::allocation_count.fetch_add(1, std::memory_order_relaxed);
+	if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+		return ptr;
+	}
+	throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	comad::bench::allocation_count.fetch_add(1, std::memory_order_relaxed);
+	return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+	return operator new(size, tag);
+}
+
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+	std::free(ptr);
+}
+
+// usage: ComadBench [--json] [--min-time-ms=N] [filter]
+int main(int argc, char** argv) {
+	using namespace comad;
+	using namespace comad::bench;
+	using namespace std::string_view_literals;
+
+	constexpr std::string_view kMinTimeFlag = "--min-time-ms="sv;
+
+	std::string_view filter{};
+	bool json = false;
+	std::chrono::milliseconds min_time{ 200 };
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string_view arg{ argv[i] };
+		if (arg == "--json"sv) {
+			json = true;
+		}
+		else if (arg.starts_with(kMinTimeFlag)) {
+			int ms = 0;
+			std::from_chars(arg.data() + kMinTimeFlag.size(), arg.data() + arg.size(), ms);
+			min_time = std::chrono::milliseconds{ ms };
+		}
+		else {
+			filter = arg;
+		}
+	}
+
+	std::ostringstream version{};
+	version << GetLinkedVersion();
+
+	if (!json) {
+		std::cout << "comad version " << version.str() << std::endl;
+		std::cout << "verbose logging " << (build_options::Verbose ? "on" : "off") << std::endl << std::endl;
+	}
+
+	BenchmarkRunner runner{ filter, min_time };
+
+	RunDispatchBenchmarks(runner);
+	RunOptionBenchmarks(runner);
+	RunValueBenchmarks(runner);
+	RunSchemaBenchmarks(runner);
+	RunExecutorBenchmarks(runner);
+	RunStartupBenchmarks(runner);
+	RunLoggingBenchmarks(runner);
+	RunConcurrencyBenchmarks(runner);
+	RunStreamBenchmarks(runner);
+
+	if (json) {
+		runner.PrintJson(std::cout, version.str(), build_options::Verbose);
+	}
+	else {
+		runner.Print(std::cout);
+	}
+	return 0;
+}
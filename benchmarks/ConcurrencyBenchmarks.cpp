@@ -0,0 +1,83 @@
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "Benchmark.h"
+#include "Comad.h"
+
+namespace comad::bench {
+	using namespace comad::command;
+	using namespace comad::literals;
+	using namespace std::string_view_literals;
+	using namespace std::string_literals;
+
+	void RunConcurrencyBenchmarks(BenchmarkRunner& runner) {
+		CommandHandler handler{};
+		(handler.GetCommandNode() >> "server"sv >> "start"sv)("detach"_fl, "port"_ai,
+			"workers"_o(value::ValueBounds{ 1, 64 }), "mode"_o("fast"s, "safe"s)) = [](const ExecutionContext& ctx) {
+			return ctx.args.find("port"sv)->second.GetValue<int>();
+		};
+		handler.Freeze();
+
+		const std::array input{ "server"sv, "start"sv, "-fdetach"sv, "8080"sv, "--workers"sv, "8"sv, "-m"sv, "fast"sv };
+
+		const std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+		for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+			runner.RunParallel("concurrency/handle_command_threads_" + std::to_string(threads), threads, [&] {
+				DoNotOptimize(handler.HandleCommand(input));
+			});
+		}
+
+		// the same dispatch while another thread publishes a freshly built tree as fast as it can
+		const auto make_tree = [] {
+			CommandNode root{};
+			(root >> "server"sv >> "start"sv)("detach"_fl, "port"_ai,
+				"workers"_o(value::ValueBounds{ 1, 64 }), "mode"_o("fast"s, "safe"s)) = [](const ExecutionContext& ctx) {
+				return ctx.args.find("port"sv)->second.GetValue<int>();
+			};
+			return root;
+		};
+
+		CommandHandler reloaded{};
+		reloaded.SetCommandNode(make_tree());
+		std::atomic<bool> reloading{ true };
+		std::atomic<std::uint64_t> reloads{ 0 };
+		std::thread reloader{ [&] {
+			while (reloading.load(std::memory_order_relaxed)) {
+				reloaded.SetCommandNode(make_tree());
+				reloads.fetch_add(1, std::memory_order_relaxed);
+			}
+		} };
+
+		for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+			runner.RunParallel("concurrency/handle_command_during_reloads_threads_" + std::to_string(threads), threads, [&] {
+				DoNotOptimize(reloaded.HandleCommand(input));
+			});
+		}
+
+		reloading.store(false);
+		reloader.join();
+		DoNotOptimize(reloads.load());
+
+		// the round trip of a command through the pool, against the same command run inline above
+		ThreadPool pool{ 1 };
+		runner.Run("concurrency/handle_command_async_round_trip", [&] {
+			DoNotOptimize(handler.HandleCommandAsync(pool, input).Get());
+		});
+
+		// many commands in flight before the first result is collected
+		std::array<CommandFuture, 64> futures{};
+		ThreadPool wide_pool{ max_threads };
+		runner.Run("concurrency/handle_command_async_batch_64", [&] {
+			for (CommandFuture& future : futures) {
+				future = handler.HandleCommandAsync(wide_pool, input);
+			}
+			for (const CommandFuture& future : futures) {
+				DoNotOptimize(future.Get());
+			}
+		});
+	}
+}
@@ -0,0 +1,401 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Comad.h"
+
+namespace comad::bench {
+	using namespace comad::command;
+
+	namespace {
+		constexpr std::size_t kTreeWidth = 16;
+		constexpr std::size_t kTreeDepth = 3;
+		constexpr std::size_t kPathCount = 1024;
+
+		using CommandPath = std::array<std::string_view, kTreeDepth>;
+
+		void BuildTree(CommandNode& node, std::size_t depth) {
+			if (depth == kTreeDepth) {
+				return;
+			}
+
+			for (std::size_t i = 0; i < kTreeWidth; ++i) {
+				const std::string name = "node" + std::to_string(i);
+				CommandNode& child = node >> name;
+				child | ("n" + std::to_string(i)) | ("alias" + std::to_string(i));
+				child = [](const ExecutionContext&) { return 0; };
+
+				BuildTree(child, depth + 1);
+			}
+		}
+
+		// a spine of depth levels; every level has width siblings but only the first one continues
+		std::vector<std::string> BuildSpine(CommandNode& root, std::size_t depth, std::size_t width) {
+			std::vector<std::string> path{};
+			CommandNode* node = &root;
+			for (std::size_t level = 0; level < depth; ++level) {
+				for (std::size_t i = width; i-- > 0;) {
+					CommandNode& child = *node >> ("level" + std::to_string(level) + "_" + std::to_string(i));
+					child = [](const ExecutionContext&) { return 0; };
+					if (i == 0) {
+						path.emplace_back(child.GetName());
+						node = &child;
+					}
+				}
+			}
+			return path;
+		}
+
+		// width children with alias_count aliases each, returning the aliases in random order
+		std::vector<std::string> BuildAliasedLevel(CommandNode& root, std::size_t width, std::size_t alias_count) {
+			std::vector<std::string> aliases{};
+			for (std::size_t i = 0; i < width; ++i) {
+				CommandNode& child = root >> ("cmd" + std::to_string(i));
+				child = [](const ExecutionContext&) { return 0; };
+				for (std::size_t a = 0; a < alias_count; ++a) {
+					aliases.push_back("c" + std::to_string(i) + "a" + std::to_string(a));
+					child | aliases.back();
+				}
+			}
+
+			std::shuffle(aliases.begin(), aliases.end(), std::mt19937{ 42 });
+			return aliases;
+		}
+
+		void RunTreeShapeBenchmarks(BenchmarkRunner& runner) {
+			for (const std::size_t depth : { 1, 4, 16, 64 }) {
+				CommandHandler handler{};
+				const std::vector<std::string> path = BuildSpine(handler.GetCommandNode(), depth, 8);
+				const std::string suffix = "depth_" + std::to_string(depth);
+
+				runner.Run("dispatch/tree/map_walk/" + suffix, [&] {
+					DoNotOptimize(handler.HandleCommand(path));
+				});
+				handler.Freeze();
+				runner.Run("dispatch/tree/compiled/" + suffix, [&] {
+					DoNotOptimize(handler.HandleCommand(path));
+				});
+			}
+
+			for (const std::size_t width : { 4, 64, 1024, 16384 }) {
+				CommandHandler handler{};
+				std::vector<std::string> names{};
+				for (std::size_t i = 0; i < width; ++i) {
+					names.push_back("wide" + std::to_string(i));
+					handler.GetCommandNode() >> names.back() = [](const ExecutionContext&) { return 0; };
+				}
+				std::shuffle(names.begin(), names.end(), std::mt19937{ 42 });
+
+				const std::string suffix = "width_" + std::to_string(width);
+				std::size_t cursor = 0;
+				std::array<std::string_view, 1> path{};
+
+				runner.Run("dispatch/tree/map_walk/" + suffix, [&] {
+					path[0] = names[cursor++ % names.size()];
+					DoNotOptimize(handler.HandleCommand(path));
+				});
+				handler.Freeze();
+				runner.Run("dispatch/tree/compiled/" + suffix, [&] {
+					path[0] = names[cursor++ % names.size()];
+					DoNotOptimize(handler.HandleCommand(path));
+				});
+			}
+
+			for (const std::size_t alias_count : { 1, 8, 64 }) {
+				CommandHandler handler{};
+				const std::vector<std::string> aliases = BuildAliasedLevel(handler.GetCommandNode(), 64, alias_count);
+
+				const std::string suffix = "aliases_" + std::to_string(alias_count);
+				std::size_t cursor = 0;
+				std::array<std::string_view, 1> path{};
+
+				runner.Run("dispatch/alias/map_walk/" + suffix, [&] {
+					path[0] = aliases[cursor++ % aliases.size()];
+					DoNotOptimize(handler.HandleCommand(path));
+				});
+				handler.Freeze();
+				runner.Run("dispatch/alias/compiled/" + suffix, [&] {
+					path[0] = aliases[cursor++ % aliases.size()];
+					DoNotOptimize(handler.HandleCommand(path));
+				});
+			}
+		}
+
+		std::vector<std::string> MakeNames(std::string_view prefix) {
+			std::vector<std::string> names{};
+			for (std::size_t i = 0; i < kTreeWidth; ++i) {
+				names.push_back(std::string{ prefix } + std::to_string(i));
+			}
+			return names;
+		}
+		// a status query whose executor does some work, dispatched with and without a cached result
+		void RunCacheBenchmarks(BenchmarkRunner& runner) {
+			using namespace comad::literals;
+			using namespace std::string_view_literals;
+
+			auto status = [](const ExecutionContext& ctx) {
+				std::uint64_t checksum = static_cast<std::uint64_t>(ctx.options.find("depth"sv)->second.GetValue<int>());
+				for (int i = 0; i < 4096; ++i) {
+					checksum = checksum * 6364136223846793005ull + 1442695040888963407ull;
+				}
+				return static_cast<int>(checksum >> 33);
+			};
+
+			CommandHandler uncached{};
+			(uncached.GetCommandNode() >> "status"sv)("depth"_o(value::ValueType::kInt), "verbose"_fl) = status;
+			uncached.Freeze();
+
+			CommandHandler cached{};
+			CommandNode& cached_node = cached.GetCommandNode() >> "status"sv;
+			cached_node("depth"_o(value::ValueType::kInt), "verbose"_fl) = status;
+			cached_node.SetCachePolicy(CachePolicy{ std::chrono::seconds{ 10 } });
+			cached.Freeze();
+
+			const std::array input{ "status"sv, "--depth"sv, "2"sv, "-fverbose"sv };
+
+			runner.Run("dispatch/cache/uncached", [&] {
+				DoNotOptimize(uncached.HandleCommand(input));
+			});
+			runner.Run("dispatch/cache/hit", [&] {
+				DoNotOptimize(cached.HandleCommand(input));
+			});
+
+			const std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+			runner.RunParallel("dispatch/cache/hit_threads_" + std::to_string(max_threads), max_threads, [&] {
+				DoNotOptimize(cached.HandleCommand(input));
+			});
+		}
+		// the same dispatch with metrics disabled and enabled, single threaded and from every core
+		void RunMetricsBenchmarks(BenchmarkRunner& runner) {
+			using namespace comad::literals;
+			using namespace std::string_view_literals;
+
+			CommandHandler handler{};
+			(handler.GetCommandNode() >> "set"sv)("level"_o(value::ValueBounds{ 0, 10 }), "force"_fl) = [](const ExecutionContext&) {
+				return 0;
+			};
+			handler.Freeze();
+
+			const std::array input{ "set"sv, "--level"sv, "5"sv, "-fforce"sv };
+			const std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+			runner.Run("dispatch/metrics/off", [&] {
+				DoNotOptimize(handler.HandleCommand(input));
+			});
+
+			if constexpr (build_options::EnableMetrics) {
+				handler.EnableMetrics();
+				runner.Run("dispatch/metrics/on", [&] {
+					DoNotOptimize(handler.HandleCommand(input));
+				});
+				runner.RunParallel("dispatch/metrics/on_threads_" + std::to_string(max_threads), max_threads, [&] {
+					DoNotOptimize(handler.HandleCommand(input));
+				});
+			}
+		}
+	}
+
+	namespace {
+		struct DiscardingSink : TraceSink {
+			void Write(const Trace& trace) override {
+				DoNotOptimize(trace.spans.size());
+			}
+		};
+
+		// the cost of tracing every dispatch and of the sampling rates that stay on in production
+		void RunTraceBenchmarks(BenchmarkRunner& runner) {
+			using namespace comad::literals;
+			using namespace std::string_view_literals;
+
+			CommandHandler handler{};
+			(handler.GetCommandNode() >> "set"sv)("level"_o(value::ValueBounds{ 0, 10 }), "force"_fl) = [](const ExecutionContext&) {
+				return 0;
+			};
+			handler.Freeze();
+
+			const std::array input{ "set"sv, "--level"sv, "5"sv, "-fforce"sv };
+
+			runner.Run("dispatch/trace/off", [&] {
+				DoNotOptimize(handler.HandleCommand(input));
+			});
+
+			if constexpr (build_options::EnableTracing) {
+				for (const std::uint32_t sample_every : { 1u, 64u, 1024u }) {
+					handler.EnableTracing(std::make_shared<DiscardingSink>(), sample_every);
+					runner.Run("dispatch/trace/1_in_" + std::to_string(sample_every), [&] {
+						DoNotOptimize(handler.HandleCommand(input));
+					});
+				}
+			}
+		}
+	}
+
+	namespace {
+		// did you mean lookups for mistyped names among width siblings, against comparing with every name
+		void RunSuggestionBenchmarks(BenchmarkRunner& runner) {
+			for (const std::size_t width : { 100, 1000, 10000 }) {
+				CommandHandler handler{};
+				std::vector<std::string> names{};
+				std::mt19937 rng{ 42 };
+				std::uniform_int_distribution<int> letter{ 'a', 'z' };
+				for (std::size_t i = 0; i < width; ++i) {
+					std::string name{};
+					for (int c = 0; c < 8; ++c) {
+						name.push_back(static_cast<char>(letter(rng)));
+					}
+					names.push_back(name);
+					handler.GetCommandNode() >> name = [](const ExecutionContext&) { return 0; };
+				}
+				handler.Freeze();
+
+				// a swap of neighbouring letters and a dropped letter
+				std::vector<std::string> typos{};
+				for (std::size_t i = 0; i < 64; ++i) {
+					std::string typo = names[i * width / 64];
+					std::swap(typo[2], typo[3]);
+					typo.erase(6, 1);
+					typos.push_back(typo);
+				}
+
+				const CommandNode& root = std::as_const(handler).GetCommandNode();
+				const std::string suffix = "width_" + std::to_string(width);
+				std::size_t cursor = 0;
+
+				runner.Run("dispatch/suggest/indexed/" + suffix, [&] {
+					DoNotOptimize(handler.SuggestCommand(root, typos[cursor++ % typos.size()]));
+				});
+				runner.Run("dispatch/suggest/brute_force/" + suffix, [&] {
+					const std::string& typo = typos[cursor++ % typos.size()];
+					std::size_t best = SuggestionIndex::kDefaultMaxDistance + 1;
+					for (const std::string& name : names) {
+						best = std::min(best, SuggestionIndex::GetEditDistance(typo, name, SuggestionIndex::kDefaultMaxDistance));
+					}
+					DoNotOptimize(best);
+				});
+			}
+		}
+	}
+
+	namespace {
+		// tab completion of one to three typed letters among width siblings, against walking the children
+		void RunCompletionBenchmarks(BenchmarkRunner& runner) {
+			for (const std::size_t width : { 100, 1000, 10000 }) {
+				CommandHandler handler{};
+				std::vector<std::string> names{};
+				std::mt19937 rng{ 7 };
+				std::uniform_int_distribution<int> letter{ 'a', 'z' };
+				for (std::size_t i = 0; i < width; ++i) {
+					std::string name{};
+					for (int c = 0; c < 8; ++c) {
+						name.push_back(static_cast<char>(letter(rng)));
+					}
+					names.push_back(name);
+					handler.GetCommandNode() >> name = [](const ExecutionContext&) { return 0; };
+				}
+				handler.Freeze();
+
+				std::vector<std::string> prefixes{};
+				for (std::size_t i = 0; i < 64; ++i) {
+					prefixes.push_back(names[i * width / 64].substr(0, 1 + i % 3));
+				}
+
+				const CommandNode& root = std::as_const(handler).GetCommandNode();
+				const std::string suffix = "width_" + std::to_string(width);
+				std::size_t cursor = 0;
+
+				runner.Run("dispatch/complete/trie/" + suffix, [&] {
+					const std::array partial{ std::string_view{ prefixes[cursor++ % prefixes.size()] } };
+					DoNotOptimize(handler.Complete(partial));
+				});
+				runner.Run("dispatch/complete/map_walk/" + suffix, [&] {
+					const std::string_view prefix = prefixes[cursor++ % prefixes.size()];
+					std::vector<Completion> completions{};
+					for (const auto& [name, child] : root.GetChildren()) {
+						if (completions.size() == 16) {
+							break;
+						}
+						if (name.starts_with(prefix)) {
+							completions.push_back(Completion{ name, CompletionKind::kCommand, child.GetUseCount() });
+						}
+					}
+					DoNotOptimize(completions);
+				});
+			}
+		}
+	}
+
+	void RunDispatchBenchmarks(BenchmarkRunner& runner) {
+		CommandHandler map_handler{};
+		BuildTree(map_handler.GetCommandNode(), 0);
+
+		CommandHandler compiled_handler{};
+		BuildTree(compiled_handler.GetCommandNode(), 0);
+		compiled_handler.Freeze();
+
+		const std::vector<std::string> names = MakeNames("node");
+		const std::vector<std::string> aliases = MakeNames("alias");
+
+		std::mt19937 rng{ 42 };
+		std::uniform_int_distribution<std::size_t> pick{ 0, kTreeWidth - 1 };
+		std::vector<CommandPath> paths(kPathCount);
+		std::vector<CommandPath> alias_paths(kPathCount);
+		for (std::size_t i = 0; i < kPathCount; ++i) {
+			for (std::size_t level = 0; level < kTreeDepth; ++level) {
+				const std::size_t index = pick(rng);
+				paths[i][level] = names[index];
+				alias_paths[i][level] = aliases[index];
+			}
+		}
+
+		std::size_t cursor = 0;
+		const CommandNode& map_root = map_handler.GetCommandNode();
+		CompiledCommandTree compiled_tree{ map_root };
+
+		runner.Run("dispatch/find_node/map_walk", [&] {
+			const CommandPath& path = paths[cursor++ % kPathCount];
+			auto it = path.begin();
+			DoNotOptimize(&detail::FindNode(map_root, it, path.end()));
+		});
+
+		runner.Run("dispatch/find_node/compiled", [&] {
+			const CommandPath& path = paths[cursor++ % kPathCount];
+			auto it = path.begin();
+			DoNotOptimize(&detail::FindNode(compiled_tree, it, path.end()));
+		});
+
+		runner.Run("dispatch/find_node_alias/map_walk", [&] {
+			const CommandPath& path = alias_paths[cursor++ % kPathCount];
+			auto it = path.begin();
+			DoNotOptimize(&detail::FindNode(map_root, it, path.end()));
+		});
+
+		runner.Run("dispatch/find_node_alias/compiled", [&] {
+			const CommandPath& path = alias_paths[cursor++ % kPathCount];
+			auto it = path.begin();
+			DoNotOptimize(&detail::FindNode(compiled_tree, it, path.end()));
+		});
+
+		runner.Run("dispatch/handle_command/map_walk", [&] {
+			DoNotOptimize(map_handler.HandleCommand(paths[cursor++ % kPathCount]));
+		});
+
+		runner.Run("dispatch/handle_command/compiled", [&] {
+			DoNotOptimize(compiled_handler.HandleCommand(paths[cursor++ % kPathCount]));
+		});
+
+		RunTreeShapeBenchmarks(runner);
+		RunCacheBenchmarks(runner);
+		RunMetricsBenchmarks(runner);
+		RunTraceBenchmarks(runner);
+		RunSuggestionBenchmarks(runner);
+		RunCompletionBenchmarks(runner);
+	}
+}
@@ -0,0 +1,69 @@
+#include <array>
+#include <functional>
+#include <string_view>
+
+#include "Benchmark.h"
+#include "Comad.h"
+
+namespace comad::bench {
+	using namespace comad::command;
+	using namespace std::string_view_literals;
+
+	namespace {
+		int RunPlain(const ExecutionContext& ctx) {
+			return static_cast<int>(ctx.extra_args.size()) + 1;
+		}
+	}
+
+	void RunExecutorBenchmarks(BenchmarkRunner& runner) {
+		const ExecutionContext ctx{};
+		int state = 1;
+
+		// the callables escape before the loops, so every call goes through the stored pointer
+		int (* volatile function_pointer)(const ExecutionContext&) = RunPlain;
+		const CommandExecutor plain{ RunPlain };
+		const CommandExecutor capturing{ [&state](const ExecutionContext& ctx) {
+			return static_cast<int>(ctx.extra_args.size()) + state;
+		} };
+		const std::function<int(const ExecutionContext&)> function{ [&state](const ExecutionContext& ctx) {
+			return static_cast<int>(ctx.extra_args.size()) + state;
+		} };
+		DoNotOptimize(&plain);
+		DoNotOptimize(&capturing);
+		DoNotOptimize(&function);
+
+		runner.Run("executor/call/function_pointer", [&] {
+			DoNotOptimize(function_pointer(ctx));
+		});
+		runner.Run("executor/call/inline_function_pointer", [&] {
+			DoNotOptimize(plain(ctx));
+		});
+		runner.Run("executor/call/inline_capturing", [&] {
+			DoNotOptimize(capturing(ctx));
+		});
+		runner.Run("executor/call/std_function", [&] {
+			DoNotOptimize(function(ctx));
+		});
+
+		runner.Run("executor/copy/inline_capturing", [&] {
+			const CommandExecutor copy{ capturing };
+			DoNotOptimize(&copy);
+		});
+
+		// the same command dispatched with each kind of executor
+		const std::array input{ "foo"sv };
+		CommandHandler plain_handler{};
+		plain_handler.GetCommandNode() >> "foo"sv = RunPlain;
+		CommandHandler capturing_handler{};
+		capturing_handler.GetCommandNode() >> "foo"sv = [&state](const ExecutionContext& ctx) {
+			return static_cast<int>(ctx.extra_args.size()) + state;
+		};
+
+		runner.Run("executor/dispatch/function_pointer", [&] {
+			DoNotOptimize(plain_handler.HandleCommand(input));
+		});
+		runner.Run("executor/dispatch/inline_capturing", [&] {
+			DoNotOptimize(capturing_handler.HandleCommand(input));
+		});
+	}
+}
@@ -0,0 +1,104 @@
+#include <optional>
+#include <ostream>
+#include <streambuf>
+#include <string_view>
+
+#include "Benchmark.h"
+#include "Comad.h"
+
+namespace comad::bench {
+	using namespace comad::command;
+	using namespace comad::literals;
+	using namespace comad::logger;
+	using namespace std::string_view_literals;
+
+	namespace {
+		// discards everything written to it so the sink cost does not dominate the logger cost
+		class NullBuffer : public std::streambuf {
+		protected:
+			int overflow(int c) override { return c; }
+			std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+		};
+
+		// ParseOption with every logging call stripped out, as the baseline for the real one
+		int ParseOptionWithoutLogging(std::string_view name, std::string_view value,
+		                              const CommandNode& node, ExecutionContext& ctx) {
+			using namespace build_options;
+
+			if (name.starts_with(OptionPrefix)) {
+				name.remove_prefix(OptionPrefix.length());
+			}
+			else if (name.starts_with(ShortOptionPrefix)) {
+				name.remove_prefix(ShortOptionPrefix.length());
+				if (const OptionDescriptor* descriptor = node.GetOptionTable().FindShort(name[0])) {
+					name = descriptor->name;
+				}
+			}
+
+			const std::size_t slot = node.FindOptionSlot(name);
+			if (slot == kNoSlot) {
+				if constexpr (SkipUnknownOption) return retc::kOptionNotParsed;
+				return retc::kUnknownOption;
+			}
+
+			const CommandOption& option = node.GetOptionAt(slot);
+			if (!SkipDupeOption && ctx.options.Has(slot)) {
+				return retc::kDupeOption;
+			}
+
+			auto wrapped = detail::StringToValue(option.GetValueType(), value);
+			if (wrapped == std::nullopt) {
+				if constexpr (SkipInvalidValueParse) return retc::kOptionNotParsed;
+				return retc::kInvalidValueParse;
+			}
+			if (!detail::IsValueValid(option, *wrapped)) {
+				return retc::kInvalidOptionValue;
+			}
+
+			ctx.options.Set(slot, std::move(*wrapped));
+			ctx.required_option_count += option.required;
+			return retc::kOptionParsed;
+		}
+	}
+
+	void RunLoggingBenchmarks(BenchmarkRunner& runner) {
+		CommandNode root{};
+		CommandNode& node = (root >> "cmd")("level"_o(value::ValueBounds{ 0, 100 }), "ratio"_o(value::ValueType::kFloat));
+		ExecutionContext ctx{};
+
+		runner.Run("logging/parse_option", [&] {
+			ctx.Bind(node.GetContextLayout());
+			DoNotOptimize(detail::ParseOption("--level"sv, "42"sv, node, ctx));
+			DoNotOptimize(detail::ParseOption("-r"sv, "0.5"sv, node, ctx));
+		});
+
+		runner.Run("logging/parse_option_without_logging", [&] {
+			ctx.Bind(node.GetContextLayout());
+			DoNotOptimize(ParseOptionWithoutLogging("--level"sv, "42"sv, node, ctx));
+			DoNotOptimize(ParseOptionWithoutLogging("-r"sv, "0.5"sv, node, ctx));
+		});
+
+		int counter = 0;
+		runner.Run("logging/library_debug_call", [&] {
+			LogDebug("benchmark message ", ++counter);
+			DoNotOptimize(counter);
+		});
+
+		NullBuffer null_buffer{};
+		std::ostream null_stream{ &null_buffer };
+		Logger bench_logger{ {.info = {std::ref(null_stream)}}, "{0} {1}: {2}",
+			LogLevelSpecifier{}, SourceLocationSpecifier{}, MessageSpecifier{} };
+
+		runner.Run("logging/sync_info", [&] {
+			bench_logger.Info("benchmark message");
+		});
+
+		bench_logger.EnableAsync({ .capacity = 1 << 16, .overflow = OverflowPolicy::kDrop });
+		runner.Run("logging/async_info", [&] {
+			bench_logger.Info("benchmark message");
+		});
+		bench_logger.Flush();
+		DoNotOptimize(bench_logger.GetDroppedCount());
+		bench_logger.DisableAsync();
+	}
+}
@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Comad.h"
+
+namespace comad::bench {
+	using namespace comad::command;
+
+	namespace {
+		constexpr std::string_view kShortNames = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+		// option_count int options named opt<i>; the first 52 also get a one letter short name
+		CommandTemplate MakeOptionTemplate(std::size_t option_count) {
+			CommandTemplate cmd_template{};
+			for (std::size_t i = 0; i < option_count; ++i) {
+				CommandOption option{};
+				option(value::ValueBounds{ 0, 1000 });
+				option.short_name = i < kShortNames.size() ? kShortNames[i] : 0;
+				cmd_template.options.emplace("opt" + std::to_string(i), std::move(option));
+			}
+			return cmd_template;
+		}
+	}
+
+	void RunOptionBenchmarks(BenchmarkRunner& runner) {
+		for (const std::size_t option_count : { 4, 16, 64 }) {
+			CommandHandler handler{};
+			handler.GetCommandNode().AddNode("cmd", MakeOptionTemplate(option_count),
+				[](const ExecutionContext& ctx) { return static_cast<int>(ctx.options.size()); });
+			handler.Freeze();
+
+			// the last four options, so lookups do not favour the front of the table
+			std::vector<std::string> long_input{ "cmd" };
+			std::vector<std::string> short_input{ "cmd" };
+			std::vector<std::string> equals_input{ "cmd" };
+			std::vector<std::string> attached_input{ "cmd" };
+			for (std::size_t i = option_count - 4; i < option_count; ++i) {
+				long_input.push_back("--opt" + std::to_string(i));
+				long_input.push_back(std::to_string(i + 1));
+				equals_input.push_back("--opt" + std::to_string(i) + "=" + std::to_string(i + 1));
+			}
+			// the short forms use the last four options that have a short name
+			const std::size_t short_count = std::min(option_count, kShortNames.size());
+			for (std::size_t i = short_count - 4; i < short_count; ++i) {
+				short_input.push_back("-" + std::string{ kShortNames[i] });
+				short_input.push_back(std::to_string(i + 1));
+				attached_input.push_back("-" + std::string{ kShortNames[i] } + std::to_string(i + 1));
+			}
+
+			const std::string suffix = std::to_string(option_count) + "_options";
+			runner.Run("options/long/" + suffix, [&] {
+				DoNotOptimize(handler.HandleCommand(long_input));
+			});
+			runner.Run("options/short/" + suffix, [&] {
+				DoNotOptimize(handler.HandleCommand(short_input));
+			});
+			runner.Run("options/equals/" + suffix, [&] {
+				DoNotOptimize(handler.HandleCommand(equals_input));
+			});
+			runner.Run("options/attached/" + suffix, [&] {
+				DoNotOptimize(handler.HandleCommand(attached_input));
+			});
+		}
+
+		// every short name on one bool option, set through a single bundled token or one token each
+		{
+			CommandTemplate bool_template{};
+			for (const char short_name : kShortNames) {
+				CommandOption option{};
+				option(value::ValueType::kBool);
+				option.short_name = short_name;
+				bool_template.options.emplace("bool_" + std::string{ short_name }, std::move(option));
+			}
+
+			CommandHandler handler{};
+			handler.GetCommandNode().AddNode("cmd", std::move(bool_template),
+				[](const ExecutionContext& ctx) { return static_cast<int>(ctx.options.size()); });
+			handler.Freeze();
+
+			const std::vector<std::string> bundled_input{ "cmd", "-" + std::string{ kShortNames } };
+			std::vector<std::string> separate_input{ "cmd" };
+			for (const char short_name : kShortNames) {
+				separate_input.push_back("-" + std::string{ short_name });
+				separate_input.push_back("true");
+			}
+
+			runner.Run("options/bundled/52_bools", [&] {
+				DoNotOptimize(handler.HandleCommand(bundled_input));
+			});
+			runner.Run("options/separate/52_bools", [&] {
+				DoNotOptimize(handler.HandleCommand(separate_input));
+			});
+		}
+
+		// argument lists mixing flags, options and extra positionals, as long scripted invocations produce
+		CommandHandler wide_handler{};
+		CommandTemplate wide_template = MakeOptionTemplate(16);
+		wide_template.flags.emplace("verbose");
+		wide_template.args.emplace_back("target", value::ValueType::kString);
+		wide_handler.GetCommandNode().AddNode("cmd", std::move(wide_template),
+			[](const ExecutionContext& ctx) { return static_cast<int>(ctx.extra_args.size()); });
+		wide_handler.Freeze();
+
+		for (const std::size_t arg_count : { 8, 64, 512 }) {
+			std::vector<std::string> input{ "cmd", "-fverbose", "target" };
+			std::size_t next_option = 0;
+			for (std::size_t i = 0; input.size() < arg_count; ++i) {
+				// every option is passed once, alternating between the long and the short form
+				if (i % 2 == 0 && next_option < 16) {
+					input.push_back(next_option % 2 == 0 ?
+						"--opt" + std::to_string(next_option) : "-" + std::string{ kShortNames[next_option] });
+					input.push_back(std::to_string(++next_option));
+				}
+				else if (i % 4 == 1) {
+					input.push_back("-fverbose");
+				}
+				else {
+					input.push_back("extra" + std::to_string(i));
+				}
+			}
+
+			runner.Run("options/wide_args/" + std::to_string(arg_count) + "_tokens", [&] {
+				DoNotOptimize(wide_handler.HandleCommand(input));
+			});
+		}
+
+		// list values parsed and validated in bulk, once as a single value and once as repeats of the option.
+		// the bounds are exclusive, so they are widened past the smallest and the largest element
+		CommandHandler list_handler{};
+		CommandTemplate list_template{};
+		list_template.options.emplace("ids", CommandOption{}(value::ValueBounds{ -1, 1 << 21 }).AsList());
+		list_handler.GetCommandNode().AddNode("cmd", std::move(list_template),
+			[](const ExecutionContext& ctx) { return static_cast<int>(ctx.options.size()); });
+		list_handler.Freeze();
+
+		for (const std::size_t element_count : { 16, 1000 }) {
+			std::string joined{};
+			std::vector<std::string> repeated_input{ "cmd" };
+			for (std::size_t i = 0; i < element_count; ++i) {
+				joined += (i == 0 ? "" : ",") + std::to_string(i * 7);
+				repeated_input.push_back("--ids");
+				repeated_input.push_back(std::to_string(i * 7));
+			}
+			const std::vector<std::string> joined_input{ "cmd", "--ids", joined };
+			// a rejected list would only time the error path
+			if (list_handler.HandleCommand(joined_input) != 1 || list_handler.HandleCommand(repeated_input) != 1) {
+				throw std::logic_error("list benchmark input was rejected");
+			}
+
+			runner.Run("options/list/" + std::to_string(element_count) + "_joined", [&] {
+				DoNotOptimize(list_handler.HandleCommand(joined_input));
+			});
+			runner.Run("options/list/" + std::to_string(element_count) + "_repeated", [&] {
+				DoNotOptimize(list_handler.HandleCommand(repeated_input));
+			});
+		}
+	}
+}
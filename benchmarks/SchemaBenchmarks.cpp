@@ -0,0 +1,109 @@
+#include <array>
+#include <string>
+#include <string_view>
+
+#include "Benchmark.h"
+#include "Comad.h"
+
+namespace comad::bench {
+	using namespace comad::command;
+	using namespace std::string_view_literals;
+
+	namespace {
+		using schema::Alias;
+		using schema::Arg;
+		using schema::Cmd;
+		using schema::Exec;
+		using schema::Flag;
+		using schema::Opt;
+
+		int RunStatic(const schema::ContextOf<Cmd<"foo", Arg<"bar1", int>, Arg<"bar2", std::string>,
+			Opt<"level", float>, Opt<"mode", std::string>, Flag<"verbose">>>& ctx) {
+			return Get<"bar1">(ctx) + static_cast<int>(Get<"bar2">(ctx).size()) +
+				static_cast<int>(Get<"level">(ctx).value_or(0.0f)) + Get<"verbose">(ctx);
+		}
+
+		int RunRuntime(const ExecutionContext& ctx) {
+			const auto level = ctx.options.find("level"sv);
+			return ctx.args.find("bar1"sv)->second.GetValue<int>() +
+				static_cast<int>(ctx.args.find("bar2"sv)->second.GetStringView().size()) +
+				(level == ctx.options.end() ? 0 : static_cast<int>(level->second.GetValue<float>())) +
+				ctx.flags.find("verbose"sv)->second;
+		}
+
+		template <schema::FixedString Name>
+		using Sibling = Cmd<Name, Arg<"bar1", int>, Exec<[](const auto& ctx) { return Get<"bar1">(ctx); }>>;
+
+		// foo is declared last, so matching it passes every sibling first
+		using BenchSchema = schema::Schema<
+			Sibling<"status">, Sibling<"start">, Sibling<"stop">, Sibling<"restart">,
+			Sibling<"list">, Sibling<"show">, Sibling<"remove">,
+			Cmd<"foo", Alias<"f">, Arg<"bar1", int>, Arg<"bar2", std::string>,
+				Opt<"level", float>, Opt<"mode", std::string>, Flag<"verbose">, Exec<RunStatic>>>;
+
+		void BuildRuntimeTree(CommandNode& root) {
+			for (const std::string_view name : { "status"sv, "start"sv, "stop"sv, "restart"sv, "list"sv, "show"sv, "remove"sv }) {
+				CommandTemplate sibling{};
+				sibling.args.emplace_back("bar1", value::ValueType::kInt);
+				root.AddNode(name, std::move(sibling), [](const ExecutionContext& ctx) {
+					return ctx.args.find("bar1"sv)->second.GetValue<int>();
+				});
+			}
+
+			CommandTemplate foo{};
+			foo.aliases.emplace("f");
+			foo.args.emplace_back("bar1", value::ValueType::kInt);
+			foo.args.emplace_back("bar2", value::ValueType::kString);
+			foo.options.emplace("level", CommandOption{ value::SupportedValueHolder{ value::ValueType::kFloat }, 'l' });
+			foo.options.emplace("mode", CommandOption{ value::SupportedValueHolder{ value::ValueType::kString }, 'm' });
+			foo.flags.emplace("verbose");
+			root.AddNode("foo", std::move(foo), RunRuntime);
+		}
+	}
+
+	void RunSchemaBenchmarks(BenchmarkRunner& runner) {
+		const std::array input{ "foo"sv, "3"sv, "name"sv, "--level"sv, "2.5"sv, "-m"sv, "fast"sv, "-fverbose"sv };
+		const std::array first_input{ "status"sv, "3"sv };
+
+		CommandHandler runtime{};
+		BuildRuntimeTree(runtime.GetCommandNode());
+
+		CommandHandler frozen{};
+		BuildRuntimeTree(frozen.GetCommandNode());
+		frozen.Freeze();
+
+		// the static commands as runtime nodes, each call converts the runtime context to the typed one
+		CommandHandler installed{};
+		BenchSchema::Install(installed.GetCommandNode());
+		installed.Freeze();
+
+		runner.Run("schema/runtime/foo", [&] {
+			DoNotOptimize(runtime.HandleCommand(input));
+		});
+		runner.Run("schema/frozen/foo", [&] {
+			DoNotOptimize(frozen.HandleCommand(input));
+		});
+		runner.Run("schema/installed/foo", [&] {
+			DoNotOptimize(installed.HandleCommand(input));
+		});
+		runner.Run("schema/static/foo", [&] {
+			DoNotOptimize(BenchSchema::HandleCommand(input));
+		});
+
+		runner.Run("schema/frozen/first_sibling", [&] {
+			DoNotOptimize(frozen.HandleCommand(first_input));
+		});
+		runner.Run("schema/static/first_sibling", [&] {
+			DoNotOptimize(BenchSchema::HandleCommand(first_input));
+		});
+
+		// runtime commands reached through a schema pay for the failed static match first
+		const std::array fallback_input{ "dynamic"sv, "3"sv };
+		frozen.Thaw();
+		frozen.GetCommandNode() >> "dynamic"sv = [](const ExecutionContext&) { return 0; };
+		frozen.Freeze();
+		runner.Run("schema/fallback/dynamic", [&] {
+			DoNotOptimize(BenchSchema::HandleCommand(frozen, fallback_input));
+		});
+	}
+}
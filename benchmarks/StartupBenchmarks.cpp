@@ -0,0 +1,127 @@
+#include <array>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Comad.h"
+
+namespace comad::bench {
+	using namespace comad::command;
+	using namespace comad::literals;
+	using namespace std::string_view_literals;
+
+	namespace {
+		constexpr std::size_t kGroupSize = 100;
+
+		struct GeneratedCommand {
+			std::string group;
+			std::string name;
+			std::array<std::string, 2> aliases;
+		};
+
+		// generated commands in groups of kGroupSize, like the subcommands of generated tooling
+		std::vector<GeneratedCommand> GenerateCommands(std::size_t count) {
+			std::vector<GeneratedCommand> commands{};
+			commands.reserve(count);
+			for (std::size_t i = 0; i < count; ++i) {
+				const std::string index = std::to_string(i);
+				commands.push_back(GeneratedCommand{ "group" + std::to_string(i / kGroupSize), "command" + index,
+					{ "c" + index, "cmd" + index } });
+			}
+			return commands;
+		}
+
+		// binds the executors through registry instead, so the tree can be written as an image
+		void Register(CommandNode& root, const std::vector<GeneratedCommand>& commands, bool grouped = true,
+		              const ExecutorRegistry* registry = nullptr) {
+			for (const GeneratedCommand& command : commands) {
+				CommandNode& node = grouped ? root >> command.group >> command.name : root >> command.name;
+				node | command.aliases[0] | command.aliases[1];
+				node("target"_as, "count"_o(value::ValueType::kInt), "mode"_o(value::ValueType::kString)[true]);
+				node("verbose"_fl, "level"_o(value::ValueBounds{ 0, 10 }));
+				if (registry != nullptr) {
+					registry->Bind(node, "generated"sv);
+				}
+				else {
+					node = [](const ExecutionContext&) { return 0; };
+				}
+			}
+		}
+	}
+
+	void RunStartupBenchmarks(BenchmarkRunner& runner) {
+		// reported per registered command, including the destruction of the tree
+		for (const std::size_t count : std::array<std::size_t, 3>{ 1'000, 10'000, 100'000 }) {
+			const std::vector<GeneratedCommand> commands = GenerateCommands(count);
+			const std::string suffix = std::to_string(count);
+
+			auto run = [&](std::string_view name, bool grouped, bool batched, bool freeze) {
+				runner.Run("startup/" + std::string{ name } + "/" + suffix, [&] {
+					CommandHandler handler{};
+					if (batched) {
+						CommandBatch batch{ handler.GetCommandNode() };
+						Register(handler.GetCommandNode(), commands, grouped);
+					}
+					else {
+						Register(handler.GetCommandNode(), commands, grouped);
+					}
+					if (freeze) {
+						handler.Freeze();
+					}
+					DoNotOptimize(&handler);
+				}, count);
+			};
+
+			run("register", true, false, false);
+			run("batch", true, true, false);
+			run("register_freeze", true, false, true);
+			run("batch_freeze", true, true, true);
+			// every command directly under the root, so the root indexes the aliases of all of them
+			run("register_flat", false, false, false);
+			run("batch_flat", false, true, false);
+		}
+
+		// what a short lived process pays before its command runs: building and freezing the tree,
+		// or mapping an image of it. reported per process start, with one dispatch each
+		ExecutorRegistry registry{};
+		registry.Register("generated", [](const ExecutionContext&) { return 0; });
+
+		for (const std::size_t count : std::array<std::size_t, 3>{ 1'000, 10'000, 100'000 }) {
+			const std::vector<GeneratedCommand> commands = GenerateCommands(count);
+			const std::string suffix = std::to_string(count);
+			const GeneratedCommand& last = commands.back();
+			const std::array<std::string_view, 7> input{ last.group, last.aliases[1], "target"sv,
+				"--mode"sv, "fast"sv, "--count"sv, "3"sv };
+
+			runner.Run("startup/cold_build/" + suffix, [&] {
+				CommandHandler handler{};
+				{
+					CommandBatch batch{ handler.GetCommandNode() };
+					Register(handler.GetCommandNode(), commands);
+				}
+				handler.Freeze();
+				DoNotOptimize(handler.HandleCommand(input));
+			});
+
+			const std::filesystem::path image_file =
+				std::filesystem::temp_directory_path() / ("comad_startup_" + suffix + ".image");
+			{
+				CommandNode root{};
+				{
+					CommandBatch batch{ root };
+					Register(root, commands, true, &registry);
+				}
+				CommandImage::Save(root, image_file);
+			}
+
+			runner.Run("startup/cold_image/" + suffix, [&] {
+				const CommandImage image{ image_file, registry };
+				DoNotOptimize(image.HandleCommand(input));
+			});
+
+			std::filesystem::remove(image_file);
+		}
+	}
+}
@@ -0,0 +1,124 @@
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Comad.h"
+
+namespace comad::bench {
+	using namespace comad::command;
+	using namespace comad::literals;
+	using namespace std::string_view_literals;
+	using namespace std::string_literals;
+
+	namespace {
+		constexpr std::size_t kLineCount = 100'000;
+
+		std::string MakeScript() {
+			std::string script{};
+			for (std::size_t i = 0; i < kLineCount; ++i) {
+				switch (i % 4) {
+					case 0: script += "deploy service" + std::to_string(i % 16) + " --replicas 4 -fforce\n"; break;
+					case 1: script += "deploy service" + std::to_string(i % 16) + " --replicas 8 -m safe\n"; break;
+					case 2: script += "config set 'log level' \"verbose output\"\n"; break;
+					default: script += "# comment\n"; break;
+				}
+			}
+			return script;
+		}
+
+		// what callers had to do before HandleStream existed
+		std::size_t NaiveSplitAndDispatch(const CommandHandler& handler, std::istream& stream) {
+			std::size_t handled = 0;
+			std::vector<std::string> tokens{};
+			for (std::string line; std::getline(stream, line);) {
+				if (line.empty() || line.starts_with('#')) {
+					continue;
+				}
+
+				tokens.clear();
+				std::istringstream line_stream{ line };
+				for (std::string token; line_stream >> token;) {
+					tokens.push_back(std::move(token));
+				}
+				DoNotOptimize(handler.HandleCommand(tokens));
+				++handled;
+			}
+			return handled;
+		}
+	}
+
+	void RunStreamBenchmarks(BenchmarkRunner& runner) {
+		CommandHandler handler{};
+		(handler.GetCommandNode() >> "deploy"sv)("service"_as, "force"_fl,
+			"replicas"_o(value::ValueBounds{ 1, 64 }), "mode"_o("fast"s, "safe"s)) = [](const ExecutionContext&) {
+			return 0;
+		};
+		(handler.GetCommandNode() >> "config"sv >> "set"sv)("key"_as, "value"_as) = [](const ExecutionContext&) {
+			return 0;
+		};
+		handler.Freeze();
+
+		const std::string script = MakeScript();
+
+		runner.Run("stream/naive_split_and_dispatch", [&] {
+			std::istringstream stream{ script };
+			DoNotOptimize(NaiveSplitAndDispatch(handler, stream));
+		}, kLineCount);
+
+		runner.Run("stream/handle_stream", [&] {
+			std::istringstream stream{ script };
+			handler.HandleStream(stream, [](const LineResult& result) { DoNotOptimize(result); });
+		}, kLineCount);
+
+		const std::filesystem::path path = std::filesystem::temp_directory_path() / "comad_stream_bench.txt";
+		{
+			std::ofstream file{ path, std::ios::binary };
+			file << script;
+		}
+
+		runner.Run("stream/handle_file", [&] {
+			handler.HandleFile(path, [](const LineResult& result) { DoNotOptimize(result); });
+		}, kLineCount);
+
+		std::filesystem::remove(path);
+
+		// a response file of a million tokens, 16 to a line, with every 64th token quoted so some pages are
+		// rewritten while tokenizing
+		constexpr std::size_t kResponseTokenCount = 1'000'000;
+		const std::filesystem::path response_path = std::filesystem::temp_directory_path() / "comad_response_bench.rsp";
+		{
+			std::ofstream file{ response_path, std::ios::binary };
+			for (std::size_t i = 0; i < kResponseTokenCount; ++i) {
+				file << (i % 64 == 0 ? "'item " : "item") << i << (i % 64 == 0 ? "'" : "") << (i % 16 == 15 ? '\n' : ' ');
+			}
+		}
+
+		const std::string response_token = "@" + response_path.string();
+		const std::array response_input{ "batch"sv, std::string_view{ response_token } };
+
+		runner.Run("stream/response_file/expand_1M_tokens", [&] {
+			detail::ResponseFileExpansion expansion{};
+			int error = 0;
+			DoNotOptimize(expansion.Expand(response_input, build_options::kMaxResponseFileDepth, error));
+			DoNotOptimize(expansion.Get().size());
+		}, kResponseTokenCount);
+
+		CommandHandler response_handler{};
+		(response_handler.GetCommandNode() >> "batch"sv) = [](const ExecutionContext& ctx) {
+			return static_cast<int>(ctx.extra_args.size());
+		};
+		response_handler.EnableResponseFiles();
+		response_handler.Freeze();
+
+		runner.Run("stream/response_file/dispatch_1M_tokens", [&] {
+			DoNotOptimize(response_handler.HandleCommand(response_input));
+		}, kResponseTokenCount);
+
+		std::filesystem::remove(response_path);
+	}
+}
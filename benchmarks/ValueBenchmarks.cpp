@@ -0,0 +1,100 @@
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Comad.h"
+
+namespace comad::bench {
+	using namespace comad::command;
+	using namespace comad::value;
+	using namespace std::string_view_literals;
+
+	namespace {
+		template <typename T>
+		std::vector<T> MakeValues(std::size_t count, std::size_t stride) {
+			std::vector<T> values{};
+			for (std::size_t i = 0; i < count; ++i) {
+				if constexpr (std::is_same_v<T, std::string>) {
+					values.push_back("value" + std::to_string(i));
+				}
+				else {
+					values.push_back(static_cast<T>(i * stride));
+				}
+			}
+			return values;
+		}
+
+		// values stride apart, ints far apart are kept sorted instead of in a bitset
+		template <typename T>
+		void RunListValidation(BenchmarkRunner& runner, std::string_view type_name, std::size_t stride = 3) {
+			for (const std::size_t count : { 4, 64, 1024, 10000 }) {
+				const std::vector<T> values = MakeValues<T>(count, stride);
+				const SupportedValueHolder holder{ values };
+
+				std::size_t cursor = 0;
+				runner.Run("values/validate/list_" + std::string{ type_name } + "_" + std::to_string(count), [&] {
+					// alternate hits and misses
+					const std::size_t index = cursor++ % count;
+					if constexpr (std::is_same_v<T, std::string>) {
+						DoNotOptimize(holder.IsValid(index % 2 == 0 ? values[index] : values[index] + "x"));
+					}
+					else {
+						DoNotOptimize(holder.IsValid(static_cast<T>(values[index] + static_cast<T>(index % 2))));
+					}
+				});
+			}
+		}
+	}
+
+	void RunValueBenchmarks(BenchmarkRunner& runner) {
+		struct ParseInput {
+			ValueType type;
+			std::string_view label;
+			std::string_view text;
+		};
+
+		const std::array inputs{
+			ParseInput{ ValueType::kBool, "lower", "true"sv },
+			ParseInput{ ValueType::kBool, "upper", "FALSE"sv },
+			ParseInput{ ValueType::kInt, "six_digits", "-123456"sv },
+			ParseInput{ ValueType::kFloat, "six_digits", "3.14159"sv },
+			ParseInput{ ValueType::kInt64, "id", "1099511627776"sv },
+			ParseInput{ ValueType::kDouble, "six_digits", "3.14159"sv },
+			ParseInput{ ValueType::kByteSize, "binary", "64MiB"sv },
+			ParseInput{ ValueType::kDuration, "compound", "1h30m"sv },
+			ParseInput{ ValueType::kString, "small", "short"sv },
+			ParseInput{ ValueType::kString, "heap", "a string long enough to leave the small buffer"sv }
+		};
+
+		for (const ParseInput& input : inputs) {
+			const std::string name = "values/parse/" + std::string{ ValueTypeNames.at(input.type) } + "_" + std::string{ input.label };
+			runner.Run(name, [&] {
+				DoNotOptimize(detail::StringToValue(input.type, input.text));
+			});
+		}
+
+		const SupportedValueHolder type_holder{ ValueType::kInt };
+		const SupportedValueHolder int_bounds{ ValueBounds{ 0, 1000 } };
+		const SupportedValueHolder float_bounds{ ValueBounds{ 0.0f, 1.0f } };
+
+		int int_value = 0;
+		runner.Run("values/validate/type_int", [&] {
+			DoNotOptimize(type_holder.IsValid(++int_value));
+		});
+		runner.Run("values/validate/bounds_int", [&] {
+			DoNotOptimize(int_bounds.IsValid(++int_value % 2000));
+		});
+		float float_value = 0.0f;
+		runner.Run("values/validate/bounds_float", [&] {
+			float_value = float_value > 2.0f ? 0.0f : float_value + 0.1f;
+			DoNotOptimize(float_bounds.IsValid(float_value));
+		});
+
+		RunListValidation<int>(runner, "int");
+		RunListValidation<int>(runner, "int_sparse", 1000);
+		RunListValidation<float>(runner, "float");
+		RunListValidation<std::string>(runner, "string");
+	}
+}
@@ -6,11 +6,25 @@
 #include "CommandLiterals.h"
 #include "CommandNode.h"
 #include "CommandHandler.h"
+#include "CommandImage.h"
+#include "CommandMetrics.h"
+#include "CommandTrace.h"
+#include "CommandTask.h"
+#include "CompiledCommandTree.h"
+#include "CompletionIndex.h"
 #include "Logger.h"
+#include "RingBuffer.h"
+#include "ResultCache.h"
+#include "Schema.h"
 #include "StringUtility.h"
+#include "SuggestionIndex.h"
+#include "ThreadPool.h"
+#include "TokenTable.h"
+#include "TreeSnapshot.h"
 #include "TypeTraits.h"
 #include "Utility.h"
 #include "Value.h"
 #include "ValueUtility.h"
+#include "ValueValidator.h"
 
 #endif
\ No newline at end of file
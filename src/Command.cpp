@@ -1,4 +1,12 @@
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
 #include "Command.h"
+#include "StringUtility.h"
 
 namespace comad::command {
 	using namespace value;
@@ -10,6 +18,10 @@ namespace comad::command {
 	}
 
 	CommandOption& CommandOption::operator()(ValueType type) noexcept {
+		if (IsListType(type)) {
+			type = ElementType(type);
+			list = true;
+		}
 		supported_values = SupportedValueHolder(type);
 
 		return *this;
@@ -19,4 +31,204 @@ namespace comad::command {
 
 		return *this;
 	}
+
+	CommandOption& CommandOption::AsList() {
+		const ValueType type = supported_values.GetValueType();
+		if (type != ValueType::kUnknown && ListOf(type) == ValueType::kUnknown) {
+			throw std::invalid_argument(std::string{ ValueTypeNames.at(type) } + " values cannot be listed");
+		}
+		list = true;
+
+		return *this;
+	}
+
+	ValueType CommandOption::GetValueType() const noexcept {
+		const ValueType type = supported_values.GetValueType();
+		return list ? ListOf(type) : type;
+	}
+
+	void SlotLayout::Assign(std::vector<std::string_view> slot_names) {
+		names = std::move(slot_names);
+
+		sorted_slots.resize(names.size());
+		std::iota(sorted_slots.begin(), sorted_slots.end(), 0u);
+		std::ranges::stable_sort(sorted_slots, std::less<>{}, [this](std::uint32_t slot) { return names[slot]; });
+
+		length_mask = 0;
+		for (std::string_view slot_name : names) {
+			length_mask |= LengthBit(slot_name.size());
+		}
+	}
+
+	std::size_t SlotLayout::Find(std::string_view name) const noexcept {
+		// most misses are positionals whose length no slot name has
+		if ((length_mask & LengthBit(name.size())) == 0) {
+			return kNoSlot;
+		}
+
+		auto it = std::ranges::lower_bound(sorted_slots, name, std::less<>{},
+			[this](std::uint32_t slot) { return names[slot]; });
+
+		if (it == sorted_slots.end() || names[*it] != name) {
+			return kNoSlot;
+		}
+		return *it;
+	}
+
+	void OptionTable::Assign(const std::map<std::string, CommandOption, std::less<>>& options) {
+		descriptors_.clear();
+		descriptors_.reserve(options.size());
+		short_index_.fill(0);
+
+		// at most half full, so probe sequences stay short
+		std::size_t index_size = 1;
+		while (index_size < options.size() * 2) {
+			index_size <<= 1;
+		}
+		long_index_.assign(index_size, kEmpty);
+
+		for (const auto& [name, option] : options) {
+			const auto index = static_cast<std::uint32_t>(descriptors_.size());
+			const OptionDescriptor& descriptor = descriptors_.emplace_back(OptionDescriptor{
+				.name = name,
+				.hash = utility::HashString(name),
+				.option = &option,
+				.slot = index
+			});
+
+			// the first option claiming a short name keeps it
+			std::uint32_t& short_entry = short_index_[static_cast<unsigned char>(option.short_name)];
+			if (option.short_name != 0 && short_entry == 0) {
+				short_entry = index + 1;
+			}
+
+			std::size_t bucket = descriptor.hash & (index_size - 1);
+			while (long_index_[bucket] != kEmpty) {
+				bucket = (bucket + 1) & (index_size - 1);
+			}
+			long_index_[bucket] = index;
+		}
+	}
+
+	const OptionDescriptor* OptionTable::FindLong(std::string_view name) const noexcept {
+		if (descriptors_.empty()) {
+			return nullptr;
+		}
+
+		const std::uint64_t hash = utility::HashString(name);
+		const std::size_t mask = long_index_.size() - 1;
+		for (std::size_t bucket = hash & mask; long_index_[bucket] != kEmpty; bucket = (bucket + 1) & mask) {
+			const OptionDescriptor& descriptor = descriptors_[long_index_[bucket]];
+			if (descriptor.hash == hash && descriptor.name == name) {
+				return &descriptor;
+			}
+		}
+		return nullptr;
+	}
+
+	const OptionDescriptor* OptionTable::FindShort(char short_name) const noexcept {
+		const std::uint32_t entry = short_index_[static_cast<unsigned char>(short_name)];
+		return entry == 0 ? nullptr : &descriptors_[entry - 1];
+	}
+
+	const OptionDescriptor* OptionTable::At(std::size_t slot) const noexcept {
+		return slot < descriptors_.size() ? &descriptors_[slot] : nullptr;
+	}
+
+	std::size_t OptionTable::GetSize() const noexcept {
+		return descriptors_.size();
+	}
+
+	void ExecutionContext::Bind(const ContextLayout& layout) {
+		required_option_count = 0;
+		options.Bind(layout.options);
+		flags.Bind(layout.flags);
+		flags.Fill(false);
+		args.Bind(layout.args);
+		extra_args.clear();
+	}
+
+	std::vector<std::string> ExecutionContext::MaterializeExtraArgs() const {
+		return std::vector<std::string>(extra_args.begin(), extra_args.end());
+	}
+
+	CommandExecutor::CommandExecutor(std::nullptr_t) noexcept {}
+
+	CommandExecutor::CommandExecutor(const CommandExecutor& other) :
+		invoke_{ other.invoke_ },
+		start_{ other.start_ },
+		operations_{ other.operations_ }
+	{
+		if (operations_ != nullptr) {
+			operations_->copy(storage_, other.storage_);
+		}
+		else {
+			std::memcpy(storage_, other.storage_, kBufferSize);
+		}
+	}
+
+	CommandExecutor::CommandExecutor(CommandExecutor&& other) noexcept :
+		invoke_{ other.invoke_ },
+		start_{ other.start_ },
+		operations_{ other.operations_ }
+	{
+		if (operations_ != nullptr) {
+			operations_->move(storage_, other.storage_);
+		}
+		else {
+			std::memcpy(storage_, other.storage_, kBufferSize);
+		}
+
+		other.Reset();
+	}
+
+	CommandExecutor& CommandExecutor::operator=(const CommandExecutor& other) {
+		if (this != &other) {
+			*this = CommandExecutor{ other };
+		}
+
+		return *this;
+	}
+
+	CommandExecutor& CommandExecutor::operator=(CommandExecutor&& other) noexcept {
+		if (this != &other) {
+			Reset();
+			invoke_ = other.invoke_;
+			start_ = other.start_;
+			operations_ = other.operations_;
+
+			if (operations_ != nullptr) {
+				operations_->move(storage_, other.storage_);
+			}
+			else {
+				std::memcpy(storage_, other.storage_, kBufferSize);
+			}
+
+			other.Reset();
+		}
+
+		return *this;
+	}
+
+	CommandExecutor::~CommandExecutor() {
+		Reset();
+	}
+
+	void CommandExecutor::Reset() noexcept {
+		if (operations_ != nullptr) {
+			operations_->destroy(storage_);
+		}
+
+		invoke_ = nullptr;
+		start_ = nullptr;
+		operations_ = nullptr;
+	}
+
+	CommandTask CommandExecutor::Start(const ExecutionContext& ctx) const {
+		if (start_ == nullptr) {
+			throw std::bad_function_call{};
+		}
+
+		return start_(storage_, ctx);
+	}
 }
@@ -1,12 +1,24 @@
 #ifndef COMAD_COMMAND_H_
 #define COMAD_COMMAND_H_
 
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
 #include <map>
+#include <new>
 #include <set>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include <ComadBuildOptions.h>
+
+#include "CommandTask.h"
 #include "ValueUtility.h"
 
 namespace comad::command {
@@ -14,14 +26,23 @@ namespace comad::command {
 		value::SupportedValueHolder supported_values{ };
 		char short_name{ 0 };
 		bool required{ false };
+		// the value is a list of elements the supported values are checked against, repeats append to it
+		bool list{ false };
 
 		CommandOption& operator[](bool is_required) noexcept;
+		// a list type makes a list option of its element type
 		CommandOption& operator()(value::ValueType type) noexcept;
 		CommandOption& operator()(value::ValueBounds bounds) noexcept;
 		CommandOption& operator()(value::ValueRange auto&& values);
 
-		template <value::ValidType T, value::ValidType... TOthers> requires (std::conjunction_v<std::is_same<T, TOthers>...>)
+		template <value::ScalarValueType T, value::ScalarValueType... TOthers> requires (std::conjunction_v<std::is_same<T, TOthers>...>)
 		CommandOption& operator()(T value, TOthers... others);
+
+		// throws std::invalid_argument if the supported values are of a type without a list type
+		CommandOption& AsList();
+
+		// the type the value is parsed as, the list type of the supported values for list options
+		[[nodiscard]] value::ValueType GetValueType() const noexcept;
 	};
 
 	using CommandArgument = std::pair<std::string, value::ValueType>;
@@ -35,16 +56,201 @@ namespace comad::command {
 		std::string description{ };
 	};
 
+	// results of a node with a cache policy are reused by its handler for input that parses to the
+	// same context, until ttl has passed. the default never expires, for pure commands
+	struct CachePolicy {
+		std::chrono::steady_clock::duration ttl{ std::chrono::steady_clock::duration::max() };
+	};
+
+	inline constexpr std::size_t kNoSlot = std::numeric_limits<std::size_t>::max();
+
+	struct SlotLayout {
+		std::vector<std::string_view> names{ };
+		std::vector<std::uint32_t> sorted_slots{ };
+		// bit n is set if a name of length n exists, the last bit stands for every longer length
+		std::uint64_t length_mask{ 0 };
+
+		void Assign(std::vector<std::string_view> slot_names);
+		[[nodiscard]] std::size_t Find(std::string_view name) const noexcept;
+
+		static constexpr std::uint64_t LengthBit(std::size_t length) noexcept {
+			return std::uint64_t{ 1 } << (length < 63 ? length : 63);
+		}
+	};
+
+	struct OptionDescriptor {
+		std::string_view name{ };
+		std::uint64_t hash{ 0 };
+		const CommandOption* option{ nullptr };
+		std::uint32_t slot{ 0 };
+	};
+
+	// resolves option names of a node to their descriptors. short names index a direct table and
+	// long names an open addressed hash index, descriptor slots match the node's option slots
+	class OptionTable {
+	public:
+		void Assign(const std::map<std::string, CommandOption, std::less<>>& options);
+
+		[[nodiscard]] const OptionDescriptor* FindLong(std::string_view name) const noexcept;
+		[[nodiscard]] const OptionDescriptor* FindShort(char short_name) const noexcept;
+		[[nodiscard]] const OptionDescriptor* At(std::size_t slot) const noexcept;
+		[[nodiscard]] std::size_t GetSize() const noexcept;
+
+	private:
+		static constexpr std::uint32_t kEmpty = std::numeric_limits<std::uint32_t>::max();
+
+		std::vector<OptionDescriptor> descriptors_{ };
+		// descriptor index + 1 for every char, so an unassigned table resolves nothing
+		std::array<std::uint32_t, 256> short_index_{ };
+		std::vector<std::uint32_t> long_index_{ };
+	};
+
+	struct ContextLayout {
+		SlotLayout flags{ };
+		SlotLayout options{ };
+		SlotLayout args{ };
+	};
+
+	template <typename T>
+	class SlotMap {
+	public:
+		using value_type = std::pair<std::string_view, T>;
+
+		class const_iterator {
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = SlotMap::value_type;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const value_type*;
+			using reference = const value_type&;
+
+			const_iterator() = default;
+
+			reference operator*() const;
+			pointer operator->() const;
+			const_iterator& operator++();
+			const_iterator operator++(int);
+			bool operator==(const const_iterator& other) const noexcept;
+
+		private:
+			const SlotMap* map_{ nullptr };
+			std::size_t slot_{ 0 };
+
+			const_iterator(const SlotMap* map, std::size_t slot);
+
+			void SkipAbsent();
+
+			friend class SlotMap;
+		};
+
+		void Bind(const SlotLayout& layout);
+		// moves the map over to a layout with the same names in the same slots, the values are kept
+		void Rebind(const SlotLayout& layout);
+		void Fill(const T& value);
+		void Set(std::size_t slot, T value);
+
+		[[nodiscard]] bool Has(std::size_t slot) const noexcept;
+		[[nodiscard]] const T& At(std::size_t slot) const;
+		[[nodiscard]] T& At(std::size_t slot);
+		[[nodiscard]] std::size_t GetSlotCount() const noexcept;
+		// null until the map is bound
+		[[nodiscard]] const SlotLayout* GetLayout() const noexcept;
+
+		// like std::map::at, throws std::out_of_range if name holds no value
+		[[nodiscard]] const T& at(std::string_view name) const;
+		[[nodiscard]] const_iterator find(std::string_view name) const noexcept;
+		[[nodiscard]] bool contains(std::string_view name) const noexcept;
+		[[nodiscard]] std::size_t size() const noexcept;
+		[[nodiscard]] bool empty() const noexcept;
+
+		[[nodiscard]] const_iterator begin() const noexcept;
+		[[nodiscard]] const_iterator end() const noexcept;
+
+	private:
+		const SlotLayout* layout_{ nullptr };
+		std::vector<value_type> slots_{ };
+		std::vector<bool> present_{ };
+		std::size_t present_count_{ 0 };
+	};
+
 	class ExecutionContext {
 	public:
 		int required_option_count{ };
-		std::map<std::string, value::ValueWrapper, std::less<>> options{ };
-		std::map<std::string, bool, std::less<>> flags{ };
-		std::map<std::string, value::ValueWrapper, std::less<>> args{ };
-		std::vector<std::string> extra_args{ };
+		SlotMap<value::ValueWrapper> options{ };
+		SlotMap<bool> flags{ };
+		SlotMap<value::ValueWrapper> args{ };
+		// string values and extra args refer to the dispatched input and are only valid during the
+		// executor call. copies of the value wrappers own their strings
+		std::vector<std::string_view> extra_args{ };
+
+		void Bind(const ContextLayout& layout);
+
+		[[nodiscard]] std::vector<std::string> MaterializeExtraArgs() const;
 	};
 
-	using CommandExecutor = int(*)(const ExecutionContext& info);
+	// coroutine executors return a CommandTask instead of the result
+	template <typename F>
+	concept CoroutineExecutorCallable = std::is_invocable_r_v<CommandTask, const F&, const ExecutionContext&>;
+
+	template <typename F>
+	concept ExecutorCallable = (std::is_invocable_r_v<int, const F&, const ExecutionContext&> ||
+		CoroutineExecutorCallable<F>) && std::is_copy_constructible_v<F> && std::is_nothrow_move_constructible_v<F>;
+
+	// any callable taking the execution context, stored in place. callables that do not fit into the
+	// buffer are rejected at compile time instead of being moved to the heap. dispatch is const, so
+	// the callable is invoked as const and shared state has to be captured by reference or pointer.
+	// calling a coroutine executor blocks until the coroutine has finished
+	class CommandExecutor {
+	public:
+		static constexpr std::size_t kBufferSize = build_options::kExecutorBufferSize;
+
+		CommandExecutor() noexcept = default;
+		CommandExecutor(std::nullptr_t) noexcept;
+
+		template <typename F> requires (!std::is_same_v<std::remove_cvref_t<F>, CommandExecutor> &&
+			ExecutorCallable<std::decay_t<F>>)
+		CommandExecutor(F&& callable);
+
+		CommandExecutor(const CommandExecutor& other);
+		CommandExecutor(CommandExecutor&& other) noexcept;
+		CommandExecutor& operator=(const CommandExecutor& other);
+		CommandExecutor& operator=(CommandExecutor&& other) noexcept;
+		~CommandExecutor();
+
+		int operator()(const ExecutionContext& ctx) const;
+		explicit operator bool() const noexcept;
+
+		[[nodiscard]] bool IsCoroutine() const noexcept;
+		// only for coroutine executors, the returned task has not started yet
+		[[nodiscard]] CommandTask Start(const ExecutionContext& ctx) const;
+
+	private:
+		struct Operations {
+			void (*copy)(void* destination, const void* source);
+			void (*move)(void* destination, void* source) noexcept;
+			void (*destroy)(void* storage) noexcept;
+		};
+
+		template <typename F>
+		static int Invoke(const void* storage, const ExecutionContext& ctx);
+
+		template <typename F>
+		static CommandTask StartCoroutine(const void* storage, const ExecutionContext& ctx);
+
+		template <typename F>
+		static int InvokeCoroutine(const void* storage, const ExecutionContext& ctx);
+
+		template <typename F>
+		static const Operations kOperations;
+
+		alignas(std::max_align_t) std::byte storage_[kBufferSize]{ };
+		int (*invoke_)(const void* storage, const ExecutionContext& ctx){ nullptr };
+		CommandTask (*start_)(const void* storage, const ExecutionContext& ctx){ nullptr };
+		// null for trivially copyable callables, those are copied bytewise and never destroyed
+		const Operations* operations_{ nullptr };
+
+		void Reset() noexcept;
+	};
 }
 
 #include "Command.tcc"
@@ -1,8 +1,13 @@
 #ifndef COMAD_COMMAND_TCC_
 #define COMAD_COMMAND_TCC_
 
+#include <functional>
+#include <new>
 #include <set>
+#include <stdexcept>
+#include <string>
 #include <type_traits>
+#include <utility>
 
 #include "Command.h"
 
@@ -13,12 +18,249 @@ namespace comad::command {
 		return *this;
 	}
 
-	template<value::ValidType T, value::ValidType ...TOthers> requires (std::conjunction_v<std::is_same<T, TOthers>...>)
+	template<value::ScalarValueType T, value::ScalarValueType ...TOthers> requires (std::conjunction_v<std::is_same<T, TOthers>...>)
 	CommandOption& CommandOption::operator()(T value, TOthers ...others) {
 		supported_values = value::SupportedValueHolder{ std::set{ { value, std::forward<TOthers>(others)... } } };
 
 		return *this;
 	}
+
+	template <typename T>
+	SlotMap<T>::const_iterator::const_iterator(const SlotMap* map, std::size_t slot) :
+		map_{ map },
+		slot_{ slot }
+	{
+		SkipAbsent();
+	}
+
+	template <typename T>
+	auto SlotMap<T>::const_iterator::operator*() const -> reference {
+		return map_->slots_[slot_];
+	}
+
+	template <typename T>
+	auto SlotMap<T>::const_iterator::operator->() const -> pointer {
+		return &map_->slots_[slot_];
+	}
+
+	template <typename T>
+	auto SlotMap<T>::const_iterator::operator++() -> const_iterator& {
+		++slot_;
+		SkipAbsent();
+
+		return *this;
+	}
+
+	template <typename T>
+	auto SlotMap<T>::const_iterator::operator++(int) -> const_iterator {
+		const_iterator copy{ *this };
+		++*this;
+
+		return copy;
+	}
+
+	template <typename T>
+	bool SlotMap<T>::const_iterator::operator==(const const_iterator& other) const noexcept {
+		return slot_ == other.slot_;
+	}
+
+	template <typename T>
+	void SlotMap<T>::const_iterator::SkipAbsent() {
+		while (slot_ < map_->slots_.size() && !map_->present_[slot_]) {
+			++slot_;
+		}
+	}
+
+	template <typename T>
+	void SlotMap<T>::Bind(const SlotLayout& layout) {
+		layout_ = &layout;
+
+		// resizing within the previous capacity keeps a reused context free of allocations
+		slots_.resize(layout.names.size());
+		present_.assign(layout.names.size(), false);
+		present_count_ = 0;
+
+		for (std::size_t slot = 0; slot < slots_.size(); ++slot) {
+			slots_[slot].first = layout.names[slot];
+		}
+	}
+
+	template <typename T>
+	void SlotMap<T>::Rebind(const SlotLayout& layout) {
+		layout_ = &layout;
+		for (std::size_t slot = 0; slot < slots_.size(); ++slot) {
+			slots_[slot].first = layout.names[slot];
+		}
+	}
+
+	template <typename T>
+	void SlotMap<T>::Fill(const T& value) {
+		for (value_type& slot : slots_) {
+			slot.second = value;
+		}
+		present_.assign(slots_.size(), true);
+		present_count_ = slots_.size();
+	}
+
+	template <typename T>
+	void SlotMap<T>::Set(std::size_t slot, T value) {
+		slots_[slot].second = std::move(value);
+		if (!present_[slot]) {
+			present_[slot] = true;
+			++present_count_;
+		}
+	}
+
+	template <typename T>
+	bool SlotMap<T>::Has(std::size_t slot) const noexcept {
+		return slot < present_.size() && present_[slot];
+	}
+
+	template <typename T>
+	const T& SlotMap<T>::At(std::size_t slot) const {
+		if (!Has(slot)) {
+			throw std::out_of_range("slot does not hold a value");
+		}
+		return slots_[slot].second;
+	}
+
+	template <typename T>
+	T& SlotMap<T>::At(std::size_t slot) {
+		return const_cast<T&>(std::as_const(*this).At(slot));
+	}
+
+	template <typename T>
+	std::size_t SlotMap<T>::GetSlotCount() const noexcept {
+		return slots_.size();
+	}
+
+	template <typename T>
+	const SlotLayout* SlotMap<T>::GetLayout() const noexcept {
+		return layout_;
+	}
+
+	template <typename T>
+	const T& SlotMap<T>::at(std::string_view name) const {
+		const const_iterator it = find(name);
+		if (it == end()) {
+			throw std::out_of_range("no value for " + std::string{ name });
+		}
+		return it->second;
+	}
+
+	template <typename T>
+	auto SlotMap<T>::find(std::string_view name) const noexcept -> const_iterator {
+		if (layout_ == nullptr) {
+			return end();
+		}
+
+		const std::size_t slot = layout_->Find(name);
+		if (slot == kNoSlot || !present_[slot]) {
+			return end();
+		}
+		return const_iterator{ this, slot };
+	}
+
+	template <typename T>
+	bool SlotMap<T>::contains(std::string_view name) const noexcept {
+		return find(name) != end();
+	}
+
+	template <typename T>
+	std::size_t SlotMap<T>::size() const noexcept {
+		return present_count_;
+	}
+
+	template <typename T>
+	bool SlotMap<T>::empty() const noexcept {
+		return present_count_ == 0;
+	}
+
+	template <typename T>
+	auto SlotMap<T>::begin() const noexcept -> const_iterator {
+		return const_iterator{ this, 0 };
+	}
+
+	template <typename T>
+	auto SlotMap<T>::end() const noexcept -> const_iterator {
+		return const_iterator{ this, slots_.size() };
+	}
+
+	template <typename F> requires (!std::is_same_v<std::remove_cvref_t<F>, CommandExecutor> &&
+		ExecutorCallable<std::decay_t<F>>)
+	CommandExecutor::CommandExecutor(F&& callable) {
+		using callable_type = std::decay_t<F>;
+
+		static_assert(sizeof(callable_type) <= kBufferSize,
+			"the executor does not fit into the inline buffer, capture less or raise COMAD_EXECUTOR_BUFFER_SIZE");
+		static_assert(alignof(callable_type) <= alignof(std::max_align_t),
+			"the executor is aligned stricter than the inline buffer");
+
+		// a null function pointer is an empty executor, the same as before executors could capture
+		if constexpr (std::is_pointer_v<callable_type> || std::is_member_pointer_v<callable_type>) {
+			if (callable == nullptr) {
+				return;
+			}
+		}
+
+		::new (static_cast<void*>(storage_)) callable_type(std::forward<F>(callable));
+		if constexpr (CoroutineExecutorCallable<callable_type>) {
+			invoke_ = &InvokeCoroutine<callable_type>;
+			start_ = &StartCoroutine<callable_type>;
+		}
+		else {
+			invoke_ = &Invoke<callable_type>;
+		}
+
+		if constexpr (!std::is_trivially_copyable_v<callable_type> || !std::is_trivially_destructible_v<callable_type>) {
+			operations_ = &kOperations<callable_type>;
+		}
+	}
+
+	// defined here instead of the source file, so calls through a node's executor are a single indirect call
+	inline int CommandExecutor::operator()(const ExecutionContext& ctx) const {
+		if (invoke_ == nullptr) [[unlikely]] {
+			throw std::bad_function_call{};
+		}
+
+		return invoke_(storage_, ctx);
+	}
+
+	inline CommandExecutor::operator bool() const noexcept {
+		return invoke_ != nullptr;
+	}
+
+	inline bool CommandExecutor::IsCoroutine() const noexcept {
+		return start_ != nullptr;
+	}
+
+	template <typename F>
+	int CommandExecutor::Invoke(const void* storage, const ExecutionContext& ctx) {
+		return std::invoke(*std::launder(static_cast<const F*>(storage)), ctx);
+	}
+
+	template <typename F>
+	CommandTask CommandExecutor::StartCoroutine(const void* storage, const ExecutionContext& ctx) {
+		return std::invoke(*std::launder(static_cast<const F*>(storage)), ctx);
+	}
+
+	template <typename F>
+	int CommandExecutor::InvokeCoroutine(const void* storage, const ExecutionContext& ctx) {
+		return StartCoroutine<F>(storage, ctx).Wait();
+	}
+
+	template <typename F>
+	const CommandExecutor::Operations CommandExecutor::kOperations{
+		[](void* destination, const void* source) {
+			::new (destination) F(*std::launder(static_cast<const F*>(source)));
+		},
+		[](void* destination, void* source) noexcept {
+			::new (destination) F(std::move(*std::launder(static_cast<F*>(source))));
+		},
+		[](void* storage) noexcept {
+			std::launder(static_cast<F*>(storage))->~F();
+		}
+	};
 }
 
 #endif
\ No newline at end of file
@@ -1,16 +1,40 @@
 #include "CommandHandler.h"
 
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <coroutine>
+#include <exception>
+#include <filesystem>
 #include <format>
+#include <fstream>
+#include <istream>
+#include <limits>
+#include <memory>
 #include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <system_error>
 #include <optional>
 #include <Logger.tcc>
 #include <utility>
+#include <vector>
 
 #include "ComadBuildOptions.h"
 
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define COMAD_HAS_MMAP 1
+#else
+#define COMAD_HAS_MMAP 0
+#endif
+
 using namespace std::string_view_literals;
 
 namespace comad::command {
@@ -18,43 +42,38 @@ namespace comad::command {
 	using namespace logger;
 
 	bool detail::IsValueValid(const CommandOption& option, const ValueWrapper& value) {
-		const ValueType type = option.supported_values.GetValueType();
-		if (type != value.GetType()) return false;
+		return option.supported_values.IsValid(value);
+	}
 
-		switch (type)
-		{
-			case ValueType::kBool: return option.supported_values.IsValid(value.GetValue<bool>());
-			case ValueType::kInt: return option.supported_values.IsValid(value.GetValue<int>());
-			case ValueType::kFloat: return option.supported_values.IsValid(value.GetValue<float>());
-			case ValueType::kString: return option.supported_values.IsValid(value.GetValue<std::string>());
-			default: throw std::runtime_error{ "type is not supported." };
+	namespace {
+		template <ListValueType T>
+		std::optional<ValueWrapper> ParseList(std::string_view str) {
+			// string elements refer to the caller's input the same as a single string does
+			ValueWrapper list{ T{} };
+			if (!detail::AppendList(list.GetValue<T>(), str)) {
+				return std::nullopt;
+			}
+			return std::make_optional(std::move(list));
 		}
 	}
 
 	std::optional<ValueWrapper> detail::StringToValue(ValueType type, std::string_view str) {
 		using namespace build_options;
 
-		if (Verbose) {
-			comad_logger.MakeStream<LogLevel::DEBUG>()
-				<< "trying to parse " << ValueTypeNames.at(type) << " from " << str;
-		}
+		LogDebug("trying to parse ", [type] { return ValueTypeNames.at(type); }, " from ", str);
 		switch (type)
 		{
 			case ValueType::kBool: {
-				std::string value_str_copy{ str };
-				std::ranges::transform(value_str_copy, value_str_copy.begin(),
-				                       [](unsigned char c) { return std::tolower(c);  });
+				using utility::EqualsIgnoreCase;
 
-				if (value_str_copy == "0"sv || value_str_copy == "false"sv) {
+				if (str == "0"sv || EqualsIgnoreCase(str, "false"sv)) {
 					return std::make_optional<ValueWrapper>(false);
 				}
-				if (value_str_copy == "1"sv || value_str_copy == "true"sv) {
+				if (str == "1"sv || EqualsIgnoreCase(str, "true"sv)) {
 					return std::make_optional<ValueWrapper>(true);
 				}
 
-				if constexpr (Verbose) {
-					comad_logger.MakeStream<LogLevel::ERROR>() << str << " cannot be converted to bool";
-				}
+				LogError(str, " cannot be converted to bool");
 				return std::nullopt;
 			}
 			case ValueType::kInt: {
@@ -69,43 +88,204 @@ namespace comad::command {
 				if (val == std::nullopt) return std::nullopt;
 				return std::make_optional<ValueWrapper>(val.value());
 			}
-			case ValueType::kString: return std::make_optional<ValueWrapper>(std::string{ str });
+			// the value refers to the caller's input, it is only copied if the executor asks for a std::string
+			case ValueType::kString: return std::make_optional(ValueWrapper::Borrow(str));
+			case ValueType::kInt64: {
+				auto val = OptionalFromChars<std::int64_t>(str);
+
+				if (val == std::nullopt) return std::nullopt;
+				return std::make_optional<ValueWrapper>(val.value());
+			}
+			case ValueType::kUInt64: {
+				auto val = OptionalFromChars<std::uint64_t>(str);
+
+				if (val == std::nullopt) return std::nullopt;
+				return std::make_optional<ValueWrapper>(val.value());
+			}
+			case ValueType::kDouble: {
+				auto val = OptionalFromChars<double>(str);
+
+				if (val == std::nullopt) return std::nullopt;
+				return std::make_optional<ValueWrapper>(val.value());
+			}
+			case ValueType::kByteSize: {
+				auto val = ParseByteSize(str);
+
+				if (val == std::nullopt) return std::nullopt;
+				return std::make_optional<ValueWrapper>(val.value());
+			}
+			case ValueType::kDuration: {
+				auto val = ParseDuration(str);
+
+				if (val == std::nullopt) return std::nullopt;
+				return std::make_optional<ValueWrapper>(val.value());
+			}
+			case ValueType::kIntList: return ParseList<std::vector<int>>(str);
+			case ValueType::kInt64List: return ParseList<std::vector<std::int64_t>>(str);
+			case ValueType::kUInt64List: return ParseList<std::vector<std::uint64_t>>(str);
+			case ValueType::kDoubleList: return ParseList<std::vector<double>>(str);
+			case ValueType::kStringList: return ParseList<std::vector<std::string_view>>(str);
 			default: {
-				if constexpr (Verbose) comad_logger.Error("type is not supported."sv);
+				LogError("type is not supported."sv);
 				return std::nullopt;
 			}
 		}
 	}
 
-	int detail::ParseOption(std::string_view name,
-		std::string_view value,
-		const CommandNode& node,
-		ExecutionContext& ctx)
-	{
-		using namespace build_options;
-		using namespace detail;
+	namespace {
+		struct Unit {
+			std::string_view name;
+			std::uint64_t size;
+		};
+
+		constexpr std::array kByteUnits{
+			Unit{ "", 1 }, Unit{ "b", 1 },
+			Unit{ "kb", 1'000 }, Unit{ "mb", 1'000'000 }, Unit{ "gb", 1'000'000'000 },
+			Unit{ "tb", 1'000'000'000'000 }, Unit{ "pb", 1'000'000'000'000'000 },
+			Unit{ "kib", 1ull << 10 }, Unit{ "mib", 1ull << 20 }, Unit{ "gib", 1ull << 30 },
+			Unit{ "tib", 1ull << 40 }, Unit{ "pib", 1ull << 50 }
+		};
+
+		constexpr std::array kDurationUnits{
+			Unit{ "ns", 1 }, Unit{ "us", 1'000 }, Unit{ "ms", 1'000'000 }, Unit{ "s", 1'000'000'000 },
+			Unit{ "m", 60'000'000'000 }, Unit{ "h", 3'600'000'000'000 }
+		};
+
+		bool IsDigit(char c) noexcept {
+			return c >= '0' && c <= '9';
+		}
+
+		// splits the leading digits of str off as a number, leaves the unit after them in str
+		std::optional<std::uint64_t> TakeNumber(std::string_view& str) {
+			const auto digits = static_cast<std::size_t>(std::ranges::find_if_not(str, IsDigit) - str.begin());
+			const std::optional<std::uint64_t> number = detail::OptionalFromChars<std::uint64_t>(str.substr(0, digits));
+			str.remove_prefix(digits);
+			return number;
+		}
 
-		auto debug_stream = comad_logger.MakeStream<LogLevel::DEBUG>();
-		auto error_stream = comad_logger.MakeStream<LogLevel::ERROR>();
+		template <std::size_t N>
+		const Unit* FindUnit(std::string_view name, const std::array<Unit, N>& units) {
+			const auto unit = std::ranges::find_if(units, [name](const Unit& candidate) {
+				return utility::EqualsIgnoreCase(candidate.name, name);
+			});
+			return unit != units.end() ? &*unit : nullptr;
+		}
 
-		if (name.starts_with(OptionPrefix)) {
-			name.remove_prefix(OptionPrefix.length());
+		// the product if it fits, the multiplication is checked before it is made
+		std::optional<std::uint64_t> Scale(std::uint64_t number, std::uint64_t size, std::uint64_t max) {
+			if (number > max / size) {
+				return std::nullopt;
+			}
+			return number * size;
+		}
+	}
 
-			if constexpr (Verbose) debug_stream << "searching for option with name " << name << std::flush;
+	std::optional<ByteSize> detail::ParseByteSize(std::string_view str) {
+		std::string_view rest = str;
+		const std::optional<std::uint64_t> number = TakeNumber(rest);
+		if (number == std::nullopt) {
+			return std::nullopt;
 		}
-		else if (name.starts_with(ShortOptionPrefix)) {
-			name.remove_prefix(ShortOptionPrefix.length());
 
-			if (node.HasShortOption(name[0])) {
-				if constexpr (Verbose)  debug_stream << "searching for option with short name " << name[0] << std::flush;
-				name = node.GetShortOptionName(name[0]);
+		const Unit* unit = FindUnit(rest, kByteUnits);
+		if (unit == nullptr) {
+			LogError(str, " cannot be converted to a byte size: unknown unit ", rest);
+			return std::nullopt;
+		}
+
+		const std::optional<std::uint64_t> bytes = Scale(*number, unit->size, std::numeric_limits<std::uint64_t>::max());
+		if (bytes == std::nullopt) {
+			LogError(str, " cannot be converted to a byte size: it is too large");
+			return std::nullopt;
+		}
+		return ByteSize{ *bytes };
+	}
+
+	std::optional<Duration> detail::ParseDuration(std::string_view str) {
+		constexpr auto kMax = static_cast<std::uint64_t>(std::numeric_limits<Duration::rep>::max());
+
+		if (str == "0"sv) {
+			return Duration::zero();
+		}
+
+		std::string_view rest = str;
+		std::uint64_t total = 0;
+		do {
+			const std::optional<std::uint64_t> number = TakeNumber(rest);
+			if (number == std::nullopt) {
+				return std::nullopt;
+			}
+
+			const auto unit_length = static_cast<std::size_t>(std::ranges::find_if(rest, IsDigit) - rest.begin());
+			const Unit* unit = FindUnit(rest.substr(0, unit_length), kDurationUnits);
+			if (unit == nullptr || unit_length == 0) {
+				LogError(str, " cannot be converted to a duration: unknown unit ", rest.substr(0, unit_length));
+				return std::nullopt;
 			}
-			if constexpr (Verbose) debug_stream << "searching for option with short name " << name << std::flush;
+			rest.remove_prefix(unit_length);
+
+			const std::optional<std::uint64_t> part = Scale(*number, unit->size, kMax);
+			if (part == std::nullopt || *part > kMax - total) {
+				LogError(str, " cannot be converted to a duration: it is too long");
+				return std::nullopt;
+			}
+			total += *part;
+		} while (!rest.empty());
+
+		return Duration{ static_cast<Duration::rep>(total) };
+	}
+
+	bool detail::AppendList(ValueWrapper& list, std::string_view str) {
+		switch (list.GetType())
+		{
+			case ValueType::kIntList: return AppendList(list.GetValue<std::vector<int>>(), str);
+			case ValueType::kInt64List: return AppendList(list.GetValue<std::vector<std::int64_t>>(), str);
+			case ValueType::kUInt64List: return AppendList(list.GetValue<std::vector<std::uint64_t>>(), str);
+			case ValueType::kDoubleList: return AppendList(list.GetValue<std::vector<double>>(), str);
+			case ValueType::kStringList: return AppendList(list.GetValue<std::vector<std::string_view>>(), str);
+			default: {
+				LogError("value is not a list");
+				return false;
+			}
+		}
+	}
+
+	std::string detail::JoinSuggestions(const std::vector<Suggestion>& suggestions) {
+		std::string joined{};
+		for (std::size_t i = 0; i < suggestions.size(); ++i) {
+			if (i != 0) {
+				joined.append(i + 1 == suggestions.size() ? " or " : ", ");
+			}
+			joined.append(suggestions[i].name);
+		}
+		return joined;
+	}
+
+	std::string_view detail::GetUnknownOptionName(const CommandNode& node, const Token& token) {
+		if (token.IsFlagPrefixed() && node.FindFlagSlot(token.GetFlagName()) != kNoSlot) {
+			return {};
+		}
+
+		// single letters and bundles of known short names are not compared with the long names
+		const OptionTable& table = node.GetOptionTable();
+		std::string_view name = token.GetOptionName();
+		if (token.IsLongOption()) {
+			name = name.substr(0, name.find('='));
+			return table.FindLong(name) == nullptr ? name : std::string_view{};
+		}
+		if (token.IsShortOption() && name.size() > 1 && table.FindLong(name) == nullptr &&
+			table.FindShort(name[0]) == nullptr) {
+			return name;
 		}
+		return {};
+	}
+
+	namespace {
+		int UnknownOption(std::string_view name) {
+			using namespace build_options;
 
-		if (!node.HasOption(name)) {
 			if constexpr (!SkipUnknownOption) {
-				if constexpr (Verbose) error_stream << "unknown option " << name << std::flush;
+				LogError("unknown option ", name);
 				return retc::kUnknownOption;
 			}
 			else {
@@ -113,49 +293,729 @@ namespace comad::command {
 			}
 		}
 
-		const CommandOption& option = node.GetOption(name);
-		if constexpr (!SkipDupeOption) {
-			if (ctx.options.contains(name)) {
-				if constexpr (Verbose) error_stream << "option " << name << " has already been passed" << std::flush;
-				return retc::kDupeOption;
-			}
-		}
+		int InvalidValueParse(const OptionDescriptor& descriptor) {
+			using namespace build_options;
 
-		const SupportedValueHolder& option_values = option.supported_values;
-		auto wrapped = StringToValue(option_values.GetValueType(), value);
-		if (wrapped == std::nullopt) {
 			if constexpr (!SkipInvalidValueParse) {
-				if constexpr (Verbose) error_stream << "failed to parse value for option " << name << std::flush;
+				LogError("failed to parse value for option ", descriptor.name);
 				return retc::kInvalidValueParse;
 			}
 			else {
 				return retc::kOptionNotParsed;
 			}
 		}
-		if (IsValueValid(option, *wrapped)) {
-			ctx.options.emplace(name, std::move(*wrapped));
 
-			ctx.required_option_count += option.required;
-			return retc::kOptionParsed;
+		// only the appended elements are validated, the list is left as it was if they cannot be parsed
+		int AppendOptionValue(const OptionDescriptor& descriptor, std::string_view value, ExecutionContext& ctx) {
+			const CommandOption& option = *descriptor.option;
+			ValueWrapper& list = ctx.options.At(descriptor.slot);
+			const std::size_t first = list.GetListSize();
+
+			const bool parsed = detail::Traced(kSpanStringToValue, value, [&] { return detail::AppendList(list, value); });
+			if (!parsed) {
+				return InvalidValueParse(descriptor);
+			}
+			const bool valid = detail::Traced(kSpanIsValueValid, descriptor.name, [&] {
+				return detail::DispatchSample::MeasureValidation([&] { return option.supported_values.AreValid(list, first); });
+			});
+			if (valid) {
+				return retc::kOptionParsed;
+			}
+			LogError("invalid value ", value, " for option ", descriptor.name);
+
+			return retc::kInvalidOptionValue;
 		}
-		if constexpr (Verbose) error_stream << "invalid value " << value << " for option " << name << std::flush;
 
-		return retc::kInvalidOptionValue;
+		int SetOptionValue(const OptionDescriptor& descriptor, std::string_view value, ExecutionContext& ctx) {
+			using namespace build_options;
+
+			const CommandOption& option = *descriptor.option;
+			const bool passed_before = ctx.options.Has(descriptor.slot);
+			// a list option is never a duplicate, every occurrence adds its elements
+			if (option.list && passed_before) {
+				return AppendOptionValue(descriptor, value, ctx);
+			}
+			if constexpr (!SkipDupeOption) {
+				if (passed_before) {
+					LogError("option ", descriptor.name, " has already been passed");
+					return retc::kDupeOption;
+				}
+			}
+
+			auto wrapped = detail::Traced(kSpanStringToValue, value, [&] {
+				return detail::StringToValue(option.GetValueType(), value);
+			});
+			if (wrapped == std::nullopt) {
+				return InvalidValueParse(descriptor);
+			}
+			const bool valid = detail::Traced(kSpanIsValueValid, descriptor.name, [&] {
+				return detail::DispatchSample::MeasureValidation([&] { return detail::IsValueValid(option, *wrapped); });
+			});
+			if (valid) {
+				// the first occurrence wins when duplicates are skipped
+				if (!passed_before) {
+					ctx.options.Set(descriptor.slot, std::move(*wrapped));
+					ctx.required_option_count += option.required;
+				}
+
+				return retc::kOptionParsed;
+			}
+			LogError("invalid value ", value, " for option ", descriptor.name);
+
+			return retc::kInvalidOptionValue;
+		}
+
+		int AsInline(int ret) noexcept {
+			return ret == retc::kOptionParsed ? retc::kOptionParsedInline : ret;
+		}
+
+		// -abc sets every bool option it names, otherwise the rest is the value of the first one as in -l5
+		int ParseShortBundle(const OptionTable& table, std::string_view names, ExecutionContext& ctx) {
+			const bool all_bool = std::ranges::all_of(names, [&table](char short_name) {
+				const OptionDescriptor* descriptor = table.FindShort(short_name);
+				return descriptor != nullptr &&
+					descriptor->option->supported_values.GetValueType() == ValueType::kBool;
+			});
+
+			if (!all_bool) {
+				return AsInline(SetOptionValue(*table.FindShort(names[0]), names.substr(1), ctx));
+			}
+
+			for (const char short_name : names) {
+				const int ret = SetOptionValue(*table.FindShort(short_name), "true"sv, ctx);
+				if (ret != retc::kOptionParsed) {
+					return ret;
+				}
+			}
+			return retc::kOptionParsedInline;
+		}
+	}
+
+	int detail::ParseOption(std::string_view name,
+		std::string_view value,
+		const CommandNode& node,
+		ExecutionContext& ctx)
+	{
+		return ParseOption(Token::Classify(name), std::optional{ value }, node, ctx);
+	}
+
+	int detail::ParseOption(const Token& token,
+		std::optional<std::string_view> value,
+		const CommandNode& node,
+		ExecutionContext& ctx)
+	{
+		const OptionTable& table = node.GetOptionTable();
+		const std::string_view name = token.GetOptionName();
+		const OptionDescriptor* descriptor = nullptr;
+
+		if (token.IsLongOption()) {
+			LogDebug("searching for option with name ", name);
+
+			if (const std::size_t separator = name.find('='); separator != std::string_view::npos) {
+				const std::string_view option_name = name.substr(0, separator);
+				descriptor = table.FindLong(option_name);
+				if (descriptor == nullptr) {
+					return UnknownOption(option_name);
+				}
+				return AsInline(SetOptionValue(*descriptor, name.substr(separator + 1), ctx));
+			}
+
+			descriptor = table.FindLong(name);
+		}
+		else if (token.IsShortOption()) {
+			LogDebug("searching for option with short name ", name);
+
+			// a full name behind the short prefix is still accepted, as in -level 5
+			descriptor = name.size() == 1 ? table.FindShort(name[0]) : nullptr;
+			if (descriptor == nullptr) {
+				descriptor = table.FindLong(name);
+			}
+			if (descriptor == nullptr && name.size() > 1 && table.FindShort(name[0]) != nullptr) {
+				return ParseShortBundle(table, name, ctx);
+			}
+		}
+		else {
+			// positionals are never looked up as options
+			return retc::kOptionNotParsed;
+		}
+
+		if (descriptor == nullptr) {
+			return UnknownOption(name);
+		}
+		// without a value left the token is handled like a positional
+		if (!value) {
+			return retc::kOptionNotParsed;
+		}
+
+		return SetOptionValue(*descriptor, *value, ctx);
+	}
+
+	namespace {
+		struct ContextPool {
+			std::vector<std::unique_ptr<ExecutionContext>> contexts{};
+			std::size_t depth{ 0 };
+		};
+
+		// one context per nesting level, so executors that dispatch further commands get their own
+		thread_local ContextPool context_pool{};
+	}
+
+	detail::ContextLease::ContextLease() {
+		if (context_pool.depth == context_pool.contexts.size()) {
+			context_pool.contexts.push_back(std::make_unique<ExecutionContext>());
+		}
+		ctx_ = context_pool.contexts[context_pool.depth++].get();
+	}
+
+	detail::ContextLease::~ContextLease() {
+		--context_pool.depth;
+	}
+
+	ExecutionContext& detail::ContextLease::Get() noexcept {
+		return *ctx_;
+	}
+
+	detail::OwnedContext::OwnedContext(const ExecutionContext& ctx) :
+		extra_args_{ ctx.MaterializeExtraArgs() },
+		ctx_{ ctx }
+	{
+		ctx_.extra_args.assign(extra_args_.begin(), extra_args_.end());
+
+		OwnLayout(ctx.flags.GetLayout(), layout_.flags);
+		OwnLayout(ctx.options.GetLayout(), layout_.options);
+		OwnLayout(ctx.args.GetLayout(), layout_.args);
+		ctx_.flags.Rebind(layout_.flags);
+		ctx_.options.Rebind(layout_.options);
+		ctx_.args.Rebind(layout_.args);
+	}
+
+	void detail::OwnedContext::OwnLayout(const SlotLayout* from, SlotLayout& to) {
+		if (from == nullptr) {
+			return;
+		}
+
+		std::vector<std::string_view> slot_names{};
+		slot_names.reserve(from->names.size());
+		for (const std::string_view name : from->names) {
+			slot_names.push_back(names_.emplace_back(name));
+		}
+		to.Assign(std::move(slot_names));
+	}
+
+	const ExecutionContext& detail::OwnedContext::Get() const noexcept {
+		return ctx_;
+	}
+
+	namespace {
+		// a coroutine that owns itself, its frame is destroyed when the body has finished
+		struct DetachedTask {
+			struct promise_type {
+				DetachedTask get_return_object() const noexcept { return {}; }
+				std::suspend_never initial_suspend() const noexcept { return {}; }
+				std::suspend_never final_suspend() const noexcept { return {}; }
+				void return_void() const noexcept {}
+				void unhandled_exception() const noexcept { std::terminate(); }
+			};
+		};
+
+		// the frame owns the executor and the context until the command is done, coroutine
+		// executors get references to both that stay valid across their suspensions. parsed is
+		// only read before the first suspension, while the caller still holds it. the pin keeps
+		// a tree swapped out meanwhile alive until the frame is destroyed, on whichever worker
+		// finishes the command. copying the context and scheduling may throw as well, every
+		// exception ends up in the future since the task itself terminates on one
+		DetachedTask RunAsync(ThreadPool& pool,
+							  CommandExecutor executor,
+							  const ExecutionContext& parsed,
+							  [[maybe_unused]] detail::SnapshotGuard pin,
+							  std::shared_ptr<detail::FutureState> state,
+							  std::optional<detail::PendingResult> pending) {
+			try {
+				const detail::OwnedContext ctx{ parsed };
+				co_await pool.Schedule();
+
+				const int result = executor.IsCoroutine() ? co_await executor.Start(ctx.Get()) : executor(ctx.Get());
+				if (pending) {
+					pending->cache->Store(std::move(pending->key), pending->node, pending->policy, pending->generation,
+						result);
+				}
+				state->SetResult(result);
+			}
+			catch (...) {
+				state->SetException(std::current_exception());
+			}
+		}
+	}
+
+	CommandFuture detail::ExecuteAsync(ThreadPool& pool,
+									   const CommandExecutor& executor,
+									   const ExecutionContext& ctx,
+									   SnapshotGuard pin,
+									   std::optional<PendingResult> pending) {
+		auto state = std::make_shared<FutureState>();
+		RunAsync(pool, executor, ctx, std::move(pin), state, std::move(pending));
+		return CommandFuture{ std::move(state) };
+	}
+
+	detail::MappedFile::MappedFile(const std::filesystem::path& path) {
+#if COMAD_HAS_MMAP
+		const int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) {
+			throw std::system_error{ errno, std::generic_category(), "failed to open " + path.string() };
+		}
+
+		struct stat info{};
+		if (::fstat(fd, &info) != 0) {
+			const int error = errno;
+			::close(fd);
+			throw std::system_error{ error, std::generic_category(), "failed to stat " + path.string() };
+		}
+
+		size_ = static_cast<std::size_t>(info.st_size);
+		if (size_ > 0) {
+			// private and writable: pages are only copied when tokenizing actually has to rewrite them
+			void* data = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+			if (data == MAP_FAILED) {
+				const int error = errno;
+				::close(fd);
+				throw std::system_error{ error, std::generic_category(), "failed to map " + path.string() };
+			}
+			::madvise(data, size_, MADV_SEQUENTIAL);
+			data_ = static_cast<char*>(data);
+		}
+		::close(fd);
+#else
+		std::ifstream file{ path, std::ios::binary | std::ios::ate };
+		if (!file) {
+			throw std::system_error{ std::make_error_code(std::errc::no_such_file_or_directory),
+				"failed to open " + path.string() };
+		}
+
+		fallback_.resize(static_cast<std::size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(fallback_.data(), static_cast<std::streamsize>(fallback_.size()));
+		data_ = fallback_.data();
+		size_ = fallback_.size();
+#endif
+	}
+
+	detail::MappedFile::~MappedFile() {
+#if COMAD_HAS_MMAP
+		if (data_ != nullptr) {
+			::munmap(data_, size_);
+		}
+#endif
+	}
+
+	std::span<char> detail::MappedFile::Get() noexcept {
+		return std::span<char>{ data_, size_ };
+	}
+
+	std::span<const std::string_view> detail::ResponseFileExpansion::Get() const noexcept {
+		return tokens_;
+	}
+
+	bool detail::ResponseFileExpansion::ExpandToken(std::string_view token, std::size_t depth, std::size_t max_depth,
+													int& error) {
+		if (token.size() < 2 || token.front() != '@') {
+			tokens_.push_back(token);
+			return true;
+		}
+		if (token[1] == '@') {
+			tokens_.push_back(token.substr(1));
+			return true;
+		}
+		if (depth == max_depth) {
+			LogError("response file ", token.substr(1), " is nested more than ", max_depth, " levels deep");
+			error = retc::kResponseFileTooDeep;
+			return false;
+		}
+
+		return ExpandFile(token.substr(1), depth + 1, max_depth, error);
+	}
+
+	bool detail::ResponseFileExpansion::ExpandFile(std::string_view path, std::size_t depth, std::size_t max_depth,
+												   int& error) {
+		try {
+			files_.push_back(std::make_unique<MappedFile>(std::filesystem::path{ path }));
+		}
+		catch (const std::system_error& e) {
+			LogError("failed to read response file: ", e.what());
+			error = retc::kResponseFileError;
+			return false;
+		}
+
+		// the tokens of a line are expanded before the next line is tokenized, so nested files can reuse
+		// the expansion's token list but not the line buffer
+		std::vector<std::string_view> line_tokens{};
+		std::size_t line_number = 1;
+
+		const std::span<char> buffer = files_.back()->Get();
+		char* it = buffer.data();
+		char* const end = it + buffer.size();
+		for (; it != end; ++line_number) {
+			char* line_end = static_cast<char*>(std::memchr(it, '\n', end - it));
+			char* const next = line_end == nullptr ? end : line_end + 1;
+			if (line_end == nullptr) {
+				line_end = end;
+			}
+
+			if (!utility::TokenizeLine(std::span<char>{ it, line_end }, line_tokens)) {
+				LogError("malformed line ", line_number, " in response file ", path);
+				error = retc::kResponseFileError;
+				return false;
+			}
+			for (const std::string_view token : line_tokens) {
+				if (!ExpandToken(token, depth, max_depth, error)) {
+					return false;
+				}
+			}
+
+			it = next;
+		}
+
+		return true;
+	}
+
+	CommandHandler::CommandHandler(CommandHandler&& other) noexcept :
+		node_{ std::move(other.node_) },
+		count_uses_{ other.count_uses_ },
+		response_file_depth_{ other.response_file_depth_ },
+		metrics_{ std::move(other.metrics_) },
+		tracer_{ std::move(other.tracer_) }
+	{
+		AdoptSnapshot(other);
+	}
+
+	CommandHandler& CommandHandler::operator=(CommandHandler&& other) noexcept {
+		// the published tree may be node_ itself, so it goes first
+		snapshots_.Take();
+		node_ = std::move(other.node_);
+		metrics_ = std::move(other.metrics_);
+		tracer_ = std::move(other.tracer_);
+		count_uses_ = other.count_uses_;
+		response_file_depth_ = other.response_file_depth_;
+		AdoptSnapshot(other);
+		cache_.Invalidate();
+		cache_.ResetStats();
+
+		return *this;
+	}
+
+	void CommandHandler::AdoptSnapshot(CommandHandler& other) noexcept {
+		// a tree of its own stays where it is, a borrowed one has moved into node_
+		std::unique_ptr<detail::TreeSnapshot> snapshot = other.snapshots_.Take();
+		if (snapshot != nullptr && !snapshot->owned_root) {
+			snapshot->RebindRoot(node_);
+		}
+		// nothing is published yet, so nothing is allocated
+		snapshots_.Publish(std::move(snapshot));
+		if (metrics_) {
+			metrics_->ForgetNodes();
+		}
 	}
 
 	CommandNode& CommandHandler::GetCommandNode() noexcept {
+		// the caller may modify the tree through the returned node, so the compiled index can go stale
+		Thaw();
 		return node_;
 	}
 
 	const CommandNode& CommandHandler::GetCommandNode() const noexcept {
-		return node_;
+		return GetRoot(snapshots_.GetUnpinned());
+	}
+
+	const CommandNode& CommandHandler::GetRoot(const detail::TreeSnapshot* tree) const noexcept {
+		return tree != nullptr ? *tree->root : node_;
+	}
+
+	void CommandHandler::SetCommandNode(CommandNode node) {
+		// results are cached by node, a freed tree's addresses may come back with a later one
+		if (snapshots_.Publish(std::make_unique<detail::TreeSnapshot>(std::move(node))) > 0) {
+			cache_.Invalidate();
+		}
+		if (metrics_) {
+			metrics_->ForgetNodes();
+		}
+	}
+
+	void CommandHandler::Freeze() {
+		Thaw();
+		snapshots_.Publish(std::make_unique<detail::TreeSnapshot>(std::as_const(node_)));
+	}
+
+	void CommandHandler::Thaw() noexcept {
+		std::unique_ptr<detail::TreeSnapshot> snapshot = snapshots_.Take();
+		if (snapshot != nullptr && snapshot->owned_root) {
+			// the tree set last becomes the one to edit
+			node_ = std::move(*snapshot->owned_root);
+		}
+		cache_.Invalidate();
+		if (metrics_) {
+			metrics_->ForgetNodes();
+		}
+	}
+
+	bool CommandHandler::IsFrozen() const noexcept {
+		return snapshots_.GetUnpinned() != nullptr;
+	}
+
+	void CommandHandler::InvalidateCache() {
+		cache_.Invalidate();
+	}
+
+	void CommandHandler::InvalidateCache(const CommandNode& node) {
+		cache_.Invalidate(node);
+	}
+
+	CacheStats CommandHandler::GetCacheStats() const {
+		return cache_.GetStats();
+	}
+
+	void CommandHandler::ResetCacheStats() noexcept {
+		cache_.ResetStats();
+	}
+
+	void CommandHandler::EnableMetrics() {
+		if constexpr (!build_options::EnableMetrics) {
+			throw std::logic_error{ "metrics are not compiled in, the library has to be built with COMAD_ENABLE_METRICS" };
+		}
+
+		if (!metrics_) {
+			metrics_ = std::make_shared<CommandMetrics>();
+		}
+	}
+
+	void CommandHandler::DisableMetrics() noexcept {
+		metrics_.reset();
+	}
+
+	bool CommandHandler::IsMetricsEnabled() const noexcept {
+		return metrics_ != nullptr;
+	}
+
+	MetricsSnapshot CommandHandler::GetMetrics() const {
+		return metrics_ ? metrics_->GetSnapshot() : MetricsSnapshot{};
 	}
 
-	void CommandHandler::SetCommandNode(CommandNode node) noexcept {
-		node_ = std::move(node);
+	void CommandHandler::ResetMetrics() {
+		if (metrics_) {
+			metrics_->Reset();
+		}
+	}
+
+	void CommandHandler::EnableTracing(std::shared_ptr<TraceSink> sink, std::uint32_t sample_every) {
+		if constexpr (!build_options::EnableTracing) {
+			throw std::logic_error{ "tracing is not compiled in, the library has to be built with COMAD_ENABLE_TRACING" };
+		}
+
+		tracer_ = std::make_shared<const Tracer>(std::move(sink), sample_every);
+	}
+
+	void CommandHandler::DisableTracing() noexcept {
+		tracer_.reset();
+	}
+
+	bool CommandHandler::IsTracingEnabled() const noexcept {
+		return tracer_ != nullptr;
+	}
+
+	std::vector<Suggestion> CommandHandler::SuggestCommand(const CommandNode& parent, std::string_view name,
+														   std::size_t count) const
+	{
+		const detail::SnapshotGuard pin = snapshots_.Pin();
+		return SuggestCommand(pin.Get(), parent, name, count);
+	}
+
+	std::vector<Suggestion> CommandHandler::SuggestOption(const CommandNode& node, std::string_view name,
+														  std::size_t count) const
+	{
+		const detail::SnapshotGuard pin = snapshots_.Pin();
+		return SuggestOption(pin.Get(), node, name, count);
+	}
+
+	std::vector<Suggestion> CommandHandler::SuggestCommand(const detail::TreeSnapshot* tree, const CommandNode& parent,
+														   std::string_view name, std::size_t count) const
+	{
+		return tree != nullptr ? tree->suggestions.GetCommandIndex(parent).Find(name, count) :
+			BuildCommandIndex(parent).Find(name, count);
+	}
+
+	std::vector<Suggestion> CommandHandler::SuggestOption(const detail::TreeSnapshot* tree, const CommandNode& node,
+														  std::string_view name, std::size_t count) const
+	{
+		return tree != nullptr ? tree->suggestions.GetOptionIndex(node).Find(name, count) :
+			BuildOptionIndex(node).Find(name, count);
+	}
+
+	std::vector<Suggestion> CommandHandler::Suggest(const detail::TreeSnapshot* tree, const CommandNode& node,
+													std::string_view token, std::size_t count) const
+	{
+		if (!node.GetExecutor()) {
+			return SuggestCommand(tree, node, token, count);
+		}
+
+		const std::string_view name = detail::GetUnknownOptionName(node, Token::Classify(token));
+		if (name.empty()) {
+			return {};
+		}
+
+		std::vector<Suggestion> suggestions = SuggestOption(tree, node, name, count);
+		for (Suggestion& suggestion : suggestions) {
+			suggestion.name.insert(0, build_options::OptionPrefix);
+		}
+		return suggestions;
+	}
+
+	std::vector<Completion> CommandHandler::CompleteWords(std::span<const std::string_view> words,
+														 std::size_t count) const
+	{
+		using namespace detail;
+
+		std::vector<Completion> completions{};
+		const auto word_it = words.empty() ? words.end() : words.end() - 1;
+		const std::string_view word = words.empty() ? std::string_view{} : *word_it;
+
+		const SnapshotGuard pin = snapshots_.Pin();
+		auto it = words.begin();
+		const CommandNode& node = FindNode(pin.Get(), it, word_it);
+
+		std::optional<CompletionIndex> built{};
+		const CompletionIndex& index = pin.Get() != nullptr ? pin.Get()->completions.GetIndex(node) : built.emplace(node);
+
+		// subcommands can only follow the name of their parent
+		if (it == word_it) {
+			index.Complete(word, true, count_uses_, count, completions);
+			return completions;
+		}
+		if (!node.GetExecutor()) {
+			return completions;
+		}
+
+		// the word is the value of the option before it
+		const Token option = Token::Classify(*(word_it - 1));
+		const bool is_flag = option.IsFlagPrefixed() && node.FindFlagSlot(option.GetFlagName()) != kNoSlot;
+		if (!is_flag && option.IsOption()) {
+			const std::string_view name = option.GetOptionName();
+			const OptionDescriptor* descriptor = !option.IsLongOption() && name.size() == 1 ?
+				node.GetOptionTable().FindShort(name[0]) :
+				node.GetOptionTable().FindLong(name);
+			if (descriptor != nullptr) {
+				index.CompleteValue(descriptor->name, word, count, completions);
+				return completions;
+			}
+		}
+
+		index.Complete(word, false, count_uses_, count, completions);
+		return completions;
+	}
+
+	void CommandHandler::EnableUsageCounting() noexcept {
+		count_uses_ = true;
+	}
+
+	void CommandHandler::DisableUsageCounting() noexcept {
+		count_uses_ = false;
+	}
+
+	bool CommandHandler::IsUsageCountingEnabled() const noexcept {
+		return count_uses_;
+	}
+
+	void CommandHandler::EnableResponseFiles(std::size_t max_depth) noexcept {
+		response_file_depth_ = std::max<std::size_t>(max_depth, 1);
+	}
+
+	void CommandHandler::DisableResponseFiles() noexcept {
+		response_file_depth_ = 0;
+	}
+
+	bool CommandHandler::IsResponseFilesEnabled() const noexcept {
+		return response_file_depth_ > 0;
+	}
+
+	CommandNode& CommandHandler::AddStatsCommand(std::string_view name, std::ostream& stream) {
+		EnableMetrics();
+
+		CommandNode& node = GetCommandNode() >> name;
+		node.SetCommand(CommandTemplate{
+			.flags = { "reset" },
+			.description = "prints the calls, errors and dispatch latencies of every command"
+		}, [metrics = metrics_, stream = &stream](const ExecutionContext& ctx) {
+			WriteMetrics(*stream, metrics->GetSnapshot());
+			// every flag of the node has a slot, so it is looked at for its value
+			if (const auto it = ctx.flags.find("reset"sv); it != ctx.flags.end() && it->second) {
+				metrics->Reset();
+			}
+			return 0;
+		});
+		return node;
+	}
+
+	namespace {
+		// reused for the key of every cached dispatch on a thread. it is copied before the executor
+		// runs, since executors may dispatch cached commands themselves
+		thread_local std::string cache_key{};
+	}
+
+	int CommandHandler::Execute(const CommandNode& node, const ExecutionContext& ctx) const {
+		if (count_uses_) {
+			node.RecordUse();
+		}
+
+		if (!node.GetCachePolicy()) {
+			return node.GetExecutor()(ctx);
+		}
+
+		// taken before the lookup, a result computed from a tree invalidated while the executor runs is not stored
+		const std::uint64_t generation = cache_.GetGeneration();
+		cache_key.clear();
+		ResultCache::BuildKey(node, ctx, cache_key);
+		if (const std::optional<int> cached = cache_.Find(cache_key)) {
+			return *cached;
+		}
+
+		std::string key{ cache_key };
+		const int result = node.GetExecutor()(ctx);
+		cache_.Store(std::move(key), &node, *node.GetCachePolicy(), generation, result);
+		return result;
+	}
+
+	CommandFuture CommandHandler::ExecuteAsync(ThreadPool& pool, const CommandNode& node, const ExecutionContext& ctx,
+											   detail::SnapshotGuard pin) const {
+		if (count_uses_) {
+			node.RecordUse();
+		}
+
+		if (!node.GetCachePolicy()) {
+			return detail::ExecuteAsync(pool, node.GetExecutor(), ctx, std::move(pin));
+		}
+
+		// taken before the lookup, a result computed from a tree invalidated after it is not stored
+		const std::uint64_t generation = cache_.GetGeneration();
+		cache_key.clear();
+		ResultCache::BuildKey(node, ctx, cache_key);
+		if (const std::optional<int> cached = cache_.Find(cache_key)) {
+			return CommandFuture::FromResult(*cached);
+		}
+
+		return detail::ExecuteAsync(pool, node.GetExecutor(), ctx, std::move(pin),
+			detail::PendingResult{ &cache_, &node, *node.GetCachePolicy(), generation, cache_key });
 	}
 
 	int CommandHandler::HandleCommand(int argc, const char** argv) const {
 		return HandleCommand(std::span<const char*>(argv, argc));
 	}
+
+	std::vector<LineResult> CommandHandler::HandleStream(std::istream& stream) const {
+		std::vector<LineResult> results{};
+		HandleStream(stream, [&results](const LineResult& result) { results.push_back(result); });
+		return results;
+	}
+
+	std::vector<LineResult> CommandHandler::HandleFile(const std::filesystem::path& path) const {
+		std::vector<LineResult> results{};
+		HandleFile(path, [&results](const LineResult& result) { results.push_back(result); });
+		return results;
+	}
 }
\ No newline at end of file
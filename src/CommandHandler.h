@@ -3,14 +3,35 @@
 
 #include <charconv>
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <istream>
+#include <iostream>
+#include <ostream>
 #include <ranges>
+#include <span>
 #include <string_view>
 #include <type_traits>
+#include <memory>
 #include <optional>
+#include <string>
+#include <vector>
 
 #include "Value.h"
 #include "Logger.h"
 #include "CommandNode.h"
+#include "CommandMetrics.h"
+#include "CommandTrace.h"
+#include "CommandTask.h"
+#include "CompiledCommandTree.h"
+#include "CompletionIndex.h"
+#include "ResultCache.h"
+#include "SuggestionIndex.h"
+#include "ThreadPool.h"
+#include "TokenTable.h"
+#include "TreeSnapshot.h"
 
 
 namespace comad::command {
@@ -25,23 +46,247 @@ namespace comad::command {
 		template<std::floating_point T>
 		std::optional<T> OptionalFromChars(std::string_view str, std::chars_format fmt = std::chars_format::general);
 
+		// a whole number with an optional unit: B, kB, MB, ... for powers of 1000 and KiB, MiB, ... for powers
+		// of 1024, in any case. no unit means bytes
+		std::optional<value::ByteSize> ParseByteSize(std::string_view str);
+
+		// whole numbers each followed by one of h, m, s, ms, us or ns, like 1h30m. 0 needs no unit
+		std::optional<value::Duration> ParseDuration(std::string_view str);
+
+		// appends the elements of str, separated by build_options::ListSeparator, to list. the separators are
+		// found in one vectorized scan before any element is converted. an empty str has no elements. returns
+		// false and leaves list as it was if an element cannot be converted
+		template <value::ListValueType T>
+		bool AppendList(T& list, std::string_view str);
+
+		// the same for a value of a list type
+		bool AppendList(value::ValueWrapper& list, std::string_view str);
+
 		template <std::input_iterator iter> requires
 			(std::is_constructible_v<std::string_view, std::iter_value_t<iter>> ||
 				std::is_convertible_v<std::iter_value_t<iter>, std::string_view>)
 		const CommandNode& FindNode(const CommandNode& start_node, iter& command_name_it, iter end_it);
 
+		template <std::input_iterator iter> requires
+			(std::is_constructible_v<std::string_view, std::iter_value_t<iter>> ||
+				std::is_convertible_v<std::iter_value_t<iter>, std::string_view>)
+		const CommandNode& FindNode(const CompiledCommandTree& tree, iter& command_name_it, iter end_it);
+
+		// fills ctx from the tokens that follow the name of node, returns false and sets error if
+		// they do not make a valid call of it. failed_token, if given, is set to the token at fault
+		template <std::input_iterator iter, std::sentinel_for<iter> sentinel> requires
+			(std::is_constructible_v<std::string_view, std::iter_value_t<iter>> ||
+				std::is_convertible_v<std::iter_value_t<iter>, std::string_view>)
+		bool ParseContext(const CommandNode& node, ExecutionContext& ctx, iter first, sentinel last, int& error,
+						  std::string_view* failed_token = nullptr);
+
 		int ParseOption(std::string_view name,
 						std::string_view value,
 						const CommandNode& node,
 						ExecutionContext& ctx);
+
+		// value is the token after the option, if there is one. kOptionParsed means it was consumed,
+		// kOptionParsedInline that the token carried its own value as in --name=value, -l5 or -abc
+		int ParseOption(const Token& token,
+						std::optional<std::string_view> value,
+						const CommandNode& node,
+						ExecutionContext& ctx);
+
+		// "a, b or c", for log messages
+		std::string JoinSuggestions(const std::vector<Suggestion>& suggestions);
+
+		// the name an option token gives if node has no such option, empty for any other token
+		std::string_view GetUnknownOptionName(const CommandNode& node, const Token& token);
+
+		// maps a whole file privately, so tokenizing it in place never writes back to it
+		class MappedFile {
+		public:
+			explicit MappedFile(const std::filesystem::path& path);
+			~MappedFile();
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			[[nodiscard]] std::span<char> Get() noexcept;
+
+		private:
+			char* data_{ nullptr };
+			std::size_t size_{ 0 };
+			std::vector<char> fallback_{};
+		};
+
+		// true if a token of range starts with @, the only case in which it has to be expanded
+		template <std::ranges::input_range Range>
+		bool HasResponseFile(const Range& range);
+
+		// the tokens of a command with every @file token replaced by the tokens of file. the files are mapped
+		// and tokenized in place like the lines of HandleFile, with line breaks as whitespace, and stay mapped
+		// as long as the expansion. a token starting with @@ stands for itself without the first @
+		class ResponseFileExpansion {
+		public:
+			// returns false and sets error if a file cannot be read or tokenized, or files name each other more
+			// than max_depth levels deep
+			template <std::ranges::input_range Range>
+			bool Expand(const Range& range, std::size_t max_depth, int& error);
+
+			[[nodiscard]] std::span<const std::string_view> Get() const noexcept;
+
+		private:
+			std::vector<std::unique_ptr<MappedFile>> files_{};
+			std::vector<std::string_view> tokens_{};
+
+			bool ExpandToken(std::string_view token, std::size_t depth, std::size_t max_depth, int& error);
+			bool ExpandFile(std::string_view path, std::size_t depth, std::size_t max_depth, int& error);
+		};
+
+		class ContextLease {
+		public:
+			ContextLease();
+			~ContextLease();
+
+			ContextLease(const ContextLease&) = delete;
+			ContextLease& operator=(const ContextLease&) = delete;
+
+			[[nodiscard]] ExecutionContext& Get() noexcept;
+
+		private:
+			ExecutionContext* ctx_;
+		};
+
+		// a context that refers neither to the dispatched input nor to the node, so it can outlive the
+		// dispatch call and the tree. the slot names and layouts are copied along with the values
+		class OwnedContext {
+		public:
+			explicit OwnedContext(const ExecutionContext& ctx);
+
+			OwnedContext(const OwnedContext&) = delete;
+			OwnedContext& operator=(const OwnedContext&) = delete;
+
+			[[nodiscard]] const ExecutionContext& Get() const noexcept;
+
+		private:
+			// a deque, so the names do not move while the layouts are built
+			std::deque<std::string> names_;
+			ContextLayout layout_;
+			std::vector<std::string> extra_args_;
+			ExecutionContext ctx_;
+
+			void OwnLayout(const SlotLayout* from, SlotLayout& to);
+		};
+
+		// where the result of an asynchronous command is cached once its executor has returned. the node
+		// is only a key by then, the generation drops the result if the cache was invalidated meanwhile
+		struct PendingResult {
+			ResultCache* cache;
+			const CommandNode* node;
+			CachePolicy policy;
+			std::uint64_t generation;
+			std::string key;
+		};
+
+		// takes ownership of the parsed context and runs executor on pool. pin is held until the command is done
+		CommandFuture ExecuteAsync(ThreadPool& pool,
+								   const CommandExecutor& executor,
+								   const ExecutionContext& ctx,
+								   SnapshotGuard pin,
+								   std::optional<PendingResult> pending = std::nullopt);
 	}
 
+	struct LineResult {
+		std::size_t line;
+		int result;
+	};
+
 	class CommandHandler {
 	public:
+		CommandHandler() = default;
+		CommandHandler(CommandHandler&& other) noexcept;
+		CommandHandler& operator=(CommandHandler&& other) noexcept;
+
+		// thaws the handler, the tree set last is the one returned for editing
 		[[nodiscard]] CommandNode& GetCommandNode() noexcept;
+		// the tree commands are dispatched to, a node set by SetCommandNode is only valid until the next one
 		[[nodiscard]] const CommandNode& GetCommandNode() const noexcept;
 
-		void SetCommandNode(CommandNode node) noexcept;
+		// compiles node and publishes it in place of the current tree, the handler is frozen afterwards. unlike
+		// every other change to the tree, this may run while other threads dispatch: commands that have already
+		// looked up their node finish on the tree they found it in, which is freed once no dispatch uses it.
+		// metrics are kept per node and should be reset after a reload that changes the commands
+		void SetCommandNode(CommandNode node);
+
+		void Freeze();
+		// also drops every cached result, since any node may change afterwards
+		void Thaw() noexcept;
+		[[nodiscard]] bool IsFrozen() const noexcept;
+
+		// results of nodes with a cache policy are returned without running the executor when the
+		// input parses to a context that was seen before. the cache has to be invalidated by hand
+		// when what those executors report changes
+		void InvalidateCache();
+		void InvalidateCache(const CommandNode& node);
+		[[nodiscard]] CacheStats GetCacheStats() const;
+		void ResetCacheStats() noexcept;
+
+		// counts calls and errors per node and records the time each dispatch spends in lookup, parsing,
+		// validation and the executor. only available if the library is built with COMAD_ENABLE_METRICS,
+		// EnableMetrics throws std::logic_error otherwise. asynchronous commands are recorded without
+		// their executor time
+		void EnableMetrics();
+		void DisableMetrics() noexcept;
+		[[nodiscard]] bool IsMetricsEnabled() const noexcept;
+		[[nodiscard]] MetricsSnapshot GetMetrics() const;
+		void ResetMetrics();
+
+		// hands the spans of every sample_every-th dispatch on a thread to sink: the lookup, every option,
+		// value conversion and validation, the required option check and the executor. only available if
+		// the library is built with COMAD_ENABLE_TRACING, EnableTracing throws std::logic_error otherwise
+		void EnableTracing(std::shared_ptr<TraceSink> sink, std::uint32_t sample_every = 1);
+		void DisableTracing() noexcept;
+		[[nodiscard]] bool IsTracingEnabled() const noexcept;
+
+		// the names nearest to name among the children and aliases of parent, or among the options of node.
+		// while the handler is frozen, each node's names are indexed once and queries take microseconds,
+		// otherwise the index is built for every query
+		[[nodiscard]] std::vector<Suggestion> SuggestCommand(const CommandNode& parent, std::string_view name,
+															 std::size_t count = 3) const;
+		[[nodiscard]] std::vector<Suggestion> SuggestOption(const CommandNode& node, std::string_view name,
+															std::size_t count = 3) const;
+
+		// for input that failed with kUnknownCommand or kUnknownOption: the suggestions for the first token
+		// that names neither a command nor an option. options are spelled with their prefix
+		template <std::ranges::input_range Range> requires
+			(std::is_constructible_v<std::string_view, std::ranges::range_value_t<Range>> ||
+			std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
+		[[nodiscard]] std::vector<Suggestion> Suggest(const Range& range, std::size_t count = 3) const;
+
+		// completions of the last element of partial_argv, the word being typed: the children and aliases of the
+		// command the elements before it name, its flags and options, or the listed values of the option right
+		// before it. while the handler is frozen, each node is indexed once
+		template <std::ranges::input_range Range> requires
+			(std::is_constructible_v<std::string_view, std::ranges::range_value_t<Range>> ||
+			std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
+		[[nodiscard]] std::vector<Completion> Complete(const Range& partial_argv, std::size_t count = 16) const;
+
+		// counts the uses of every dispatched command, so the most used ones are completed first. off by
+		// default, since dispatching threads then write to the node they run
+		void EnableUsageCounting() noexcept;
+		void DisableUsageCounting() noexcept;
+		[[nodiscard]] bool IsUsageCountingEnabled() const noexcept;
+
+		// replaces @file tokens of dispatched commands by the tokens of file, which may name further files up to
+		// max_depth levels deep. @@ starts a token that begins with a literal @. off by default, since it lets the
+		// input read any file the process can. tokens read from files are only valid during the executor call,
+		// like the rest of the input
+		void EnableResponseFiles(std::size_t max_depth = build_options::kMaxResponseFileDepth) noexcept;
+		void DisableResponseFiles() noexcept;
+		[[nodiscard]] bool IsResponseFilesEnabled() const noexcept;
+
+		// adds a command under the root that writes the metrics to stream, -freset clears them after
+		// they are written. enables metrics
+		CommandNode& AddStatsCommand(std::string_view name = "stats", std::ostream& stream = std::cout);
+
+		// dispatch may run on any number of threads at once, as long as the tree is not
+		// modified (or frozen/thawed) at the same time. SetCommandNode is the exception
 		int HandleCommand(int argc, const char** argv) const;
 
 		template <std::ranges::input_range Range> requires
@@ -49,12 +294,96 @@ namespace comad::command {
 			std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
 		int HandleCommand(const Range& range) const;
 
+		template <std::ranges::input_range Range> requires
+			(std::is_constructible_v<std::string_view, std::ranges::range_value_t<Range>> ||
+			std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
+		int HandleCommand(ExecutionContext& ctx, const Range& range) const;
+
 		template <typename... TArgs> requires (... && (std::is_constructible_v<std::string_view, TArgs>
 														|| std::is_convertible_v<TArgs, std::string_view>))
 		int HandleCommand(TArgs&&... args) const;
 
+		// parses on the calling thread and runs the executor on pool. the result is ready right away
+		// if parsing fails. the handler has to outlive the command, but the tree can be changed or
+		// replaced and the input released as soon as this returns
+		template <std::ranges::input_range Range> requires
+			(std::is_constructible_v<std::string_view, std::ranges::range_value_t<Range>> ||
+			std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
+		CommandFuture HandleCommandAsync(ThreadPool& pool, const Range& range) const;
+
+		// runs on ThreadPool::GetDefault()
+		template <std::ranges::input_range Range> requires
+			(std::is_constructible_v<std::string_view, std::ranges::range_value_t<Range>> ||
+			std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
+		CommandFuture HandleCommandAsync(const Range& range) const;
+
+		// every non-empty line is tokenized in place and dispatched, blank and # comment lines are
+		// skipped. on_result receives the result of each dispatched line with its 1-based line number
+		template <typename F> requires std::invocable<F&, const LineResult&>
+		std::size_t HandleBuffer(std::span<char> buffer, F&& on_result, std::size_t first_line = 1) const;
+
+		template <typename F> requires std::invocable<F&, const LineResult&>
+		void HandleStream(std::istream& stream, F&& on_result) const;
+
+		template <typename F> requires std::invocable<F&, const LineResult&>
+		void HandleFile(const std::filesystem::path& path, F&& on_result) const;
+
+		std::vector<LineResult> HandleStream(std::istream& stream) const;
+		std::vector<LineResult> HandleFile(const std::filesystem::path& path) const;
+
 	private:
 		CommandNode node_{};
+		// the published tree while frozen, either node_ or one passed to SetCommandNode
+		detail::SnapshotDomain snapshots_{};
+		// not moved with the tree, a handler always starts with an empty cache
+		mutable ResultCache cache_{};
+		bool count_uses_{ false };
+		// 0 while response files are disabled
+		std::size_t response_file_depth_{ 0 };
+		// shared with the executor of the stats command
+		std::shared_ptr<CommandMetrics> metrics_{};
+		std::shared_ptr<const Tracer> tracer_{};
+
+		// fills ctx for the command the range names in tree, or in node_ if no tree is published. returns null
+		// and sets error if it cannot be executed. sample receives the node and the lookup and parse times
+		template <std::ranges::input_range Range>
+		const CommandNode* ParseCommand(ExecutionContext& ctx, const Range& range, int& error,
+										const detail::TreeSnapshot* tree,
+										detail::DispatchSample* sample = nullptr) const;
+
+		// dispatch of input whose response files have been expanded, if they are enabled
+		template <std::ranges::input_range Range>
+		int Dispatch(ExecutionContext& ctx, const Range& range) const;
+
+		template <std::ranges::input_range Range>
+		CommandFuture DispatchAsync(ThreadPool& pool, const Range& range) const;
+
+		template <std::ranges::input_range Range>
+		int HandleCommandMeasured(ExecutionContext& ctx, const Range& range, const detail::TreeSnapshot* tree) const;
+
+		template <std::input_iterator iter>
+		const CommandNode& FindNode(const detail::TreeSnapshot* tree, iter& command_name_it, iter end_it) const;
+
+		[[nodiscard]] const CommandNode& GetRoot(const detail::TreeSnapshot* tree) const noexcept;
+
+		std::vector<Suggestion> SuggestCommand(const detail::TreeSnapshot* tree, const CommandNode& parent,
+											   std::string_view name, std::size_t count) const;
+		std::vector<Suggestion> SuggestOption(const detail::TreeSnapshot* tree, const CommandNode& node,
+											  std::string_view name, std::size_t count) const;
+		// Complete once the input has been collected, words can be walked more than once
+		std::vector<Completion> CompleteWords(std::span<const std::string_view> words, std::size_t count) const;
+
+		// the suggestions for token, which named neither a child of node nor one of its options
+		std::vector<Suggestion> Suggest(const detail::TreeSnapshot* tree, const CommandNode& node,
+										std::string_view token, std::size_t count) const;
+
+		// takes over the published tree of a handler that is moved from
+		void AdoptSnapshot(CommandHandler& other) noexcept;
+
+		// run the executor of a parsed command, through the cache if the node has a policy
+		int Execute(const CommandNode& node, const ExecutionContext& ctx) const;
+		CommandFuture ExecuteAsync(ThreadPool& pool, const CommandNode& node, const ExecutionContext& ctx,
+								   detail::SnapshotGuard pin) const;
 	};
 }
 
@@ -3,8 +3,10 @@
 
 #include <algorithm>
 #include <charconv>
+#include <cstdint>
 #include <stdexcept>
 #include <cstring>
+#include <span>
 #include <string>
 #include <string_view>
 #include <system_error>
@@ -16,6 +18,7 @@
 #include <Logger.tcc>
 
 #include "CommandHandler.h"
+#include "StringUtility.h"
 
 
 namespace comad::command {
@@ -31,15 +34,14 @@ namespace comad::command {
 		auto result = std::from_chars(first, last, var, base);
 
 		if (result.ec == std::errc::invalid_argument || result.ec == std::errc::result_out_of_range) {
-			comad_logger.MakeStream<LogLevel::ERROR>() << "failed to parse number from " <<
-				str << ": " << std::make_error_code(result.ec).message();
+			LogError("failed to parse number from ", str, ": ",
+				[&result] { return std::make_error_code(result.ec).message(); });
 			return std::nullopt;
 		}
 
 		if constexpr (!AllowPartialNumberParsing) {
-			if (*result.ptr != '\0' || result.ptr != last) {
-				comad_logger.MakeStream<LogLevel::ERROR>() << "failed to parse number from " <<
-					str << ": partial number parsing is disabled";
+			if (result.ptr != last) {
+				LogError("failed to parse number from ", str, ": partial number parsing is disabled");
 				return std::nullopt;
 			}
 		}
@@ -59,15 +61,14 @@ namespace comad::command {
 		auto result = std::from_chars(first, last, var, fmt);
 
 		if (result.ec == std::errc::invalid_argument || result.ec == std::errc::result_out_of_range) {
-			comad_logger.MakeStream<LogLevel::ERROR>() << "failed to parse number from " <<
-				str << ": " << std::make_error_code(result.ec).message();
+			LogError("failed to parse number from ", str, ": ",
+				[&result] { return std::make_error_code(result.ec).message(); });
 			return std::nullopt;
 		}
 
 		if constexpr (!AllowPartialNumberParsing) {
-			if (*result.ptr != '\0' || result.ptr != last) {
-				comad_logger.MakeStream<LogLevel::ERROR>() << "failed to parse number from " <<
-					str << ": partial number parsing is disabled";
+			if (result.ptr != last) {
+				LogError("failed to parse number from ", str, ": partial number parsing is disabled");
 				return std::nullopt;
 			}
 		}
@@ -75,6 +76,43 @@ namespace comad::command {
 		return var;
 	}
 
+	template <value::ListValueType T>
+	bool detail::AppendList(T& list, std::string_view str) {
+		using element_type = typename value::ValueTypeTraits<T>::element_type;
+
+		if (str.empty()) {
+			return true;
+		}
+
+		thread_local std::vector<std::uint32_t> separators{};
+		separators.clear();
+		utility::FindSeparators(str, build_options::ListSeparator, separators);
+
+		const std::size_t size = list.size();
+		list.reserve(size + separators.size() + 1);
+
+		std::size_t first = 0;
+		for (std::size_t i = 0; i <= separators.size(); ++i) {
+			const std::size_t last = i < separators.size() ? separators[i] : str.size();
+			const std::string_view element = str.substr(first, last - first);
+			first = last + 1;
+
+			if constexpr (std::is_same_v<element_type, std::string_view>) {
+				list.push_back(element);
+			}
+			else {
+				const std::optional<element_type> value = OptionalFromChars<element_type>(element);
+				if (value == std::nullopt) {
+					list.resize(size);
+					return false;
+				}
+				list.push_back(*value);
+			}
+		}
+
+		return true;
+	}
+
 
 	template <std::input_iterator iter> requires
 		(std::is_constructible_v<std::string_view, std::iter_value_t<iter>> ||
@@ -84,19 +122,17 @@ namespace comad::command {
 		using namespace logger;
 		using namespace build_options;
 
-		auto debug_stream = comad_logger.MakeStream<LogLevel::DEBUG>();
-
-		if constexpr(Verbose) debug_stream << "searching end node" << std::flush;
+		LogDebug("searching end node");
 
 		std::reference_wrapper<const CommandNode> current_node = std::ref(start_node);
 
 		while (command_name_it != end_it) {
 			std::string_view str{ *command_name_it };
-			if constexpr(Verbose) debug_stream << "searching for node " << str << std::flush;
+			LogDebug("searching for node ", str);
 
 			if (current_node.get().HasChildAlias(str)) {
 				str = current_node.get().GetChildNameFromAlias(str);
-				if constexpr(Verbose) debug_stream << "node was aliasing " << str << std::flush;
+				LogDebug("node was aliasing ", str);
 			}
 
 			if (!current_node.get().HasChild(str)) {
@@ -104,109 +140,407 @@ namespace comad::command {
 			}
 			else {
 				current_node = current_node.get().GetChild(str);
-				if constexpr(Verbose) debug_stream << "node " << str << " found" << std::flush;
+				LogDebug("node ", str, " found");
 				++command_name_it;
 			}
 		}
 
-		if constexpr(Verbose) debug_stream << "end node " << current_node.get().GetName() << " found" << std::flush;
+		LogDebug("end node ", current_node.get().GetName(), " found");
 		return current_node.get();
 	}
 
-	template <std::ranges::input_range Range> requires
-		(std::is_constructible_v<std::string_view, std::ranges::range_value_t<Range>> ||
-		std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
-	int CommandHandler::HandleCommand(const Range& range) const
+	template <std::input_iterator iter> requires
+		(std::is_constructible_v<std::string_view, std::iter_value_t<iter>> ||
+			std::is_convertible_v<std::iter_value_t<iter>, std::string_view>)
+	const CommandNode& detail::FindNode(const CompiledCommandTree& tree, iter& command_name_it, iter end_it)
 	{
-		using namespace detail;
-		using namespace logger;
-		using namespace build_options;
+		CompiledCommandTree::NodeId current_id = CompiledCommandTree::kRootId;
 
-		auto debug_stream = comad_logger.MakeStream<LogLevel::DEBUG>();
-
-		auto range_count = std::ranges::ssize(range);
-
-		if (range_count == 0 && !node_.GetExecutor()) {
-			if constexpr (Verbose) comad_logger.Error("no input provided");
-			return retc::kNoInput;
+		for (; command_name_it != end_it; ++command_name_it) {
+			const CompiledCommandTree::NodeId child_id = tree.FindChild(current_id, std::string_view{ *command_name_it });
+			if (child_id == CompiledCommandTree::kInvalidId) {
+				break;
+			}
+			current_id = child_id;
 		}
 
-		auto current_iterator = range.begin();
-		const CommandNode& current_node = FindNode(node_, current_iterator, range.end());
-
-		CommandExecutor executor_ = current_node.GetExecutor();
+		return tree.GetNode(current_id);
+	}
 
-		if (!executor_) {
-			if constexpr (Verbose) debug_stream << "unknown command " << current_node.GetName() << std::flush;
-			return retc::kUnknownCommand;
-		}
+	template <std::input_iterator iter, std::sentinel_for<iter> sentinel> requires
+		(std::is_constructible_v<std::string_view, std::iter_value_t<iter>> ||
+			std::is_convertible_v<std::iter_value_t<iter>, std::string_view>)
+	bool detail::ParseContext(const CommandNode& node, ExecutionContext& ctx, iter first, sentinel last, int& error,
+							  std::string_view* failed_token)
+	{
+		using namespace logger;
+		using namespace build_options;
 
-		const CommandTemplate& cmd_template = current_node.GetTemplate();
-		ExecutionContext ctx{};
+		const CommandTemplate& cmd_template = node.GetTemplate();
 		int arg_index = 0;
 
-		for (const std::string& flag_name : cmd_template.flags) {
-			ctx.flags.emplace(flag_name, false);
-		}
+		ctx.Bind(node.GetContextLayout());
 
-		for (; current_iterator != range.end(); ++current_iterator) {
+		const std::span<const Token> tokens = GetThreadTokenTable().Assign(first, last);
+		for (std::size_t i = 0; i < tokens.size(); ++i) {
+			const Token& token = tokens[i];
 			bool processing = true;
-			std::string_view element{ *current_iterator };
 
-			if (element.starts_with(FlagPrefix)) {
-				std::string_view flag_name{ element };
-				flag_name.remove_prefix(FlagPrefix.size());
+			if (token.IsFlagPrefixed()) {
+				const std::string_view flag_name = token.GetFlagName();
 
-				if (cmd_template.flags.contains(flag_name)) {
-					auto it = ctx.flags.find(flag_name);
-					it->second = true;
+				const std::size_t flag_slot = node.FindFlagSlot(flag_name);
+				if (flag_slot != kNoSlot) {
+					ctx.flags.Set(flag_slot, true);
 					processing = false;
 				}
 				else if constexpr (!SkipUnknownFlag) {
-					if constexpr (Verbose) {
-						comad_logger.MakeStream<LogLevel::ERROR>() << "unknown flag " << flag_name;
-					}
-					return retc::kUnknownFlag;
+					LogError("unknown flag ", flag_name);
+					error = retc::kUnknownFlag;
+					return false;
 				}
 			}
 
-			if (processing && current_iterator + 1 != range.end()) {
-				int ret = ParseOption(*current_iterator, *(current_iterator + 1), current_node, ctx);
-				if (ret < 0) { return ret; }
+			if (processing && token.IsOption()) {
+				const std::optional<std::string_view> value = i + 1 < tokens.size() ?
+					std::optional{ tokens[i + 1].GetText() } : std::nullopt;
+
+				int ret = Traced(kSpanParseOption, token.GetText(), [&] { return ParseOption(token, value, node, ctx); });
+				if (ret < 0) {
+					if (failed_token != nullptr) {
+						*failed_token = token.GetText();
+					}
+					error = ret;
+					return false;
+				}
 
 				if (ret == retc::kOptionParsed) {
 					processing = false;
-					++current_iterator;
+					++i;
+				}
+				else if (ret == retc::kOptionParsedInline) {
+					processing = false;
 				}
 			}
 
 			if (processing) {
 				if (arg_index < cmd_template.args.size()) {
-					auto arg_value = StringToValue(cmd_template.args[arg_index].second, *current_iterator);
+					auto arg_value = Traced(kSpanStringToValue, token.GetText(), [&] {
+						return StringToValue(cmd_template.args[arg_index].second, token.GetText());
+					});
 					if (arg_value == std::nullopt) {
 						if constexpr (!SkipInvalidValueParse) {
-							if constexpr (Verbose) comad_logger.Error("invalid argument");
-							return retc::kInvalidValueParse;
+							LogError("invalid argument");
+							error = retc::kInvalidValueParse;
+							return false;
 						}
 					}
 					else {
-						ctx.args.emplace(cmd_template.args[arg_index].first, std::move(*arg_value));
+						ctx.args.Set(arg_index, std::move(*arg_value));
 
 						++arg_index;
 					}
 				}
 				else {
-					if constexpr(CacheExtraArgs) ctx.extra_args.emplace_back(*current_iterator);
+					if constexpr(CacheExtraArgs) ctx.extra_args.emplace_back(token.GetText());
+				}
+			}
+		}
+
+		const bool has_required = Traced(kSpanRequiredCheck, {}, [&] {
+			return DispatchSample::MeasureValidation([&] { return ctx.required_option_count >= node.GetRequiredOptionCount(); });
+		});
+		if (!has_required) {
+			LogError("all required options have not been passed");
+			error = retc::kMissingRequiredOptions;
+			return false;
+		}
+
+		return true;
+	}
+
+	template <std::ranges::input_range Range> requires
+		(std::is_constructible_v<std::string_view, std::ranges::range_value_t<Range>> ||
+		std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
+	int CommandHandler::HandleCommand(const Range& range) const
+	{
+		detail::ContextLease lease{};
+		return HandleCommand(lease.Get(), range);
+	}
+
+	template <std::ranges::input_range Range>
+	bool detail::HasResponseFile(const Range& range) {
+		return std::ranges::any_of(range, [](const auto& token) {
+			const std::string_view text{ token };
+			return !text.empty() && text.front() == '@';
+		});
+	}
+
+	template <std::ranges::input_range Range>
+	bool detail::ResponseFileExpansion::Expand(const Range& range, std::size_t max_depth, int& error) {
+		tokens_.clear();
+		files_.clear();
+
+		for (const auto& token : range) {
+			if (!ExpandToken(std::string_view{ token }, 0, max_depth, error)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template <std::ranges::input_range Range> requires
+		(std::is_constructible_v<std::string_view, std::ranges::range_value_t<Range>> ||
+		std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
+	int CommandHandler::HandleCommand(ExecutionContext& ctx, const Range& range) const
+	{
+		// input ranges cannot be read twice, they are dispatched as they are
+		if constexpr (std::ranges::forward_range<Range>) {
+			if (response_file_depth_ > 0 && detail::HasResponseFile(range)) {
+				detail::ResponseFileExpansion expansion{};
+				int error = 0;
+				if (!expansion.Expand(range, response_file_depth_, error)) {
+					return error;
+				}
+				return Dispatch(ctx, expansion.Get());
+			}
+		}
+
+		return Dispatch(ctx, range);
+	}
+
+	template <std::ranges::input_range Range>
+	int CommandHandler::Dispatch(ExecutionContext& ctx, const Range& range) const
+	{
+		// the tree stays alive until the executor has returned, even if another one is set meanwhile
+		const detail::SnapshotGuard pin = snapshots_.Pin();
+
+		if constexpr (build_options::EnableMetrics || build_options::EnableTracing) {
+			if (metrics_ || tracer_) {
+				return HandleCommandMeasured(ctx, range, pin.Get());
+			}
+		}
+
+		int error = 0;
+		const CommandNode* node = ParseCommand(ctx, range, error, pin.Get());
+		if (node == nullptr) {
+			return error;
+		}
+
+		return Execute(*node, ctx);
+	}
+
+	template <std::ranges::input_range Range> requires
+		(std::is_constructible_v<std::string_view, std::ranges::range_value_t<Range>> ||
+		std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
+	CommandFuture CommandHandler::HandleCommandAsync(ThreadPool& pool, const Range& range) const
+	{
+		// the context is copied before this returns, so the files can be unmapped with the expansion
+		if constexpr (std::ranges::forward_range<Range>) {
+			if (response_file_depth_ > 0 && detail::HasResponseFile(range)) {
+				detail::ResponseFileExpansion expansion{};
+				int error = 0;
+				if (!expansion.Expand(range, response_file_depth_, error)) {
+					return CommandFuture::FromResult(error);
+				}
+				return DispatchAsync(pool, expansion.Get());
+			}
+		}
+
+		return DispatchAsync(pool, range);
+	}
+
+	template <std::ranges::input_range Range>
+	CommandFuture CommandHandler::DispatchAsync(ThreadPool& pool, const Range& range) const
+	{
+		// the pin moves into the command, so a tree swapped out before the command is done stays alive for it
+		detail::SnapshotGuard pin = snapshots_.Pin();
+		detail::ContextLease lease{};
+
+		int error = 0;
+		if constexpr (build_options::EnableMetrics || build_options::EnableTracing) {
+			if (metrics_ || tracer_) {
+				std::optional<detail::DispatchSample> sample{};
+				if (metrics_) {
+					sample.emplace();
+				}
+				detail::TraceRecorder trace{ tracer_ != nullptr && tracer_->ShouldSample() };
+
+				const CommandNode* node = ParseCommand(lease.Get(), range, error, pin.Get(), sample ? &*sample : nullptr);
+				if (sample) {
+					metrics_->Record(sample->GetNode() != nullptr ? *sample->GetNode() : GetRoot(pin.Get()),
+						node == nullptr ? error : 0, *sample);
+				}
+				if (trace.IsActive()) {
+					tracer_->Submit(trace.Finish(node != nullptr ? node->GetName() : std::string_view{}, error));
 				}
+
+				return node == nullptr ? CommandFuture::FromResult(error) :
+					ExecuteAsync(pool, *node, lease.Get(), std::move(pin));
+			}
+		}
+
+		const CommandNode* node = ParseCommand(lease.Get(), range, error, pin.Get());
+		if (node == nullptr) {
+			return CommandFuture::FromResult(error);
+		}
+
+		return ExecuteAsync(pool, *node, lease.Get(), std::move(pin));
+	}
+
+	template <std::ranges::input_range Range>
+	int CommandHandler::HandleCommandMeasured(ExecutionContext& ctx, const Range& range,
+											  const detail::TreeSnapshot* tree) const
+	{
+		using namespace detail;
+
+		std::optional<DispatchSample> sample{};
+		if (metrics_) {
+			sample.emplace();
+		}
+		TraceRecorder trace{ tracer_ != nullptr && tracer_->ShouldSample() };
+
+		int error = 0;
+		const CommandNode* node = ParseCommand(ctx, range, error, tree, sample ? &*sample : nullptr);
+		const int result = node == nullptr ? error :
+			Traced(kSpanExecutor, node->GetName(), [&] { return Execute(*node, ctx); });
+
+		if (sample) {
+			if (node == nullptr) {
+				// input without a command is counted on the root
+				metrics_->Record(sample->GetNode() != nullptr ? *sample->GetNode() : GetRoot(tree), error, *sample);
+			}
+			else {
+				sample->EndPhase(DispatchPhase::kExecutor);
+				metrics_->Record(*node, 0, *sample);
+			}
+		}
+		if (trace.IsActive()) {
+			tracer_->Submit(trace.Finish(node != nullptr ? node->GetName() : std::string_view{}, result));
+		}
+
+		return result;
+	}
+
+	template <std::ranges::input_range Range> requires
+		(std::is_constructible_v<std::string_view, std::ranges::range_value_t<Range>> ||
+		std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
+	CommandFuture CommandHandler::HandleCommandAsync(const Range& range) const
+	{
+		return HandleCommandAsync(ThreadPool::GetDefault(), range);
+	}
+
+	template <std::ranges::input_range Range>
+	const CommandNode* CommandHandler::ParseCommand(ExecutionContext& ctx, const Range& range, int& error,
+													const detail::TreeSnapshot* tree,
+													detail::DispatchSample* sample) const
+	{
+		using namespace detail;
+		using namespace logger;
+		using namespace build_options;
+
+		auto range_count = std::ranges::ssize(range);
+
+		if (range_count == 0 && !GetRoot(tree).GetExecutor()) {
+			LogError("no input provided");
+			error = retc::kNoInput;
+			return nullptr;
+		}
+
+		auto current_iterator = range.begin();
+		const CommandNode& current_node = Traced(kSpanFindNode, {}, [&]() -> const CommandNode& {
+			return FindNode(tree, current_iterator, range.end());
+		});
+
+		if constexpr (build_options::EnableMetrics) {
+			if (sample != nullptr) {
+				sample->SetNode(current_node);
+				sample->EndPhase(DispatchPhase::kLookup);
+			}
+		}
+
+		// the token that named no command or option, read again in place instead of walking the input twice
+		std::string_view failed_token{};
+
+		// only run if the message is logged
+		const auto did_you_mean = [&] {
+			const std::string suggestions = JoinSuggestions(Suggest(tree, current_node, failed_token, 3));
+			return suggestions.empty() ? suggestions : ", did you mean " + suggestions + "?";
+		};
+
+		if (!current_node.GetExecutor()) {
+			if (current_iterator != range.end()) {
+				failed_token = std::string_view{ *current_iterator };
+			}
+			LogDebug("unknown command ", current_node.GetName(), did_you_mean);
+			error = retc::kUnknownCommand;
+			return nullptr;
+		}
+
+		const bool parsed = ParseContext(current_node, ctx, current_iterator, range.end(), error, &failed_token);
+		if constexpr (build_options::EnableMetrics) {
+			if (sample != nullptr) {
+				sample->EndPhase(DispatchPhase::kParse);
 			}
 		}
 
-		if (ctx.required_option_count < current_node.GetRequiredOptionCount()) {
-			if constexpr (Verbose) comad_logger.Error("all required options have not been passed");
-			return retc::kMissingRequiredOptions;
+		if (!parsed) {
+			if (error == retc::kUnknownOption) {
+				LogDebug("unknown option for ", current_node.GetName(), did_you_mean);
+			}
+			return nullptr;
 		}
 
-		return executor_(ctx);
+		return &current_node;
+	}
+
+	template <std::input_iterator iter>
+	const CommandNode& CommandHandler::FindNode(const detail::TreeSnapshot* tree, iter& command_name_it, iter end_it) const
+	{
+		return tree != nullptr ?
+			detail::FindNode(tree->compiled, command_name_it, end_it) :
+			detail::FindNode(node_, command_name_it, end_it);
+	}
+
+	template <std::ranges::input_range Range> requires
+		(std::is_constructible_v<std::string_view, std::ranges::range_value_t<Range>> ||
+		std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
+	std::vector<Suggestion> CommandHandler::Suggest(const Range& range, std::size_t count) const
+	{
+		using namespace detail;
+
+		const SnapshotGuard pin = snapshots_.Pin();
+		auto it = range.begin();
+		const CommandNode& node = FindNode(pin.Get(), it, range.end());
+
+		if (it == range.end()) {
+			return {};
+		}
+		if (!node.GetExecutor()) {
+			return Suggest(pin.Get(), node, std::string_view{ *it }, count);
+		}
+
+		for (; it != range.end(); ++it) {
+			const std::string_view token{ *it };
+			if (!GetUnknownOptionName(node, Token::Classify(token)).empty()) {
+				return Suggest(pin.Get(), node, token, count);
+			}
+		}
+
+		return {};
+	}
+
+	template <std::ranges::input_range Range> requires
+		(std::is_constructible_v<std::string_view, std::ranges::range_value_t<Range>> ||
+		std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
+	std::vector<Completion> CommandHandler::Complete(const Range& partial_argv, std::size_t count) const
+	{
+		// the word being typed is the last one, the input is collected so that a single pass range will do
+		std::vector<std::string_view> words{};
+		for (auto&& word : partial_argv) {
+			words.emplace_back(word);
+		}
+		return CompleteWords(words, count);
 	}
 
 	template <typename... TArgs> requires (... && (std::is_constructible_v<std::string_view, TArgs>
@@ -234,6 +568,79 @@ namespace comad::command {
 
 		return HandleCommand(arg_vector);
 	}
+
+	template <typename F> requires std::invocable<F&, const LineResult&>
+	std::size_t CommandHandler::HandleBuffer(std::span<char> buffer, F&& on_result, std::size_t first_line) const {
+		using namespace logger;
+
+		detail::ContextLease lease{};
+		std::vector<std::string_view> tokens{};
+		std::size_t line_number = first_line;
+
+		char* it = buffer.data();
+		char* const end = it + buffer.size();
+		for (; it != end; ++line_number) {
+			char* line_end = static_cast<char*>(std::memchr(it, '\n', end - it));
+			char* const next = line_end == nullptr ? end : line_end + 1;
+			if (line_end == nullptr) {
+				line_end = end;
+			}
+
+			if (!utility::TokenizeLine(std::span<char>{ it, line_end }, tokens)) {
+				LogError("malformed command on line ", line_number);
+				on_result(LineResult{ line_number, retc::kMalformedLine });
+			}
+			else if (!tokens.empty()) {
+				const int result = HandleCommand(lease.Get(), tokens);
+				if (result < 0) {
+					LogError("command on line ", line_number, " failed with ", result);
+				}
+				on_result(LineResult{ line_number, result });
+			}
+
+			it = next;
+		}
+
+		return line_number - first_line;
+	}
+
+	template <typename F> requires std::invocable<F&, const LineResult&>
+	void CommandHandler::HandleStream(std::istream& stream, F&& on_result) const {
+		constexpr std::size_t kInitialBufferSize = 1 << 20;
+
+		std::vector<char> buffer(kInitialBufferSize);
+		std::size_t filled = 0;
+		std::size_t line_number = 1;
+
+		while (stream) {
+			stream.read(buffer.data() + filled, static_cast<std::streamsize>(buffer.size() - filled));
+			filled += static_cast<std::size_t>(stream.gcount());
+
+			// only whole lines are dispatched, the partial last line is carried over to the next read
+			const auto last_newline = std::find(std::make_reverse_iterator(buffer.begin() + filled),
+			                                    buffer.rend(), '\n');
+			if (last_newline == buffer.rend()) {
+				if (filled == buffer.size()) {
+					buffer.resize(buffer.size() * 2);
+				}
+				continue;
+			}
+
+			const std::size_t complete = static_cast<std::size_t>(buffer.rend() - last_newline);
+			line_number += HandleBuffer(std::span<char>{ buffer.data(), complete }, on_result, line_number);
+
+			std::memmove(buffer.data(), buffer.data() + complete, filled - complete);
+			filled -= complete;
+		}
+
+		HandleBuffer(std::span<char>{ buffer.data(), filled }, on_result, line_number);
+	}
+
+	template <typename F> requires std::invocable<F&, const LineResult&>
+	void CommandHandler::HandleFile(const std::filesystem::path& path, F&& on_result) const {
+		detail::MappedFile file{ path };
+		HandleBuffer(file.Get(), on_result);
+	}
 }
 
 #endif
\ No newline at end of file
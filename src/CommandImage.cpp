@@ -0,0 +1,508 @@
+#include "CommandImage.h"
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <ranges>
+#include <set>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include "StringUtility.h"
+
+namespace comad::command {
+	using namespace value;
+	using namespace detail;
+
+	namespace {
+		constexpr std::uint32_t kByteOrder = 0x01020304;
+		constexpr std::size_t kSectionAlignment = 8;
+
+		template <typename F>
+		decltype(auto) WithValueType(ValueType type, F&& f) {
+			switch (type) {
+				case ValueType::kBool: return f(std::type_identity<bool>{});
+				case ValueType::kInt: return f(std::type_identity<int>{});
+				case ValueType::kFloat: return f(std::type_identity<float>{});
+				case ValueType::kString: return f(std::type_identity<std::string>{});
+				case ValueType::kInt64: return f(std::type_identity<std::int64_t>{});
+				case ValueType::kUInt64: return f(std::type_identity<std::uint64_t>{});
+				case ValueType::kDouble: return f(std::type_identity<double>{});
+				case ValueType::kByteSize: return f(std::type_identity<ByteSize>{});
+				case ValueType::kDuration: return f(std::type_identity<Duration>{});
+				default: throw std::runtime_error{ "command image holds an unknown value type" };
+			}
+		}
+
+		ValueType ToValueType(std::uint32_t type) {
+			if (type > static_cast<std::uint32_t>(ValueType::kStringList)) {
+				throw std::runtime_error{ "command image holds an unknown value type" };
+			}
+			return static_cast<ValueType>(type);
+		}
+
+		std::uint32_t ToCount(std::size_t count, const char* what) {
+			if (count > std::numeric_limits<std::uint32_t>::max()) {
+				throw std::length_error{ std::string{ "command tree has too many " } + what + " for an image" };
+			}
+			return static_cast<std::uint32_t>(count);
+		}
+
+		void CheckRange(std::uint32_t first, std::uint32_t count, std::uint32_t size) {
+			if (std::uint64_t{ first } + count > size) {
+				throw std::runtime_error{ "command image record is out of bounds" };
+			}
+		}
+
+		class ImageWriter {
+		public:
+			ImageString AddString(std::string_view str) {
+				const ImageString image_string{ ToCount(strings_.size(), "strings"), ToCount(str.size(), "strings") };
+				ToCount(strings_.size() + str.size(), "strings");
+				strings_.append(str);
+				return image_string;
+			}
+
+			ImageValue AddValue(const ValueWrapper& value) {
+				ImageValue image_value{ static_cast<std::uint32_t>(value.GetType()), 0, 0 };
+				switch (value.GetType()) {
+					case ValueType::kBool: image_value.bits = value.GetValue<bool>(); break;
+					case ValueType::kInt:
+						image_value.bits = static_cast<std::uint64_t>(static_cast<std::int64_t>(value.GetValue<int>()));
+						break;
+					case ValueType::kFloat: image_value.bits = std::bit_cast<std::uint32_t>(value.GetValue<float>()); break;
+					case ValueType::kInt64:
+						image_value.bits = static_cast<std::uint64_t>(value.GetValue<std::int64_t>());
+						break;
+					case ValueType::kUInt64: image_value.bits = value.GetValue<std::uint64_t>(); break;
+					case ValueType::kDouble: image_value.bits = std::bit_cast<std::uint64_t>(value.GetValue<double>()); break;
+					case ValueType::kByteSize: image_value.bits = value.GetValue<ByteSize>().bytes; break;
+					case ValueType::kDuration:
+						image_value.bits = static_cast<std::uint64_t>(value.GetValue<Duration>().count());
+						break;
+					case ValueType::kString: {
+						const ImageString str = AddString(value.GetStringView());
+						image_value.bits = str.offset;
+						image_value.length = str.length;
+						break;
+					}
+					default: throw std::invalid_argument{ "value of unknown type cannot be written to an image" };
+				}
+				return image_value;
+			}
+
+			void AddNode(const CommandNode& node) {
+				if (node.GetExecutor() && node.GetExecutorId().empty()) {
+					throw std::invalid_argument{ "command " + std::string{ node.GetName() } +
+						" has an executor without an executor id" };
+				}
+
+				const CommandTemplate& cmd_template = node.GetTemplate();
+				ImageNode record{
+					.name = AddString(node.GetName()),
+					.executor_id = AddString(node.GetExecutorId()),
+					.description = AddString(cmd_template.description),
+					.first_flag = ToCount(flags_.size(), "flags"),
+					.flag_count = ToCount(cmd_template.flags.size(), "flags"),
+					.first_option = ToCount(options_.size(), "options"),
+					.option_count = ToCount(cmd_template.options.size(), "options"),
+					.first_arg = ToCount(args_.size(), "arguments"),
+					.arg_count = ToCount(cmd_template.args.size(), "arguments")
+				};
+
+				for (const CommandFlag& flag : cmd_template.flags) {
+					flags_.push_back(AddString(flag));
+				}
+
+				for (const auto& [name, option] : cmd_template.options) {
+					const SupportedValueHolder& supported = option.supported_values;
+					ImageOption image_option{
+						.name = AddString(name),
+						.first_value = ToCount(values_.size(), "values"),
+						.value_count = 0,
+						// list options are written with their list type, the constraint is on the elements
+						.type = static_cast<std::uint8_t>(option.GetValueType()),
+						.constraint = ImageConstraint::kType,
+						.short_name = option.short_name,
+						.required = option.required
+					};
+
+					if (const ValueBounds* bounds = supported.GetBounds()) {
+						image_option.constraint = ImageConstraint::kBounds;
+						values_.push_back(AddValue(bounds->GetMin()));
+						values_.push_back(AddValue(bounds->GetMax()));
+					}
+					else if (supported.IsList()) {
+						image_option.constraint = ImageConstraint::kList;
+						for (const ValueWrapper& value : supported.GetListedValues()) {
+							values_.push_back(AddValue(value));
+						}
+					}
+					image_option.value_count = ToCount(values_.size() - image_option.first_value, "values");
+					options_.push_back(image_option);
+				}
+
+				for (const auto& [name, type] : cmd_template.args) {
+					args_.push_back(ImageArgument{ AddString(name), static_cast<std::uint32_t>(type) });
+				}
+
+				nodes_.push_back(record);
+			}
+
+			// the edge names go in as one block, so the slots keep their offsets into it
+			void AddLookup(std::string_view names, std::vector<std::uint32_t> displacements, std::vector<ImageSlot> slots) {
+				const ImageString block = AddString(names);
+				for (ImageSlot& slot : slots) {
+					slot.name.offset += block.offset;
+				}
+				displacements_ = std::move(displacements);
+				slots_ = std::move(slots);
+			}
+
+			std::vector<std::byte> Finish() {
+				ImageHeader header{
+					.magic = CommandImage::kMagic,
+					.version = CommandImage::kVersion,
+					.byte_order = kByteOrder,
+					.size = 0,
+					.node_count = ToCount(nodes_.size(), "nodes"),
+					.flag_count = ToCount(flags_.size(), "flags"),
+					.option_count = ToCount(options_.size(), "options"),
+					.arg_count = ToCount(args_.size(), "arguments"),
+					.value_count = ToCount(values_.size(), "values"),
+					.bucket_count = ToCount(displacements_.size(), "buckets"),
+					.slot_count = ToCount(slots_.size(), "slots"),
+					.string_size = ToCount(strings_.size(), "strings"),
+					// the sections are placed below, once the header has been reserved
+					.nodes = 0,
+					.flags = 0,
+					.options = 0,
+					.args = 0,
+					.values = 0,
+					.displacements = 0,
+					.slots = 0,
+					.strings = 0
+				};
+
+				image_.resize(sizeof(ImageHeader));
+				header.nodes = Append(nodes_);
+				header.flags = Append(flags_);
+				header.options = Append(options_);
+				header.args = Append(args_);
+				header.values = Append(values_);
+				header.displacements = Append(displacements_);
+				header.slots = Append(slots_);
+				header.strings = Append(strings_);
+				header.size = image_.size();
+
+				std::memcpy(image_.data(), &header, sizeof(header));
+				return std::move(image_);
+			}
+
+		private:
+			std::vector<ImageNode> nodes_{};
+			std::vector<ImageString> flags_{};
+			std::vector<ImageOption> options_{};
+			std::vector<ImageArgument> args_{};
+			std::vector<ImageValue> values_{};
+			std::vector<std::uint32_t> displacements_{};
+			std::vector<ImageSlot> slots_{};
+			std::string strings_{};
+			std::vector<std::byte> image_{};
+
+			template <std::ranges::contiguous_range Records>
+			std::uint64_t Append(const Records& records) {
+				const std::span bytes = std::as_bytes(std::span{ records });
+				const std::size_t offset = (image_.size() + kSectionAlignment - 1) / kSectionAlignment * kSectionAlignment;
+				image_.resize(offset + bytes.size());
+				if (!bytes.empty()) {
+					std::memcpy(image_.data() + offset, bytes.data(), bytes.size());
+				}
+				return offset;
+			}
+		};
+	}
+
+	bool ExecutorRegistry::Register(std::string id, CommandExecutor executor) {
+		return executors_.try_emplace(std::move(id), std::move(executor)).second;
+	}
+
+	const CommandExecutor* ExecutorRegistry::Find(std::string_view id) const noexcept {
+		auto it = executors_.find(id);
+		return it == executors_.end() ? nullptr : &it->second;
+	}
+
+	std::size_t ExecutorRegistry::GetSize() const noexcept {
+		return executors_.size();
+	}
+
+	void ExecutorRegistry::Bind(CommandNode& node, std::string_view id) const {
+		const CommandExecutor* executor = Find(id);
+		if (executor == nullptr) {
+			throw std::out_of_range{ "no executor is registered as " + std::string{ id } };
+		}
+
+		node.SetExecutor(*executor);
+		node.SetExecutorId(std::string{ id });
+	}
+
+	std::size_t ExecutorRegistry::IdHash::operator()(std::string_view id) const noexcept {
+		return static_cast<std::size_t>(utility::HashString(id));
+	}
+
+	std::vector<std::byte> CommandImage::Serialize(const CommandNode& root) {
+		const CompiledCommandTree tree{ root };
+
+		ImageWriter writer{};
+		for (const CommandNode* node : tree.nodes_) {
+			writer.AddNode(*node);
+		}
+
+		std::vector<ImageSlot> slots{};
+		slots.reserve(tree.slots_.size());
+		for (const CompiledCommandTree::Slot& slot : tree.slots_) {
+			slots.push_back(ImageSlot{ slot.parent, slot.child, ImageString{ slot.name_offset, slot.name_length } });
+		}
+		writer.AddLookup(tree.names_, tree.displacements_, std::move(slots));
+
+		return writer.Finish();
+	}
+
+	void CommandImage::Save(const CommandNode& root, const std::filesystem::path& path) {
+		const std::vector<std::byte> image = Serialize(root);
+
+		std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+		file.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+		if (!file) {
+			throw std::system_error{ std::make_error_code(std::errc::io_error), "failed to write " + path.string() };
+		}
+	}
+
+	CommandImage::CommandImage(const std::filesystem::path& path, const ExecutorRegistry& registry) :
+		file_{ std::make_unique<MappedFile>(path) },
+		registry_{ &registry }
+	{
+		Attach(std::as_bytes(file_->Get()));
+	}
+
+	CommandImage::CommandImage(std::span<const std::byte> image, const ExecutorRegistry& registry) :
+		owned_{ image.begin(), image.end() },
+		registry_{ &registry }
+	{
+		Attach(owned_);
+	}
+
+	void CommandImage::Attach(std::span<const std::byte> data) {
+		if (data.size() < sizeof(ImageHeader)) {
+			throw std::runtime_error{ "command image is truncated" };
+		}
+		if (reinterpret_cast<std::uintptr_t>(data.data()) % alignof(ImageHeader) != 0) {
+			throw std::runtime_error{ "command image is misaligned" };
+		}
+
+		header_ = reinterpret_cast<const ImageHeader*>(data.data());
+		if (header_->magic != kMagic) {
+			throw std::runtime_error{ "data is not a command image" };
+		}
+		if (header_->byte_order != kByteOrder) {
+			throw std::runtime_error{ "command image was written with another byte order" };
+		}
+		if (header_->version != kVersion) {
+			throw std::runtime_error{ "command image version " + std::to_string(header_->version) + " is not supported" };
+		}
+		if (header_->size != data.size()) {
+			throw std::runtime_error{ "command image is truncated" };
+		}
+		if (header_->node_count == 0) {
+			throw std::runtime_error{ "command image has no root" };
+		}
+		if (header_->slot_count != 0 &&
+			(!std::has_single_bit(header_->bucket_count) || !std::has_single_bit(header_->slot_count))) {
+			throw std::runtime_error{ "command image has a malformed lookup table" };
+		}
+
+		const auto section = [&data]<typename T>(std::type_identity<T>, std::uint64_t offset, std::uint64_t count) {
+			if (offset % alignof(T) != 0 || offset > data.size() || count > (data.size() - offset) / sizeof(T)) {
+				throw std::runtime_error{ "command image section is out of bounds" };
+			}
+			return reinterpret_cast<const T*>(data.data() + offset);
+		};
+
+		nodes_ = section(std::type_identity<ImageNode>{}, header_->nodes, header_->node_count);
+		flags_ = section(std::type_identity<ImageString>{}, header_->flags, header_->flag_count);
+		options_ = section(std::type_identity<ImageOption>{}, header_->options, header_->option_count);
+		args_ = section(std::type_identity<ImageArgument>{}, header_->args, header_->arg_count);
+		values_ = section(std::type_identity<ImageValue>{}, header_->values, header_->value_count);
+		displacements_ = section(std::type_identity<std::uint32_t>{}, header_->displacements, header_->bucket_count);
+		slots_ = section(std::type_identity<ImageSlot>{}, header_->slots, header_->slot_count);
+		strings_ = section(std::type_identity<char>{}, header_->strings, header_->string_size);
+		data_ = data;
+	}
+
+	std::size_t CommandImage::GetNodeCount() const noexcept {
+		return header_->node_count;
+	}
+
+	std::size_t CommandImage::GetSize() const noexcept {
+		return data_.size();
+	}
+
+	std::string_view CommandImage::GetName(NodeId id) const {
+		if (id >= header_->node_count) {
+			throw std::out_of_range{ "command image has no node " + std::to_string(id) };
+		}
+		return GetString(nodes_[id].name);
+	}
+
+	bool CommandImage::HasExecutor(NodeId id) const {
+		if (id >= header_->node_count) {
+			throw std::out_of_range{ "command image has no node " + std::to_string(id) };
+		}
+		return nodes_[id].executor_id.length != 0;
+	}
+
+	const CommandNode& CommandImage::GetNode(NodeId id) const {
+		if (id >= header_->node_count) {
+			throw std::out_of_range{ "command image has no node " + std::to_string(id) };
+		}
+
+		{
+			std::shared_lock lock{ materialized_mutex_ };
+			auto it = materialized_.find(id);
+			if (it != materialized_.end()) {
+				return *it->second;
+			}
+		}
+
+		// built outside the lock, a node built twice by racing threads is only kept once
+		std::unique_ptr<CommandNode> node = Materialize(id);
+
+		std::lock_guard lock{ materialized_mutex_ };
+		return *materialized_.try_emplace(id, std::move(node)).first->second;
+	}
+
+	int CommandImage::HandleCommand(int argc, const char** argv) const {
+		return HandleCommand(std::span<const char*>(argv, argc));
+	}
+
+	std::string_view CommandImage::GetString(ImageString str) const {
+		CheckRange(str.offset, str.length, header_->string_size);
+		return std::string_view{ strings_ + str.offset, str.length };
+	}
+
+	ValueWrapper CommandImage::GetValue(const ImageValue& value) const {
+		return WithValueType(ToValueType(value.type), [&]<typename T>(std::type_identity<T>) {
+			if constexpr (std::is_same_v<T, bool>) {
+				return ValueWrapper{ value.bits != 0 };
+			}
+			else if constexpr (std::is_same_v<T, int>) {
+				return ValueWrapper{ static_cast<int>(static_cast<std::int64_t>(value.bits)) };
+			}
+			else if constexpr (std::is_same_v<T, float>) {
+				return ValueWrapper{ std::bit_cast<float>(static_cast<std::uint32_t>(value.bits)) };
+			}
+			else if constexpr (std::is_same_v<T, std::int64_t>) {
+				return ValueWrapper{ static_cast<std::int64_t>(value.bits) };
+			}
+			else if constexpr (std::is_same_v<T, std::uint64_t>) {
+				return ValueWrapper{ value.bits };
+			}
+			else if constexpr (std::is_same_v<T, double>) {
+				return ValueWrapper{ std::bit_cast<double>(value.bits) };
+			}
+			else if constexpr (std::is_same_v<T, ByteSize>) {
+				return ValueWrapper{ ByteSize{ value.bits } };
+			}
+			else if constexpr (std::is_same_v<T, Duration>) {
+				return ValueWrapper{ Duration{ static_cast<Duration::rep>(value.bits) } };
+			}
+			else {
+				if (value.bits > std::numeric_limits<std::uint32_t>::max()) {
+					throw std::runtime_error{ "command image record is out of bounds" };
+				}
+				return ValueWrapper{ std::string{
+					GetString(ImageString{ static_cast<std::uint32_t>(value.bits), value.length }) } };
+			}
+		});
+	}
+
+	CommandOption CommandImage::GetOption(const ImageOption& option) const {
+		const ValueType option_type = ToValueType(option.type);
+		CommandOption command_option{ .short_name = option.short_name, .required = option.required != 0,
+			.list = IsListType(option_type) };
+		const ValueType type = command_option.list ? ElementType(option_type) : option_type;
+
+		CheckRange(option.first_value, option.value_count, header_->value_count);
+		const std::span<const ImageValue> values{ values_ + option.first_value, option.value_count };
+
+		switch (option.constraint) {
+			case ImageConstraint::kType:
+				command_option.supported_values = SupportedValueHolder{ type };
+				break;
+			case ImageConstraint::kBounds:
+				if (values.size() != 2) {
+					throw std::runtime_error{ "command image has malformed option bounds" };
+				}
+				command_option.supported_values = WithValueType(type, [&]<typename T>(std::type_identity<T>) {
+					return SupportedValueHolder{ ValueBounds{
+						GetValue(values[0]).GetValue<T>(), GetValue(values[1]).GetValue<T>() } };
+				});
+				break;
+			case ImageConstraint::kList:
+				command_option.supported_values = WithValueType(type, [&]<typename T>(std::type_identity<T>) {
+					std::set<T> listed{};
+					for (const ImageValue& value : values) {
+						listed.insert(GetValue(value).GetValue<T>());
+					}
+					return SupportedValueHolder{ std::move(listed) };
+				});
+				break;
+			default: throw std::runtime_error{ "command image has an unknown option constraint" };
+		}
+
+		return command_option;
+	}
+
+	std::unique_ptr<CommandNode> CommandImage::Materialize(NodeId id) const {
+		const ImageNode& record = nodes_[id];
+		CheckRange(record.first_flag, record.flag_count, header_->flag_count);
+		CheckRange(record.first_option, record.option_count, header_->option_count);
+		CheckRange(record.first_arg, record.arg_count, header_->arg_count);
+
+		CommandTemplate cmd_template{};
+		cmd_template.description = GetString(record.description);
+
+		for (std::uint32_t i = 0; i < record.flag_count; ++i) {
+			cmd_template.flags.emplace(GetString(flags_[record.first_flag + i]));
+		}
+
+		for (std::uint32_t i = 0; i < record.option_count; ++i) {
+			const ImageOption& option = options_[record.first_option + i];
+			cmd_template.options.emplace(GetString(option.name), GetOption(option));
+		}
+
+		cmd_template.args.reserve(record.arg_count);
+		for (std::uint32_t i = 0; i < record.arg_count; ++i) {
+			const ImageArgument& arg = args_[record.first_arg + i];
+			cmd_template.args.emplace_back(std::string{ GetString(arg.name) }, ToValueType(arg.type));
+		}
+
+		CommandExecutor executor{};
+		const std::string_view executor_id = GetString(record.executor_id);
+		if (!executor_id.empty()) {
+			const CommandExecutor* registered = registry_->Find(executor_id);
+			if (registered == nullptr) {
+				throw std::out_of_range{ "no executor is registered as " + std::string{ executor_id } };
+			}
+			executor = *registered;
+		}
+
+		auto node = std::make_unique<CommandNode>(std::move(cmd_template), std::move(executor));
+		node->SetExecutorId(std::string{ executor_id });
+		return node;
+	}
+}
@@ -0,0 +1,203 @@
+#ifndef COMAD_COMMAND_IMAGE_H_
+#define COMAD_COMMAND_IMAGE_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <ranges>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "Command.h"
+#include "CommandHandler.h"
+#include "CommandNode.h"
+#include "CompiledCommandTree.h"
+
+namespace comad::command {
+	// binds the executors of loaded images by the ids their nodes were written with
+	class ExecutorRegistry {
+	public:
+		// false if id is taken, the executor registered first is kept
+		bool Register(std::string id, CommandExecutor executor);
+
+		[[nodiscard]] const CommandExecutor* Find(std::string_view id) const noexcept;
+		[[nodiscard]] std::size_t GetSize() const noexcept;
+
+		// sets the executor registered as id and the id on node, throws std::out_of_range if there is none
+		void Bind(CommandNode& node, std::string_view id) const;
+
+	private:
+		struct IdHash {
+			using is_transparent = void;
+			std::size_t operator()(std::string_view id) const noexcept;
+		};
+
+		std::unordered_map<std::string, CommandExecutor, IdHash, std::equal_to<>> executors_{ };
+	};
+
+	namespace detail {
+		// the layout of an image, every record refers to others by index and to strings by offset
+		struct ImageString {
+			std::uint32_t offset;
+			std::uint32_t length;
+		};
+
+		struct ImageHeader {
+			std::array<char, 8> magic;
+			std::uint32_t version;
+			std::uint32_t byte_order;
+			std::uint64_t size;
+
+			std::uint32_t node_count;
+			std::uint32_t flag_count;
+			std::uint32_t option_count;
+			std::uint32_t arg_count;
+			std::uint32_t value_count;
+			std::uint32_t bucket_count;
+			std::uint32_t slot_count;
+			std::uint32_t string_size;
+
+			std::uint64_t nodes;
+			std::uint64_t flags;
+			std::uint64_t options;
+			std::uint64_t args;
+			std::uint64_t values;
+			std::uint64_t displacements;
+			std::uint64_t slots;
+			std::uint64_t strings;
+		};
+
+		struct ImageNode {
+			ImageString name;
+			ImageString executor_id;
+			ImageString description;
+			std::uint32_t first_flag;
+			std::uint32_t flag_count;
+			std::uint32_t first_option;
+			std::uint32_t option_count;
+			std::uint32_t first_arg;
+			std::uint32_t arg_count;
+		};
+
+		enum class ImageConstraint : std::uint8_t {
+			kType,
+			kBounds,
+			kList
+		};
+
+		struct ImageOption {
+			ImageString name;
+			std::uint32_t first_value;
+			std::uint32_t value_count;
+			std::uint8_t type;
+			ImageConstraint constraint;
+			char short_name;
+			std::uint8_t required;
+		};
+
+		struct ImageArgument {
+			ImageString name;
+			std::uint32_t type;
+		};
+
+		// bool, int and float values are kept in bits, strings refer to the string section
+		struct ImageValue {
+			std::uint32_t type;
+			std::uint32_t length;
+			std::uint64_t bits;
+		};
+
+		// an edge of the compiled tree, aliases are edges of their own
+		struct ImageSlot {
+			std::uint32_t parent;
+			std::uint32_t child;
+			ImageString name;
+		};
+	}
+
+	// a command tree written as one block without pointers, so it can be mapped from a file and
+	// dispatched from where it lies. lookups run on the perfect hash of CompiledCommandTree inside
+	// the block, only the node a command resolves to is turned back into a CommandNode, the first
+	// time it is dispatched. images are only read by builds of the same byte order and version
+	class CommandImage {
+	public:
+		using NodeId = CompiledCommandTree::NodeId;
+
+		static constexpr std::array<char, 8> kMagic{ 'C', 'O', 'M', 'A', 'D', 'I', 'M', 'G' };
+		static constexpr std::uint32_t kVersion = 1;
+		static constexpr NodeId kRootId = CompiledCommandTree::kRootId;
+		static constexpr NodeId kInvalidId = CompiledCommandTree::kInvalidId;
+
+		// every node with an executor has to have an executor id. cache policies are not written,
+		// throws std::invalid_argument for a node without an id
+		static std::vector<std::byte> Serialize(const CommandNode& root);
+		static void Save(const CommandNode& root, const std::filesystem::path& path);
+
+		// the registry has to outlive the image. throws std::runtime_error if the data is not an
+		// image of this version
+		CommandImage(const std::filesystem::path& path, const ExecutorRegistry& registry);
+		CommandImage(std::span<const std::byte> image, const ExecutorRegistry& registry);
+
+		CommandImage(const CommandImage&) = delete;
+		CommandImage& operator=(const CommandImage&) = delete;
+
+		[[nodiscard]] std::size_t GetNodeCount() const noexcept;
+		[[nodiscard]] std::size_t GetSize() const noexcept;
+
+		[[nodiscard]] NodeId FindChild(NodeId parent, std::string_view name) const noexcept;
+		[[nodiscard]] std::string_view GetName(NodeId id) const;
+		[[nodiscard]] bool HasExecutor(NodeId id) const;
+		// throws std::out_of_range if the executor id of the node is not registered
+		[[nodiscard]] const CommandNode& GetNode(NodeId id) const;
+
+		// same results as CommandHandler::HandleCommand on the tree the image was made from,
+		// without its result cache
+		int HandleCommand(int argc, const char** argv) const;
+
+		template <std::ranges::input_range Range> requires
+			(std::is_constructible_v<std::string_view, std::ranges::range_value_t<Range>> ||
+			std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
+		int HandleCommand(const Range& range) const;
+
+		template <std::ranges::input_range Range> requires
+			(std::is_constructible_v<std::string_view, std::ranges::range_value_t<Range>> ||
+			std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
+		int HandleCommand(ExecutionContext& ctx, const Range& range) const;
+
+	private:
+		std::unique_ptr<detail::MappedFile> file_{ };
+		std::vector<std::byte> owned_{ };
+		std::span<const std::byte> data_{ };
+		const ExecutorRegistry* registry_;
+
+		const detail::ImageHeader* header_{ nullptr };
+		const detail::ImageNode* nodes_{ nullptr };
+		const detail::ImageString* flags_{ nullptr };
+		const detail::ImageOption* options_{ nullptr };
+		const detail::ImageArgument* args_{ nullptr };
+		const detail::ImageValue* values_{ nullptr };
+		const std::uint32_t* displacements_{ nullptr };
+		const detail::ImageSlot* slots_{ nullptr };
+		const char* strings_{ nullptr };
+
+		mutable std::shared_mutex materialized_mutex_{ };
+		mutable std::unordered_map<NodeId, std::unique_ptr<CommandNode>> materialized_{ };
+
+		void Attach(std::span<const std::byte> data);
+		[[nodiscard]] std::string_view GetString(detail::ImageString str) const;
+		[[nodiscard]] value::ValueWrapper GetValue(const detail::ImageValue& value) const;
+		[[nodiscard]] CommandOption GetOption(const detail::ImageOption& option) const;
+		[[nodiscard]] std::unique_ptr<CommandNode> Materialize(NodeId id) const;
+	};
+}
+
+#include "CommandImage.tcc"
+#endif
@@ -0,0 +1,84 @@
+#ifndef COMAD_COMMAND_IMAGE_TCC_
+#define COMAD_COMMAND_IMAGE_TCC_
+
+#include <cstring>
+#include <iterator>
+#include <string_view>
+
+#include <ComadReturnCodes.h>
+#include <Logger.tcc>
+
+#include "CommandImage.h"
+#include "StringUtility.h"
+
+namespace comad::command {
+	inline CommandImage::NodeId CommandImage::FindChild(NodeId parent, std::string_view name) const noexcept {
+		if (header_->slot_count == 0) {
+			return kInvalidId;
+		}
+
+		const std::uint64_t hash = utility::HashString(name, parent);
+		const std::uint32_t displacement = displacements_[(hash >> 32) & (header_->bucket_count - 1)];
+		const detail::ImageSlot& slot =
+			slots_[utility::PerfectHash::SlotHash(hash, displacement) & (header_->slot_count - 1)];
+
+		// slots are only checked when they match, so a corrupt one cannot point outside the image
+		if (slot.parent != parent || slot.name.length != name.size() || slot.child >= header_->node_count ||
+			std::uint64_t{ slot.name.offset } + slot.name.length > header_->string_size ||
+			std::memcmp(strings_ + slot.name.offset, name.data(), name.size()) != 0) {
+			return kInvalidId;
+		}
+
+		return slot.child;
+	}
+
+	template <std::ranges::input_range Range> requires
+		(std::is_constructible_v<std::string_view, std::ranges::range_value_t<Range>> ||
+		std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
+	int CommandImage::HandleCommand(const Range& range) const
+	{
+		detail::ContextLease lease{};
+		return HandleCommand(lease.Get(), range);
+	}
+
+	template <std::ranges::input_range Range> requires
+		(std::is_constructible_v<std::string_view, std::ranges::range_value_t<Range>> ||
+		std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
+	int CommandImage::HandleCommand(ExecutionContext& ctx, const Range& range) const
+	{
+		using namespace logger;
+
+		auto current_iterator = std::ranges::begin(range);
+		const auto end = std::ranges::end(range);
+
+		if (current_iterator == end && !HasExecutor(kRootId)) {
+			LogError("no input provided");
+			return retc::kNoInput;
+		}
+
+		NodeId current_id = kRootId;
+		for (; current_iterator != end; ++current_iterator) {
+			const NodeId child_id = FindChild(current_id, std::string_view{ *current_iterator });
+			if (child_id == kInvalidId) {
+				break;
+			}
+			current_id = child_id;
+		}
+
+		// commands without an executor are rejected before their node is built
+		if (!HasExecutor(current_id)) {
+			LogDebug("unknown command ", GetName(current_id));
+			return retc::kUnknownCommand;
+		}
+
+		const CommandNode& node = GetNode(current_id);
+		int error = 0;
+		if (!detail::ParseContext(node, ctx, current_iterator, end, error)) {
+			return error;
+		}
+
+		return node.GetExecutor()(ctx);
+	}
+}
+
+#endif
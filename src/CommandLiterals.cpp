@@ -6,4 +6,10 @@ namespace comad::literals {
 
 		return *this;
 	}
+
+	CommandOptionLiteral& CommandOptionLiteral::AsList() {
+		option_.AsList();
+
+		return *this;
+	}
 }
@@ -13,6 +13,13 @@ namespace comad::literals {
 	constexpr command::CommandArgument operator""_ai(const char* name, std::size_t size);
 	constexpr command::CommandArgument operator""_af(const char* name, std::size_t size);
 	constexpr command::CommandArgument operator""_as(const char* name, std::size_t size);
+	constexpr command::CommandArgument operator""_al(const char* name, std::size_t size);
+	constexpr command::CommandArgument operator""_au(const char* name, std::size_t size);
+	constexpr command::CommandArgument operator""_ad(const char* name, std::size_t size);
+	// a byte size such as 64MiB
+	constexpr command::CommandArgument operator""_az(const char* name, std::size_t size);
+	// a duration such as 250ms
+	constexpr command::CommandArgument operator""_at(const char* name, std::size_t size);
 
 	class CommandOptionLiteral {
 	public:
@@ -21,6 +28,8 @@ namespace comad::literals {
 
 		CommandOptionLiteral& operator[](bool is_required);
 
+		CommandOptionLiteral& AsList();
+
 		constexpr operator std::pair<std::string_view, command::CommandOption>() const;
 	private:
 		std::string_view name_{};
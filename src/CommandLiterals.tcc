@@ -49,6 +49,56 @@ namespace comad::literals {
 		}
 		return command::CommandArgument{ std::string{ str }, value::ValueType::kString };
 	}
+	constexpr command::CommandArgument operator""_al(const char* name, std::size_t size) {
+		std::string_view str = utility::CStringToStringView(name, size + 1);
+		if (str.empty()) {
+			throw std::invalid_argument("argument name cannot be empty");
+		}
+		if (utility::HasWhitespace(str)) {
+			throw std::invalid_argument("argument name cannot have whitespaces");
+		}
+		return command::CommandArgument{ std::string{ str }, value::ValueType::kInt64 };
+	}
+	constexpr command::CommandArgument operator""_au(const char* name, std::size_t size) {
+		std::string_view str = utility::CStringToStringView(name, size + 1);
+		if (str.empty()) {
+			throw std::invalid_argument("argument name cannot be empty");
+		}
+		if (utility::HasWhitespace(str)) {
+			throw std::invalid_argument("argument name cannot have whitespaces");
+		}
+		return command::CommandArgument{ std::string{ str }, value::ValueType::kUInt64 };
+	}
+	constexpr command::CommandArgument operator""_ad(const char* name, std::size_t size) {
+		std::string_view str = utility::CStringToStringView(name, size + 1);
+		if (str.empty()) {
+			throw std::invalid_argument("argument name cannot be empty");
+		}
+		if (utility::HasWhitespace(str)) {
+			throw std::invalid_argument("argument name cannot have whitespaces");
+		}
+		return command::CommandArgument{ std::string{ str }, value::ValueType::kDouble };
+	}
+	constexpr command::CommandArgument operator""_az(const char* name, std::size_t size) {
+		std::string_view str = utility::CStringToStringView(name, size + 1);
+		if (str.empty()) {
+			throw std::invalid_argument("argument name cannot be empty");
+		}
+		if (utility::HasWhitespace(str)) {
+			throw std::invalid_argument("argument name cannot have whitespaces");
+		}
+		return command::CommandArgument{ std::string{ str }, value::ValueType::kByteSize };
+	}
+	constexpr command::CommandArgument operator""_at(const char* name, std::size_t size) {
+		std::string_view str = utility::CStringToStringView(name, size + 1);
+		if (str.empty()) {
+			throw std::invalid_argument("argument name cannot be empty");
+		}
+		if (utility::HasWhitespace(str)) {
+			throw std::invalid_argument("argument name cannot have whitespaces");
+		}
+		return command::CommandArgument{ std::string{ str }, value::ValueType::kDuration };
+	}
 
 	template <typename... TArgs>
 	CommandOptionLiteral& CommandOptionLiteral::operator()(TArgs... args) {
@@ -0,0 +1,349 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <format>
+#include <numeric>
+#include <utility>
+
+#include "CommandMetrics.h"
+#include "CommandNode.h"
+
+namespace comad::command {
+	namespace {
+		constexpr std::size_t ToIndex(DispatchPhase phase) noexcept {
+			return static_cast<std::size_t>(phase);
+		}
+
+		std::string BuildPath(const CommandNode& node) {
+			std::vector<std::string_view> names{};
+			for (const CommandNode* current = &node; current->HasParent(); current = &current->GetParent()) {
+				names.push_back(current->GetName());
+			}
+
+			std::string path{};
+			for (auto it = names.rbegin(); it != names.rend(); ++it) {
+				if (!path.empty()) {
+					path.push_back(' ');
+				}
+				path.append(*it);
+			}
+			return path;
+		}
+
+		// a relaxed increment that is only correct with a single writer
+		void Increment(std::atomic<std::uint64_t>& counter, std::uint64_t amount = 1) noexcept {
+			counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+		}
+	}
+
+	std::size_t LatencyHistogram::GetBucketIndex(std::uint64_t value) noexcept {
+		value = std::min(value, kMaxValue);
+		if (value < kSubBucketCount) {
+			return static_cast<std::size_t>(value);
+		}
+
+		// the kSubBucketBits bits below the highest set bit pick the bucket inside its power of two
+		const std::size_t shift = static_cast<std::size_t>(std::bit_width(value)) - 1 - kSubBucketBits;
+		return (shift + 1) * kSubBucketCount + static_cast<std::size_t>((value >> shift) - kSubBucketCount);
+	}
+
+	std::uint64_t LatencyHistogram::GetBucketLowest(std::size_t index) noexcept {
+		if (index < kSubBucketCount) {
+			return index;
+		}
+
+		const std::size_t shift = index / kSubBucketCount - 1;
+		return (kSubBucketCount + index % kSubBucketCount) << shift;
+	}
+
+	std::uint64_t LatencyHistogram::GetBucketHighest(std::size_t index) noexcept {
+		return index + 1 < kBucketCount ? GetBucketLowest(index + 1) - 1 : kMaxValue;
+	}
+
+	void LatencyHistogram::Record(std::chrono::nanoseconds value) noexcept {
+		const std::uint64_t nanoseconds = static_cast<std::uint64_t>(std::max<std::int64_t>(value.count(), 0));
+		++counts_[GetBucketIndex(nanoseconds)];
+		++count_;
+		total_ += nanoseconds;
+	}
+
+	void LatencyHistogram::Merge(const LatencyHistogram& other) noexcept {
+		for (std::size_t i = 0; i < kBucketCount; ++i) {
+			counts_[i] += other.counts_[i];
+		}
+		count_ += other.count_;
+		total_ += other.total_;
+	}
+
+	std::uint64_t LatencyHistogram::GetCount() const noexcept {
+		return count_;
+	}
+
+	std::chrono::nanoseconds LatencyHistogram::GetMean() const noexcept {
+		return std::chrono::nanoseconds{ count_ == 0 ? 0 : static_cast<std::int64_t>(total_ / count_) };
+	}
+
+	std::chrono::nanoseconds LatencyHistogram::GetMax() const noexcept {
+		for (std::size_t i = kBucketCount; i > 0; --i) {
+			if (counts_[i - 1] != 0) {
+				return std::chrono::nanoseconds{ static_cast<std::int64_t>(GetBucketHighest(i - 1)) };
+			}
+		}
+		return std::chrono::nanoseconds{ 0 };
+	}
+
+	std::chrono::nanoseconds LatencyHistogram::GetPercentile(double percentile) const noexcept {
+		if (count_ == 0) {
+			return std::chrono::nanoseconds{ 0 };
+		}
+
+		const double clamped = std::clamp(percentile, 0.0, 100.0);
+		const std::uint64_t rank = std::max<std::uint64_t>(1,
+			static_cast<std::uint64_t>(std::ceil(clamped / 100.0 * static_cast<double>(count_))));
+
+		std::uint64_t seen = 0;
+		for (std::size_t i = 0; i < kBucketCount; ++i) {
+			seen += counts_[i];
+			if (seen >= rank) {
+				return std::chrono::nanoseconds{ static_cast<std::int64_t>(GetBucketHighest(i)) };
+			}
+		}
+		return GetMax();
+	}
+
+	std::uint64_t NodeMetrics::GetErrorCount(int error) const noexcept {
+		const auto it = std::ranges::find(kDispatchErrors, error);
+		return it == kDispatchErrors.end() ? 0 : errors[static_cast<std::size_t>(it - kDispatchErrors.begin())];
+	}
+
+	std::uint64_t NodeMetrics::GetErrorCount() const noexcept {
+		return std::accumulate(errors.begin(), errors.end(), std::uint64_t{ 0 });
+	}
+
+	const LatencyHistogram& NodeMetrics::GetLatency(DispatchPhase phase) const noexcept {
+		return latencies[ToIndex(phase)];
+	}
+
+	const NodeMetrics* MetricsSnapshot::Find(std::string_view path) const noexcept {
+		const auto it = std::ranges::lower_bound(nodes, path, std::less<>{}, &NodeMetrics::path);
+		return it != nodes.end() && it->path == path ? &*it : nullptr;
+	}
+
+	void WriteMetrics(std::ostream& stream, const MetricsSnapshot& snapshot) {
+		stream << std::format("{:<32} {:>10} {:>8}", "command", "calls", "errors");
+		for (const std::string_view phase : kDispatchPhaseNames) {
+			stream << std::format(" {:>30}", std::format("{} p50/p99/max ns", phase));
+		}
+		stream << '\n';
+
+		for (const NodeMetrics& node : snapshot.nodes) {
+			stream << std::format("{:<32} {:>10} {:>8}", node.path.empty() ? "(root)" : node.path,
+				node.calls, node.GetErrorCount());
+			for (const LatencyHistogram& latency : node.latencies) {
+				stream << std::format(" {:>30}", std::format("{}/{}/{}", latency.GetPercentile(50.0).count(),
+					latency.GetPercentile(99.0).count(), latency.GetMax().count()));
+			}
+			stream << '\n';
+		}
+	}
+
+	detail::DispatchSample::DispatchSample() noexcept :
+		phase_start_{ clock::now() },
+		outer_{ std::exchange(GetCurrent(), this) }
+	{}
+
+	detail::DispatchSample::~DispatchSample() {
+		GetCurrent() = outer_;
+	}
+
+	void detail::DispatchSample::EndPhase(DispatchPhase phase) noexcept {
+		const clock::time_point now = clock::now();
+		clock::duration elapsed = now - phase_start_;
+		phase_start_ = now;
+
+		if (phase == DispatchPhase::kParse) {
+			const clock::duration validation = std::min(validation_, elapsed);
+			elapsed -= validation;
+			durations_[ToIndex(DispatchPhase::kValidation)] += validation;
+			phases_ |= 1u << ToIndex(DispatchPhase::kValidation);
+		}
+		validation_ = clock::duration::zero();
+
+		durations_[ToIndex(phase)] += elapsed;
+		phases_ |= 1u << ToIndex(phase);
+	}
+
+	std::chrono::nanoseconds detail::DispatchSample::Get(DispatchPhase phase) const noexcept {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(durations_[ToIndex(phase)]);
+	}
+
+	bool detail::DispatchSample::HasPhase(DispatchPhase phase) const noexcept {
+		return (phases_ & (1u << ToIndex(phase))) != 0;
+	}
+
+	void detail::DispatchSample::SetNode(const CommandNode& node) noexcept {
+		node_ = &node;
+	}
+
+	const CommandNode* detail::DispatchSample::GetNode() const noexcept {
+		return node_;
+	}
+
+	detail::DispatchSample*& detail::DispatchSample::GetCurrent() noexcept {
+		thread_local DispatchSample* current = nullptr;
+		return current;
+	}
+
+	void CommandMetrics::AtomicHistogram::Record(std::chrono::nanoseconds value) noexcept {
+		const std::uint64_t nanoseconds = static_cast<std::uint64_t>(std::max<std::int64_t>(value.count(), 0));
+		Increment(counts_[LatencyHistogram::GetBucketIndex(nanoseconds)]);
+		Increment(count_);
+		Increment(total_, nanoseconds);
+	}
+
+	void CommandMetrics::AtomicHistogram::MergeInto(LatencyHistogram& histogram) const noexcept {
+		for (std::size_t i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+			histogram.counts_[i] += counts_[i].load(std::memory_order_relaxed);
+		}
+		histogram.count_ += count_.load(std::memory_order_relaxed);
+		histogram.total_ += total_.load(std::memory_order_relaxed);
+	}
+
+	void CommandMetrics::AtomicHistogram::Reset() noexcept {
+		for (std::atomic<std::uint64_t>& count : counts_) {
+			count.store(0, std::memory_order_relaxed);
+		}
+		count_.store(0, std::memory_order_relaxed);
+		total_.store(0, std::memory_order_relaxed);
+	}
+
+	CommandMetrics::~CommandMetrics() {
+		// threads drop their cached shards once they see the owner is gone
+		for (const std::shared_ptr<ThreadShard>& shard : shards_) {
+			shard->owner_alive.store(false, std::memory_order_release);
+		}
+	}
+
+	CommandMetrics::ThreadShard& CommandMetrics::GetThreadShard() {
+		struct CachedShard {
+			const CommandMetrics* owner;
+			std::shared_ptr<ThreadShard> shard;
+		};
+		thread_local std::vector<CachedShard> cached_shards{};
+
+		for (const CachedShard& cached : cached_shards) {
+			if (cached.owner == this && cached.shard->owner_alive.load(std::memory_order_acquire)) {
+				return *cached.shard;
+			}
+		}
+
+		// another metrics object may have lived at the same address
+		std::erase_if(cached_shards, [](const CachedShard& cached) {
+			return !cached.shard->owner_alive.load(std::memory_order_acquire);
+		});
+
+		auto shard = std::make_shared<ThreadShard>();
+		{
+			std::lock_guard lock{ shards_mutex_ };
+			shards_.push_back(shard);
+		}
+		cached_shards.push_back(CachedShard{ this, shard });
+		return *shard;
+	}
+
+	void CommandMetrics::Record(const CommandNode& node, int error, const detail::DispatchSample& sample) {
+		ThreadShard& shard = GetThreadShard();
+
+		const std::uint64_t generation = node_generation_.load(std::memory_order_acquire);
+		if (shard.node_generation != generation) {
+			shard.nodes.clear();
+			shard.node_generation = generation;
+		}
+
+		auto it = shard.nodes.find(&node);
+		if (it == shard.nodes.end()) {
+			std::string path = BuildPath(node);
+
+			// only this thread inserts into its shard, so finding without the lock is safe
+			auto path_it = shard.paths.find(path);
+			if (path_it == shard.paths.end()) {
+				auto counters = std::make_unique<NodeCounters>();
+
+				std::lock_guard lock{ shard.mutex };
+				path_it = shard.paths.emplace(std::move(path), std::move(counters)).first;
+			}
+			it = shard.nodes.emplace(&node, path_it->second.get()).first;
+		}
+
+		NodeCounters& counters = *it->second;
+		Increment(counters.calls);
+		if (error != 0) {
+			const auto error_it = std::ranges::find(kDispatchErrors, error);
+			if (error_it != kDispatchErrors.end()) {
+				Increment(counters.errors[static_cast<std::size_t>(error_it - kDispatchErrors.begin())]);
+			}
+		}
+
+		for (std::size_t phase = 0; phase < kDispatchPhaseCount; ++phase) {
+			if (sample.HasPhase(static_cast<DispatchPhase>(phase))) {
+				counters.latencies[phase].Record(sample.Get(static_cast<DispatchPhase>(phase)));
+			}
+		}
+	}
+
+	void CommandMetrics::ForgetNodes() noexcept {
+		node_generation_.fetch_add(1, std::memory_order_release);
+	}
+
+	MetricsSnapshot CommandMetrics::GetSnapshot() const {
+		std::vector<std::shared_ptr<ThreadShard>> shards{};
+		{
+			std::lock_guard lock{ shards_mutex_ };
+			shards = shards_;
+		}
+
+		std::unordered_map<std::string_view, NodeMetrics> merged{};
+		for (const std::shared_ptr<ThreadShard>& shard : shards) {
+			std::lock_guard lock{ shard->mutex };
+			for (const auto& [path, counters] : shard->paths) {
+				auto [it, inserted] = merged.try_emplace(path);
+				NodeMetrics& metrics = it->second;
+				if (inserted) {
+					metrics.path = path;
+				}
+
+				metrics.calls += counters->calls.load(std::memory_order_relaxed);
+				for (std::size_t i = 0; i < kDispatchErrors.size(); ++i) {
+					metrics.errors[i] += counters->errors[i].load(std::memory_order_relaxed);
+				}
+				for (std::size_t phase = 0; phase < kDispatchPhaseCount; ++phase) {
+					counters->latencies[phase].MergeInto(metrics.latencies[phase]);
+				}
+			}
+		}
+
+		MetricsSnapshot snapshot{};
+		snapshot.nodes.reserve(merged.size());
+		for (auto& [path, metrics] : merged) {
+			snapshot.nodes.push_back(std::move(metrics));
+		}
+		std::ranges::sort(snapshot.nodes, std::less<>{}, &NodeMetrics::path);
+		return snapshot;
+	}
+
+	void CommandMetrics::Reset() {
+		std::lock_guard shards_lock{ shards_mutex_ };
+		for (const std::shared_ptr<ThreadShard>& shard : shards_) {
+			std::lock_guard lock{ shard->mutex };
+			for (const auto& [path, counters] : shard->paths) {
+				counters->calls.store(0, std::memory_order_relaxed);
+				for (std::atomic<std::uint64_t>& error : counters->errors) {
+					error.store(0, std::memory_order_relaxed);
+				}
+				for (AtomicHistogram& latency : counters->latencies) {
+					latency.Reset();
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,194 @@
+#ifndef COMAD_COMMAND_METRICS_H_
+#define COMAD_COMMAND_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <ComadBuildOptions.h>
+#include <ComadReturnCodes.h>
+
+namespace comad::command {
+	class CommandNode;
+
+	enum class DispatchPhase : std::size_t {
+		kLookup,
+		kParse,
+		kValidation,
+		kExecutor
+	};
+
+	inline constexpr std::size_t kDispatchPhaseCount = 4;
+	inline constexpr std::array<std::string_view, kDispatchPhaseCount> kDispatchPhaseNames{
+		"lookup", "parse", "validation", "executor"
+	};
+
+	// the errors dispatch can fail with, counted per node in this order
+	inline constexpr std::array<int, 9> kDispatchErrors{
+		retc::kNoInput, retc::kUnknownCommand, retc::kUnknownFlag, retc::kDupeOption, retc::kInvalidValueParse,
+		retc::kInvalidOptionValue, retc::kUnknownOption, retc::kMissingRequiredOptions, retc::kMalformedLine
+	};
+
+	// log-linear buckets in the style of HdrHistogram: values below kSubBucketCount nanoseconds are exact,
+	// above that every power of two is split into kSubBucketCount buckets, so any recorded value is
+	// off by less than 1/kSubBucketCount. values above kMaxValue are counted as kMaxValue
+	class LatencyHistogram {
+	public:
+		static constexpr std::size_t kSubBucketBits = 4;
+		static constexpr std::size_t kSubBucketCount = std::size_t{ 1 } << kSubBucketBits;
+		static constexpr std::size_t kMaxValueBits = 40;
+		static constexpr std::uint64_t kMaxValue = (std::uint64_t{ 1 } << kMaxValueBits) - 1;
+		static constexpr std::size_t kBucketCount = (kMaxValueBits - kSubBucketBits + 1) * kSubBucketCount;
+
+		void Record(std::chrono::nanoseconds value) noexcept;
+		void Merge(const LatencyHistogram& other) noexcept;
+
+		[[nodiscard]] std::uint64_t GetCount() const noexcept;
+		[[nodiscard]] std::chrono::nanoseconds GetMean() const noexcept;
+		[[nodiscard]] std::chrono::nanoseconds GetMax() const noexcept;
+		// the highest value that falls into the same bucket as the value at percentile, 0 to 100
+		[[nodiscard]] std::chrono::nanoseconds GetPercentile(double percentile) const noexcept;
+
+		static std::size_t GetBucketIndex(std::uint64_t value) noexcept;
+		static std::uint64_t GetBucketLowest(std::size_t index) noexcept;
+		static std::uint64_t GetBucketHighest(std::size_t index) noexcept;
+
+	private:
+		std::array<std::uint64_t, kBucketCount> counts_{ };
+		std::uint64_t count_{ 0 };
+		std::uint64_t total_{ 0 };
+
+		friend class CommandMetrics;
+	};
+
+	// the counters of every node that had the same path, in this tree and the ones it replaced
+	struct NodeMetrics {
+		// names from the root, separated by spaces
+		std::string path;
+		std::uint64_t calls;
+		std::array<std::uint64_t, kDispatchErrors.size()> errors;
+		std::array<LatencyHistogram, kDispatchPhaseCount> latencies;
+
+		[[nodiscard]] std::uint64_t GetErrorCount(int error) const noexcept;
+		[[nodiscard]] std::uint64_t GetErrorCount() const noexcept;
+		[[nodiscard]] const LatencyHistogram& GetLatency(DispatchPhase phase) const noexcept;
+	};
+
+	struct MetricsSnapshot {
+		// sorted by path
+		std::vector<NodeMetrics> nodes;
+
+		[[nodiscard]] const NodeMetrics* Find(std::string_view path) const noexcept;
+	};
+
+	// one line per node with its calls, errors and the median, p99 and max of every phase
+	void WriteMetrics(std::ostream& stream, const MetricsSnapshot& snapshot);
+
+	namespace detail {
+		// the phases of one dispatch, timed on the dispatching thread
+		class DispatchSample {
+		public:
+			using clock = std::chrono::steady_clock;
+
+			DispatchSample() noexcept;
+			~DispatchSample();
+
+			DispatchSample(const DispatchSample&) = delete;
+			DispatchSample& operator=(const DispatchSample&) = delete;
+
+			// adds the time since the previous phase ended to phase
+			void EndPhase(DispatchPhase phase) noexcept;
+
+			// validation inside a parse phase is moved from the parse time to the validation time
+			template <typename F>
+			static bool MeasureValidation(F&& validate);
+
+			[[nodiscard]] std::chrono::nanoseconds Get(DispatchPhase phase) const noexcept;
+			[[nodiscard]] bool HasPhase(DispatchPhase phase) const noexcept;
+
+			// the node the command resolved to, null until the lookup has ended
+			void SetNode(const CommandNode& node) noexcept;
+			[[nodiscard]] const CommandNode* GetNode() const noexcept;
+
+		private:
+			clock::time_point phase_start_{ };
+			std::array<clock::duration, kDispatchPhaseCount> durations_{ };
+			clock::duration validation_{ };
+			std::uint8_t phases_{ 0 };
+			const CommandNode* node_{ nullptr };
+			// the sample of the dispatch this one is nested in, restored when it ends
+			DispatchSample* outer_{ nullptr };
+
+			static DispatchSample*& GetCurrent() noexcept;
+		};
+	}
+
+	// counters and latency histograms per node. every thread records into a shard of its own without
+	// locking, shards are only merged when a snapshot is taken. counts recorded while Reset runs may
+	// survive it
+	class CommandMetrics {
+	public:
+		CommandMetrics() = default;
+		~CommandMetrics();
+
+		CommandMetrics(const CommandMetrics&) = delete;
+		CommandMetrics& operator=(const CommandMetrics&) = delete;
+
+		// error is 0 for dispatches that reached the executor
+		void Record(const CommandNode& node, int error, const detail::DispatchSample& sample);
+		// counters are kept by path, nodes are only looked up by address until the tree is replaced
+		// since a later node may reuse one. called whenever that may have happened
+		void ForgetNodes() noexcept;
+
+		[[nodiscard]] MetricsSnapshot GetSnapshot() const;
+		void Reset();
+
+	private:
+		class AtomicHistogram {
+		public:
+			// only the owning thread records, so the counters are updated without read-modify-write
+			void Record(std::chrono::nanoseconds value) noexcept;
+			void MergeInto(LatencyHistogram& histogram) const noexcept;
+			void Reset() noexcept;
+
+		private:
+			std::array<std::atomic<std::uint64_t>, LatencyHistogram::kBucketCount> counts_{ };
+			std::atomic<std::uint64_t> count_{ 0 };
+			std::atomic<std::uint64_t> total_{ 0 };
+		};
+
+		struct NodeCounters {
+			std::atomic<std::uint64_t> calls{ 0 };
+			std::array<std::atomic<std::uint64_t>, kDispatchErrors.size()> errors{ };
+			std::array<AtomicHistogram, kDispatchPhaseCount> latencies{ };
+		};
+
+		struct ThreadShard {
+			// only taken to add paths and to read, recording into known paths does not lock
+			mutable std::mutex mutex{ };
+			std::unordered_map<std::string, std::unique_ptr<NodeCounters>> paths{ };
+			// only used by the owning thread, cleared once node_generation_ has moved past node_generation
+			std::unordered_map<const CommandNode*, NodeCounters*> nodes{ };
+			std::uint64_t node_generation{ 0 };
+			std::atomic<bool> owner_alive{ true };
+		};
+
+		mutable std::mutex shards_mutex_{ };
+		std::vector<std::shared_ptr<ThreadShard>> shards_{ };
+		std::atomic<std::uint64_t> node_generation_{ 0 };
+
+		ThreadShard& GetThreadShard();
+	};
+}
+
+#include "CommandMetrics.tcc"
+#endif
@@ -0,0 +1,23 @@
+#ifndef COMAD_COMMAND_METRICS_TCC_
+#define COMAD_COMMAND_METRICS_TCC_
+
+#include "CommandMetrics.h"
+
+namespace comad::command {
+	template <typename F>
+	bool detail::DispatchSample::MeasureValidation(F&& validate) {
+		if constexpr (build_options::EnableMetrics) {
+			DispatchSample* current = GetCurrent();
+			if (current != nullptr) {
+				const clock::time_point start = clock::now();
+				const bool valid = validate();
+				current->validation_ += clock::now() - start;
+				return valid;
+			}
+		}
+
+		return validate();
+	}
+}
+
+#endif
@@ -1,3 +1,5 @@
+#include <stdexcept>
+#include <string>
 #include <utility>
 
 #include "StringUtility.h"
@@ -14,56 +16,127 @@ namespace comad::command {
 		name_{ name }
 	{}
 
+	CommandNode::CommandNode(CommandNode&& other) noexcept :
+		sub_nodes_{ std::move(other.sub_nodes_) },
+		alias_to_name_{ std::move(other.alias_to_name_) },
+		short_to_full_opt_{ std::move(other.short_to_full_opt_) },
+		name_{ other.name_ },
+		parent_{ other.parent_ },
+		cmd_template_{ std::move(other.cmd_template_) },
+		executor_{ std::move(other.executor_) },
+		executor_id_{ std::move(other.executor_id_) },
+		use_count_{ std::move(other.use_count_) },
+		cache_policy_{ std::move(other.cache_policy_) },
+		required_option_count_{ other.required_option_count_ },
+		context_layout_{ std::move(other.context_layout_) },
+		option_table_{ std::move(other.option_table_) },
+		indexed_aliases_{ std::move(other.indexed_aliases_) },
+		batch_depth_{ other.batch_depth_ },
+		indexes_dirty_{ other.indexes_dirty_ },
+		child_aliases_dirty_{ other.child_aliases_dirty_ }
+	{
+		AdoptChildren();
+	}
+
+	CommandNode& CommandNode::operator=(CommandNode&& other) noexcept {
+		sub_nodes_ = std::move(other.sub_nodes_);
+		alias_to_name_ = std::move(other.alias_to_name_);
+		short_to_full_opt_ = std::move(other.short_to_full_opt_);
+		name_ = other.name_;
+		parent_ = other.parent_;
+		cmd_template_ = std::move(other.cmd_template_);
+		executor_ = std::move(other.executor_);
+		executor_id_ = std::move(other.executor_id_);
+		use_count_ = std::move(other.use_count_);
+		cache_policy_ = std::move(other.cache_policy_);
+		required_option_count_ = other.required_option_count_;
+		context_layout_ = std::move(other.context_layout_);
+		option_table_ = std::move(other.option_table_);
+		indexed_aliases_ = std::move(other.indexed_aliases_);
+		batch_depth_ = other.batch_depth_;
+		indexes_dirty_ = other.indexes_dirty_;
+		child_aliases_dirty_ = other.child_aliases_dirty_;
+		AdoptChildren();
+
+		return *this;
+	}
+
+	void CommandNode::AdoptChildren() noexcept {
+		// map nodes keep their addresses, only the children's link back to this node is stale
+		for (auto& child : sub_nodes_) {
+			child.second.parent_ = this;
+		}
+	}
+
 	CommandNode::CommandNode(CommandTemplate cmd_template, CommandExecutor executor) :
 		cmd_template_{ std::move(cmd_template) },
-		executor_{ executor }
-	{}
+		executor_{ std::move(executor) }
+	{
+		BuildIndexes();
+	}
 
-	void CommandNode::ChildUpdated(std::string_view child_name) {
-		CommandNode& child = GetChild(child_name);
+	void CommandNode::AliasesUpdated() {
+		if (parent_ == nullptr) {
+			return;
+		}
 
-		for (auto it = alias_to_name_.begin(); it != alias_to_name_.end();) {
-			if (it->second == child_name &&
-				child.cmd_template_.aliases.find(it->first) == child.cmd_template_.aliases.end()) {
+		if (parent_->IsBatching()) {
+			parent_->child_aliases_dirty_ = true;
+		}
+		else {
+			parent_->ChildUpdated(*this);
+		}
+	}
 
-				it = alias_to_name_.erase(it);
-			}
-			else {
-				++it;
+	void CommandNode::ChildUpdated(CommandNode& child) {
+		// only the aliases indexed for this child can be stale, the rest of the map is left alone
+		for (const std::string_view alias : child.indexed_aliases_) {
+			if (!child.cmd_template_.aliases.contains(alias)) {
+				const auto it = alias_to_name_.find(alias);
+				if (it != alias_to_name_.end() && it->second == child.name_) {
+					alias_to_name_.erase(it);
+				}
 			}
 		}
+		child.indexed_aliases_.clear();
 
 		for (auto it = child.cmd_template_.aliases.begin(); it != child.cmd_template_.aliases.end();) {
-			std::string_view alias = *it;
-			if (!alias_to_name_.try_emplace(std::string{ alias }, std::string{ child_name }).second) {
-				if (alias_to_name_.find(alias)->second != child_name) {
-					it = child.cmd_template_.aliases.erase(it);
-					alias_to_name_.emplace(std::string{ alias }, std::string{ child_name });
-				}
-				else {
-					++it;
-				}
+			const auto [mapped, inserted] = alias_to_name_.try_emplace(*it, child.name_);
+			if (!inserted && mapped->second != child.name_) {
+				// the alias already belongs to another child
+				it = child.cmd_template_.aliases.erase(it);
 			}
 			else {
+				child.indexed_aliases_.emplace_back(mapped->first);
 				++it;
 			}
 		}
 	}
 
-	bool CommandNode::AddNode(std::string_view name) {
-		if (HasChild(name)) {
-			return false;
+	CommandNode& CommandNode::EmplaceChild(std::string_view name, bool& inserted) {
+		auto it = sub_nodes_.lower_bound(name);
+		inserted = it == sub_nodes_.end() || it->first != name;
+		if (inserted) {
+			it = sub_nodes_.emplace_hint(it, std::string{ name }, CommandNode{ std::ref(*this), name });
+			// view the stored key so the name outlives the caller's buffer
+			it->second.name_ = it->first;
 		}
 
-		auto result = sub_nodes_.emplace(std::string{ name }, CommandNode{ std::ref(*this), name });
-		return result.second;
+		return it->second;
+	}
+
+	bool CommandNode::AddNode(std::string_view name) {
+		bool inserted = false;
+		EmplaceChild(name, inserted);
+		return inserted;
 	}
 
 	bool CommandNode::AddNode(std::string_view name, CommandTemplate cmd_template, CommandExecutor executor) {
-		if (AddNode(name)) {
-			CommandNode& node = GetChild(name);
+		bool inserted = false;
+		CommandNode& node = EmplaceChild(name, inserted);
+		if (inserted) {
 			node.SetTemplate(std::move(cmd_template));
-			node.SetExecutor(executor);
+			node.SetExecutor(std::move(executor));
 			return true;
 		}
 
@@ -80,17 +153,19 @@ namespace comad::command {
 	}
 
 	CommandNode& CommandNode::GetChild(std::string_view name) {
-		if (!HasChild(name)) {
+		const auto it = sub_nodes_.find(name);
+		if (it == sub_nodes_.end()) {
 			throw std::invalid_argument("no child found: " + std::string{ name });
 		}
-		return sub_nodes_.find(name)->second;
+		return it->second;
 	}
 
 	const CommandNode& CommandNode::GetChild(std::string_view name) const {
-		if (!HasChild(name)) {
+		const auto it = sub_nodes_.find(name);
+		if (it == sub_nodes_.end()) {
 			throw std::invalid_argument("no child found: " + std::string{ name });
 		}
-		return sub_nodes_.find(name)->second;
+		return it->second;
 	}
 
 	bool CommandNode::HasChild(std::string_view name) const noexcept {
@@ -102,7 +177,7 @@ namespace comad::command {
 	}
 
 	bool CommandNode::HasShortOption(char short_name) const noexcept {
-		return short_to_full_opt_.contains(short_name);
+		return option_table_.FindShort(short_name) != nullptr;
 	}
 
 	const std::string& CommandNode::GetShortOptionName(char short_name) const {
@@ -124,6 +199,31 @@ namespace comad::command {
 		return required_option_count_;
 	}
 
+	const ContextLayout& CommandNode::GetContextLayout() const noexcept {
+		return context_layout_;
+	}
+
+	std::size_t CommandNode::FindOptionSlot(std::string_view option_name) const noexcept {
+		const OptionDescriptor* descriptor = option_table_.FindLong(option_name);
+		return descriptor == nullptr ? kNoSlot : descriptor->slot;
+	}
+
+	const CommandOption& CommandNode::GetOptionAt(std::size_t slot) const {
+		const OptionDescriptor* descriptor = option_table_.At(slot);
+		if (descriptor == nullptr) {
+			throw std::out_of_range("no option at slot " + std::to_string(slot));
+		}
+		return *descriptor->option;
+	}
+
+	std::size_t CommandNode::FindFlagSlot(std::string_view flag_name) const noexcept {
+		return context_layout_.flags.Find(flag_name);
+	}
+
+	const OptionTable& CommandNode::GetOptionTable() const noexcept {
+		return option_table_;
+	}
+
 	bool CommandNode::HasParent() const noexcept {
 		return parent_ != nullptr;
 	}
@@ -138,39 +238,120 @@ namespace comad::command {
 	}
 
 	bool CommandNode::Remove(std::string_view name) {
-		if (HasChildAlias(name)) {
-			name = GetChildNameFromAlias(name);
+		// the child is found before any alias is erased, name may view one of the alias map's values
+		const auto alias_it = alias_to_name_.find(name);
+		const auto child_it = sub_nodes_.find(alias_it == alias_to_name_.end() ? name : std::string_view{ alias_it->second });
+		if (child_it == sub_nodes_.end()) {
+			return false;
 		}
 
-		if (HasChild(name)) {
-			CommandNode& child = GetChild(name);
-			for (const std::string& alias : child.cmd_template_.aliases) {
-				alias_to_name_.erase(alias);
+		for (const std::string_view alias : child_it->second.indexed_aliases_) {
+			const auto it = alias_to_name_.find(alias);
+			if (it != alias_to_name_.end()) {
+				alias_to_name_.erase(it);
 			}
+		}
 
-			sub_nodes_.erase(sub_nodes_.find(name));
-			return true;
+		sub_nodes_.erase(child_it);
+		return true;
+	}
+
+	void CommandNode::BeginBatch() noexcept {
+		++batch_depth_;
+	}
+
+	void CommandNode::EndBatch() {
+		if (batch_depth_ == 0) {
+			throw std::logic_error("no batch is open on node " + std::string{ name_ });
+		}
+
+		if (--batch_depth_ == 0 && !IsBatching()) {
+			FinishBatch();
+		}
+	}
+
+	bool CommandNode::IsBatching() const noexcept {
+		for (const CommandNode* node = this; node != nullptr; node = node->parent_) {
+			if (node->batch_depth_ > 0) {
+				return true;
+			}
 		}
+
 		return false;
 	}
 
+	void CommandNode::FinishBatch() {
+		if (indexes_dirty_) {
+			BuildIndexes();
+		}
+
+		for (auto& [name, child] : sub_nodes_) {
+			child.FinishBatch();
+			if (child_aliases_dirty_) {
+				ChildUpdated(child);
+			}
+		}
+		child_aliases_dirty_ = false;
+	}
+
 	void CommandNode::SetTemplate(CommandTemplate cmd_template) {
 		this->cmd_template_ = std::move(cmd_template);
-		if (parent_) {
-			parent_->ChildUpdated(name_);
+		AliasesUpdated();
+
+		if (IsBatching()) {
+			indexes_dirty_ = true;
+		}
+		else {
+			BuildIndexes();
 		}
+	}
 
+	void CommandNode::BuildIndexes() {
 		short_to_full_opt_.clear();
+		required_option_count_ = 0;
 		for (auto& pair : cmd_template_.options) {
 			short_to_full_opt_.try_emplace(pair.second.short_name, pair.first);
 			required_option_count_ += pair.second.required;
 		}
+
+		BuildContextLayout();
+		indexes_dirty_ = false;
+	}
+
+	void CommandNode::BuildContextLayout() {
+		std::vector<std::string_view> flag_names{};
+		flag_names.reserve(cmd_template_.flags.size());
+		for (const std::string& flag : cmd_template_.flags) {
+			flag_names.emplace_back(flag);
+		}
+
+		// the table's slots follow the same map order as the option names
+		std::vector<std::string_view> option_names{};
+		option_names.reserve(cmd_template_.options.size());
+		for (const auto& pair : cmd_template_.options) {
+			option_names.emplace_back(pair.first);
+		}
+		option_table_.Assign(cmd_template_.options);
+
+		std::vector<std::string_view> arg_names{};
+		arg_names.reserve(cmd_template_.args.size());
+		for (const CommandArgument& arg : cmd_template_.args) {
+			arg_names.emplace_back(arg.first);
+		}
+
+		context_layout_.flags.Assign(std::move(flag_names));
+		context_layout_.options.Assign(std::move(option_names));
+		context_layout_.args.Assign(std::move(arg_names));
 	}
 
 	const CommandTemplate& CommandNode::GetTemplate() const noexcept {
 		return cmd_template_;
 	}
 
+	const std::map<std::string, CommandNode, std::less<>>& CommandNode::GetChildren() const noexcept {
+		return sub_nodes_;
+	}
+
 	const std::map<std::string, std::string, std::less<>>& CommandNode::GetChildAliasMapping() const noexcept {
 		return alias_to_name_;
 	}
@@ -180,16 +361,58 @@ namespace comad::command {
 	}
 
 	void CommandNode::SetExecutor(CommandExecutor executor) noexcept {
-		executor_ = executor;
+		executor_ = std::move(executor);
+		executor_id_.clear();
+	}
+
+	void CommandNode::SetExecutorId(std::string id) noexcept {
+		executor_id_ = std::move(id);
+	}
+
+	std::string_view CommandNode::GetExecutorId() const noexcept {
+		return executor_id_;
 	}
 
-	CommandExecutor CommandNode::GetExecutor() const noexcept {
+	void CommandNode::RecordUse() const noexcept {
+		use_count_.Add();
+	}
+
+	std::uint64_t CommandNode::GetUseCount() const noexcept {
+		return use_count_.Get();
+	}
+
+	detail::UseCounter::UseCounter(UseCounter&& other) noexcept :
+		count_{ other.Get() }
+	{}
+
+	detail::UseCounter& detail::UseCounter::operator=(UseCounter&& other) noexcept {
+		count_.store(other.Get(), std::memory_order_relaxed);
+		return *this;
+	}
+
+	void detail::UseCounter::Add() noexcept {
+		count_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	std::uint64_t detail::UseCounter::Get() const noexcept {
+		return count_.load(std::memory_order_relaxed);
+	}
+
+	const CommandExecutor& CommandNode::GetExecutor() const noexcept {
 		return executor_;
 	}
 
 	void CommandNode::SetCommand(CommandTemplate cmd_template, CommandExecutor executor) {
 		SetTemplate(std::move(cmd_template));
-		SetExecutor(executor_);
+		SetExecutor(std::move(executor));
+	}
+
+	void CommandNode::SetCachePolicy(std::optional<CachePolicy> policy) noexcept {
+		cache_policy_ = policy;
+	}
+
+	const std::optional<CachePolicy>& CommandNode::GetCachePolicy() const noexcept {
+		return cache_policy_;
 	}
 
 	CommandNode& CommandNode::operator>>(std::string_view cmd) {
@@ -201,17 +424,14 @@ namespace comad::command {
 		if (HasWhitespace(cmd)) {
 			throw std::invalid_argument("subcommand name cannot have whitespaces");
 		}
-		if (!HasChild(cmd)) {
-			AddNode(cmd);
-		}
-
-		return GetChild(cmd);
+		bool inserted = false;
+		return EmplaceChild(cmd, inserted);
 	}
 
 	CommandNode& CommandNode::operator|(std::string_view alias) {
 		using namespace comad::utility;
 
-		if constexpr (Verbose) comad_logger.MakeStream<LogLevel::DEBUG>() << "adding alias" << alias << " for node " <<  name_ << std::flush;
+		LogDebug("adding alias ", alias, " for node ", name_);
 		if (alias.empty()) {
 			throw std::invalid_argument("subcommand alias cannot be empty");
 		}
@@ -220,16 +440,23 @@ namespace comad::command {
 		}
 
 		cmd_template_.aliases.emplace(alias);
-
-		if (parent_) {
-			parent_->ChildUpdated(name_);
-		}
+		AliasesUpdated();
 
 		return *this;
 	}
 
 	CommandNode& CommandNode::operator=(CommandExecutor executor) {
-		this->executor_ = executor;
+		SetExecutor(std::move(executor));
 		return *this;
 	}
+
+	CommandBatch::CommandBatch(CommandNode& node) noexcept :
+		node_{ node }
+	{
+		node_.BeginBatch();
+	}
+
+	CommandBatch::~CommandBatch() {
+		node_.EndBatch();
+	}
 }
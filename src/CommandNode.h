@@ -1,11 +1,15 @@
 #ifndef COMAD_COMMAND_NODE_H_
 #define COMAD_COMMAND_NODE_H_
 
+#include <atomic>
+#include <cstdint>
+#include <optional>
 #include <ranges>
 #include <string>
 #include <string_view>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "Command.h"
 
@@ -15,16 +19,32 @@ namespace comad::command {
 		std::is_same_v<T, CommandArgument> ||
 		std::is_convertible_v<T, std::pair<std::string_view, CommandOption>>;
 
+	namespace detail {
+		// a relaxed counter that moves with the node it belongs to
+		class UseCounter {
+		public:
+			UseCounter() = default;
+			UseCounter(UseCounter&& other) noexcept;
+			UseCounter& operator=(UseCounter&& other) noexcept;
+
+			void Add() noexcept;
+			[[nodiscard]] std::uint64_t Get() const noexcept;
+
+		private:
+			std::atomic<std::uint64_t> count_{ 0 };
+		};
+	}
 
 	class CommandNode {
 	public:
 		CommandNode();
 		CommandNode(CommandTemplate cmd_template, CommandExecutor executor);
 
+		// moved nodes take their children along, which then refer to them as their parent
 		CommandNode(const CommandNode&) = delete;
-		CommandNode(CommandNode&&) = default;
+		CommandNode(CommandNode&& other) noexcept;
 		CommandNode& operator=(const CommandNode&) = delete;
-		CommandNode& operator=(CommandNode&&) = default;
+		CommandNode& operator=(CommandNode&& other) noexcept;
 
 		bool AddNode(std::string_view name);
 		bool AddNode(std::string_view name, CommandTemplate cmd_template, CommandExecutor executor);
@@ -34,6 +54,12 @@ namespace comad::command {
 		[[nodiscard]] const CommandOption& GetOption(std::string_view option_name) const;
 		[[nodiscard]] int GetRequiredOptionCount() const noexcept;
 
+		[[nodiscard]] const ContextLayout& GetContextLayout() const noexcept;
+		[[nodiscard]] std::size_t FindOptionSlot(std::string_view option_name) const noexcept;
+		[[nodiscard]] const CommandOption& GetOptionAt(std::size_t slot) const;
+		[[nodiscard]] std::size_t FindFlagSlot(std::string_view flag_name) const noexcept;
+		[[nodiscard]] const OptionTable& GetOptionTable() const noexcept;
+
 		[[nodiscard]] bool HasChild(std::string_view name) const noexcept;
 		[[nodiscard]] CommandNode& GetChild(std::string_view name);
 		[[nodiscard]] const CommandNode& GetChild(std::string_view name) const;
@@ -47,17 +73,38 @@ namespace comad::command {
 
 		bool Remove(std::string_view name);
 
+		// while a batch is open, template and alias changes anywhere below this node only mark the
+		// nodes they touch. closing the outermost batch indexes every marked node in one pass over
+		// the subtree. lookups and dispatch through the subtree are not valid before that
+		void BeginBatch() noexcept;
+		void EndBatch();
+		[[nodiscard]] bool IsBatching() const noexcept;
+
 		void SetTemplate(CommandTemplate cmd_template);
 		[[nodiscard]] const CommandTemplate& GetTemplate() const noexcept;
 
+		[[nodiscard]] const std::map<std::string, CommandNode, std::less<>>& GetChildren() const noexcept;
 		[[nodiscard]] const std::map<std::string, std::string, std::less<>>& GetChildAliasMapping() const noexcept;
 		[[nodiscard]] const std::map<char, std::string, std::less<>>& GetShortOptionMapping() const noexcept;
 
 		void SetExecutor(CommandExecutor executor) noexcept;
-		[[nodiscard]] CommandExecutor GetExecutor() const noexcept;
+		[[nodiscard]] const CommandExecutor& GetExecutor() const noexcept;
+
+		// names the executor in command images, an ExecutorRegistry binds it back when one is loaded.
+		// setting another executor clears it
+		void SetExecutorId(std::string id) noexcept;
+		[[nodiscard]] std::string_view GetExecutorId() const noexcept;
 
 		void SetCommand(CommandTemplate cmd_template, CommandExecutor executor);
 
+		// how often the node was dispatched by handlers that count uses, for ranking completions
+		void RecordUse() const noexcept;
+		[[nodiscard]] std::uint64_t GetUseCount() const noexcept;
+
+		// the executor must only depend on its context while a policy is set
+		void SetCachePolicy(std::optional<CachePolicy> policy) noexcept;
+		[[nodiscard]] const std::optional<CachePolicy>& GetCachePolicy() const noexcept;
+
 		CommandNode& operator>>(std::string_view cmd);
 		CommandNode& operator=(CommandExecutor executor);
 
@@ -80,12 +127,42 @@ namespace comad::command {
 		std::string_view name_{""};
 		CommandNode* parent_{ nullptr };
 		CommandTemplate cmd_template_{};
-		CommandExecutor executor_{ nullptr };
+		CommandExecutor executor_{ };
+		std::string executor_id_{ };
+		mutable detail::UseCounter use_count_{ };
+		std::optional<CachePolicy> cache_policy_{ };
 		int required_option_count_{ 0 };
+		ContextLayout context_layout_{};
+		OptionTable option_table_{};
+
+		// the keys of the parent's alias map that point to this node
+		std::vector<std::string_view> indexed_aliases_{};
+		int batch_depth_{ 0 };
+		bool indexes_dirty_{ false };
+		bool child_aliases_dirty_{ false };
 
 		CommandNode(std::reference_wrapper<CommandNode> parent, std::string_view name);
 
-		void ChildUpdated(std::string_view child_name);
+		CommandNode& EmplaceChild(std::string_view name, bool& inserted);
+		void AdoptChildren() noexcept;
+		void AliasesUpdated();
+		void ChildUpdated(CommandNode& child);
+		void BuildIndexes();
+		void BuildContextLayout();
+		void FinishBatch();
+	};
+
+	// keeps a batch open on a node for its lifetime
+	class CommandBatch {
+	public:
+		explicit CommandBatch(CommandNode& node) noexcept;
+		~CommandBatch();
+
+		CommandBatch(const CommandBatch&) = delete;
+		CommandBatch& operator=(const CommandBatch&) = delete;
+
+	private:
+		CommandNode& node_;
 	};
 }
 
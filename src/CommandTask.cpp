@@ -0,0 +1,242 @@
+#include <semaphore>
+#include <stdexcept>
+#include <utility>
+
+#include "CommandTask.h"
+
+namespace comad::command {
+	namespace {
+		// the coroutine Wait runs a task in, it releases the waiting thread once it has finished
+		class BlockingTask {
+		public:
+			class promise_type {
+			public:
+				struct FinalAwaiter {
+					bool await_ready() const noexcept { return false; }
+					void await_suspend(std::coroutine_handle<promise_type> finished) const noexcept {
+						finished.promise().done_->release();
+					}
+					void await_resume() const noexcept {}
+				};
+
+				BlockingTask get_return_object() noexcept {
+					return BlockingTask{ std::coroutine_handle<promise_type>::from_promise(*this) };
+				}
+				std::suspend_always initial_suspend() const noexcept { return {}; }
+				FinalAwaiter final_suspend() const noexcept { return {}; }
+				void return_void() const noexcept {}
+				void unhandled_exception() const noexcept { std::terminate(); }
+
+			private:
+				std::binary_semaphore* done_{ nullptr };
+
+				friend class BlockingTask;
+			};
+
+			explicit BlockingTask(std::coroutine_handle<promise_type> handle) noexcept : handle_{ handle } {}
+			~BlockingTask() { handle_.destroy(); }
+
+			BlockingTask(const BlockingTask&) = delete;
+			BlockingTask& operator=(const BlockingTask&) = delete;
+
+			void Run() {
+				std::binary_semaphore done{ 0 };
+				handle_.promise().done_ = &done;
+				handle_.resume();
+				done.acquire();
+			}
+
+		private:
+			std::coroutine_handle<promise_type> handle_;
+		};
+
+		BlockingTask AwaitBlocking(CommandTask& task, int& result, std::exception_ptr& exception) {
+			try {
+				result = co_await task;
+			}
+			catch (...) {
+				exception = std::current_exception();
+			}
+		}
+	}
+
+	bool CommandTask::promise_type::FinalAwaiter::await_ready() const noexcept {
+		return false;
+	}
+
+	std::coroutine_handle<> CommandTask::promise_type::FinalAwaiter::await_suspend(
+		std::coroutine_handle<promise_type> finished) const noexcept {
+		return finished.promise().continuation_;
+	}
+
+	void CommandTask::promise_type::FinalAwaiter::await_resume() const noexcept {}
+
+	CommandTask CommandTask::promise_type::get_return_object() noexcept {
+		return CommandTask{ std::coroutine_handle<promise_type>::from_promise(*this) };
+	}
+
+	std::suspend_always CommandTask::promise_type::initial_suspend() const noexcept {
+		return {};
+	}
+
+	CommandTask::promise_type::FinalAwaiter CommandTask::promise_type::final_suspend() const noexcept {
+		return {};
+	}
+
+	void CommandTask::promise_type::return_value(int result) noexcept {
+		result_ = result;
+	}
+
+	void CommandTask::promise_type::unhandled_exception() noexcept {
+		exception_ = std::current_exception();
+	}
+
+	CommandTask::CommandTask(std::coroutine_handle<promise_type> handle) noexcept :
+		handle_{ handle }
+	{}
+
+	CommandTask::CommandTask(CommandTask&& other) noexcept :
+		handle_{ std::exchange(other.handle_, nullptr) }
+	{}
+
+	CommandTask& CommandTask::operator=(CommandTask&& other) noexcept {
+		if (this != &other) {
+			if (handle_) {
+				handle_.destroy();
+			}
+			handle_ = std::exchange(other.handle_, nullptr);
+		}
+
+		return *this;
+	}
+
+	CommandTask::~CommandTask() {
+		if (handle_) {
+			handle_.destroy();
+		}
+	}
+
+	int CommandTask::Wait() {
+		int result = 0;
+		std::exception_ptr exception{};
+
+		AwaitBlocking(*this, result, exception).Run();
+
+		if (exception) {
+			std::rethrow_exception(exception);
+		}
+
+		return result;
+	}
+
+	bool CommandTask::await_ready() const noexcept {
+		return !handle_ || handle_.done();
+	}
+
+	std::coroutine_handle<> CommandTask::await_suspend(std::coroutine_handle<> awaiting) noexcept {
+		handle_.promise().continuation_ = awaiting;
+		return handle_;
+	}
+
+	int CommandTask::await_resume() const {
+		if (!handle_) {
+			throw std::logic_error{ "awaited an empty command task" };
+		}
+
+		if (handle_.promise().exception_) {
+			std::rethrow_exception(handle_.promise().exception_);
+		}
+
+		return handle_.promise().result_;
+	}
+
+	void detail::FutureState::SetResult(int result) {
+		std::unique_lock lock{ mutex_ };
+		result_ = result;
+		Complete(lock);
+	}
+
+	void detail::FutureState::SetException(std::exception_ptr exception) {
+		std::unique_lock lock{ mutex_ };
+		exception_ = std::move(exception);
+		Complete(lock);
+	}
+
+	bool detail::FutureState::IsReady() const {
+		std::lock_guard lock{ mutex_ };
+		return result_ || exception_;
+	}
+
+	void detail::FutureState::Wait() const {
+		std::unique_lock lock{ mutex_ };
+		ready_condition_.wait(lock, [this] { return result_ || exception_; });
+	}
+
+	int detail::FutureState::Get() const {
+		Wait();
+
+		if (exception_) {
+			std::rethrow_exception(exception_);
+		}
+
+		return *result_;
+	}
+
+	bool detail::FutureState::SetContinuation(std::coroutine_handle<> continuation) {
+		std::lock_guard lock{ mutex_ };
+		if (result_ || exception_) {
+			return false;
+		}
+
+		continuation_ = continuation;
+		return true;
+	}
+
+	void detail::FutureState::Complete(std::unique_lock<std::mutex>& lock) {
+		const std::coroutine_handle<> continuation = std::exchange(continuation_, nullptr);
+		lock.unlock();
+		ready_condition_.notify_all();
+
+		if (continuation) {
+			continuation.resume();
+		}
+	}
+
+	CommandFuture::CommandFuture(std::shared_ptr<detail::FutureState> state) noexcept :
+		state_{ std::move(state) }
+	{}
+
+	CommandFuture CommandFuture::FromResult(int result) {
+		auto state = std::make_shared<detail::FutureState>();
+		state->SetResult(result);
+		return CommandFuture{ std::move(state) };
+	}
+
+	bool CommandFuture::IsValid() const noexcept {
+		return state_ != nullptr;
+	}
+
+	bool CommandFuture::IsReady() const {
+		return state_->IsReady();
+	}
+
+	void CommandFuture::Wait() const {
+		state_->Wait();
+	}
+
+	int CommandFuture::Get() const {
+		return state_->Get();
+	}
+
+	bool CommandFuture::await_ready() const {
+		return state_->IsReady();
+	}
+
+	bool CommandFuture::await_suspend(std::coroutine_handle<> awaiting) {
+		return state_->SetContinuation(awaiting);
+	}
+
+	int CommandFuture::await_resume() const {
+		return state_->Get();
+	}
+}
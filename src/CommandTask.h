@@ -0,0 +1,120 @@
+#ifndef COMAD_COMMAND_TASK_H_
+#define COMAD_COMMAND_TASK_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace comad::command {
+	// return type of executors that are coroutines. the coroutine starts when it is first awaited
+	// and can suspend on anything, the thread that resumes it keeps running the executor
+	class CommandTask {
+	public:
+		class promise_type {
+		public:
+			// hands the thread over to whoever awaited the task
+			struct FinalAwaiter {
+				bool await_ready() const noexcept;
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> finished) const noexcept;
+				void await_resume() const noexcept;
+			};
+
+			CommandTask get_return_object() noexcept;
+			std::suspend_always initial_suspend() const noexcept;
+			FinalAwaiter final_suspend() const noexcept;
+			void return_value(int result) noexcept;
+			void unhandled_exception() noexcept;
+
+		private:
+			int result_{ 0 };
+			std::exception_ptr exception_{ };
+			std::coroutine_handle<> continuation_{ std::noop_coroutine() };
+
+			friend class CommandTask;
+		};
+
+		CommandTask() noexcept = default;
+		CommandTask(CommandTask&& other) noexcept;
+		CommandTask& operator=(CommandTask&& other) noexcept;
+		~CommandTask();
+
+		CommandTask(const CommandTask&) = delete;
+		CommandTask& operator=(const CommandTask&) = delete;
+
+		// runs the coroutine and blocks the calling thread until it has finished
+		int Wait();
+
+		[[nodiscard]] bool await_ready() const noexcept;
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept;
+		int await_resume() const;
+
+	private:
+		std::coroutine_handle<promise_type> handle_{ };
+
+		explicit CommandTask(std::coroutine_handle<promise_type> handle) noexcept;
+	};
+
+	namespace detail {
+		// shared between a CommandFuture and whoever runs its command
+		class FutureState {
+		public:
+			void SetResult(int result);
+			void SetException(std::exception_ptr exception);
+
+			[[nodiscard]] bool IsReady() const;
+			void Wait() const;
+
+			template <typename Rep, typename Period>
+			bool WaitFor(const std::chrono::duration<Rep, Period>& timeout) const;
+
+			int Get() const;
+
+			// false if the state is already ready and continuation should not suspend
+			bool SetContinuation(std::coroutine_handle<> continuation);
+
+		private:
+			mutable std::mutex mutex_{ };
+			mutable std::condition_variable ready_condition_{ };
+			std::optional<int> result_{ };
+			std::exception_ptr exception_{ };
+			std::coroutine_handle<> continuation_{ };
+
+			void Complete(std::unique_lock<std::mutex>& lock);
+		};
+	}
+
+	// the result of a command that runs on a thread pool. it can be waited on from any thread or
+	// awaited by one coroutine, which is then resumed on the thread that finished the command
+	class CommandFuture {
+	public:
+		CommandFuture() noexcept = default;
+		explicit CommandFuture(std::shared_ptr<detail::FutureState> state) noexcept;
+
+		// for commands that fail before they reach an executor
+		static CommandFuture FromResult(int result);
+
+		[[nodiscard]] bool IsValid() const noexcept;
+		[[nodiscard]] bool IsReady() const;
+		void Wait() const;
+
+		template <typename Rep, typename Period>
+		bool WaitFor(const std::chrono::duration<Rep, Period>& timeout) const;
+
+		// waits for the command and returns its result, rethrows what the executor threw
+		int Get() const;
+
+		[[nodiscard]] bool await_ready() const;
+		bool await_suspend(std::coroutine_handle<> awaiting);
+		int await_resume() const;
+
+	private:
+		std::shared_ptr<detail::FutureState> state_{ };
+	};
+}
+
+#include "CommandTask.tcc"
+#endif
@@ -0,0 +1,19 @@
+#ifndef COMAD_COMMAND_TASK_TCC_
+#define COMAD_COMMAND_TASK_TCC_
+
+#include "CommandTask.h"
+
+namespace comad::command {
+	template <typename Rep, typename Period>
+	bool detail::FutureState::WaitFor(const std::chrono::duration<Rep, Period>& timeout) const {
+		std::unique_lock lock{ mutex_ };
+		return ready_condition_.wait_for(lock, timeout, [this] { return result_ || exception_; });
+	}
+
+	template <typename Rep, typename Period>
+	bool CommandFuture::WaitFor(const std::chrono::duration<Rep, Period>& timeout) const {
+		return state_->WaitFor(timeout);
+	}
+}
+
+#endif
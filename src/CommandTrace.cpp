@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <atomic>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+#include "CommandTrace.h"
+
+namespace comad::command {
+	namespace {
+		std::uint32_t GetThreadNumber() noexcept {
+			static std::atomic<std::uint32_t> next{ 1 };
+			thread_local const std::uint32_t number = next.fetch_add(1, std::memory_order_relaxed);
+			return number;
+		}
+
+		std::uint64_t NextTraceId() noexcept {
+			static std::atomic<std::uint64_t> next{ 1 };
+			return next.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// microseconds with nanosecond precision, earlier points than the epoch are clamped to it
+		std::string ToMicroseconds(TraceSpan::clock::duration duration) {
+			const std::int64_t nanoseconds = std::max<std::int64_t>(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(), 0);
+			return std::format("{}.{:03}", nanoseconds / 1000, nanoseconds % 1000);
+		}
+
+		void WriteJsonString(std::ostream& stream, std::string_view str) {
+			constexpr std::string_view kHex{ "0123456789abcdef" };
+
+			stream << '"';
+			for (const char c : str) {
+				switch (c) {
+					case '"': stream << "\\\""; break;
+					case '\\': stream << "\\\\"; break;
+					case '\n': stream << "\\n"; break;
+					case '\r': stream << "\\r"; break;
+					case '\t': stream << "\\t"; break;
+					default: {
+						const auto byte = static_cast<unsigned char>(c);
+						if (byte < 0x20) {
+							stream << "\\u00" << kHex[byte >> 4] << kHex[byte & 0xF];
+						}
+						else {
+							stream << c;
+						}
+					}
+				}
+			}
+			stream << '"';
+		}
+	}
+
+	ChromeTraceSink::ChromeTraceSink(std::ostream& stream) :
+		stream_{ stream },
+		epoch_{ TraceSpan::clock::now() }
+	{}
+
+	ChromeTraceSink::~ChromeTraceSink() {
+		Close();
+	}
+
+	void ChromeTraceSink::Write(const Trace& trace) {
+		const std::scoped_lock lock{ mutex_ };
+		if (closed_) {
+			return;
+		}
+
+		for (const TraceSpan& span : trace.spans) {
+			stream_ << (empty_ ? "{\"traceEvents\":[\n" : ",\n");
+			empty_ = false;
+
+			stream_ << "{\"name\":";
+			WriteJsonString(stream_, span.name);
+			stream_ << std::format(R"(,"cat":"comad","ph":"X","ts":{},"dur":{},"pid":1,"tid":{},"args":{{"trace":{},"detail":)",
+				ToMicroseconds(span.start - epoch_), ToMicroseconds(span.duration), trace.thread, trace.id);
+			WriteJsonString(stream_, span.detail);
+			if (&span == &trace.spans.back()) {
+				stream_ << ",\"result\":" << trace.result;
+			}
+			stream_ << "}}";
+		}
+	}
+
+	void ChromeTraceSink::Close() {
+		const std::scoped_lock lock{ mutex_ };
+		if (closed_) {
+			return;
+		}
+
+		closed_ = true;
+		stream_ << (empty_ ? "{\"traceEvents\":[" : "\n") << "],\"displayTimeUnit\":\"ns\"}\n";
+		stream_.flush();
+	}
+
+	Tracer::Tracer(std::shared_ptr<TraceSink> sink, std::uint32_t sample_every) :
+		sink_{ std::move(sink) },
+		sample_every_{ sample_every }
+	{
+		if (sink_ == nullptr) {
+			throw std::invalid_argument{ "a tracer needs a sink" };
+		}
+		if (sample_every_ == 0) {
+			throw std::invalid_argument{ "sample_every has to be at least 1" };
+		}
+	}
+
+	bool Tracer::ShouldSample() const noexcept {
+		// counted per thread, so sampling does not contend between dispatching threads
+		thread_local std::uint64_t dispatches = 0;
+		return dispatches++ % sample_every_ == 0;
+	}
+
+	void Tracer::Submit(const Trace& trace) const {
+		sink_->Write(trace);
+	}
+
+	std::uint32_t Tracer::GetSampleEvery() const noexcept {
+		return sample_every_;
+	}
+
+	const std::shared_ptr<TraceSink>& Tracer::GetSink() const noexcept {
+		return sink_;
+	}
+
+	detail::TraceRecorder::TraceRecorder(bool active) :
+		active_{ active },
+		outer_{ std::exchange(GetCurrentSlot(), active ? this : nullptr) }
+	{
+		if (active_) {
+			trace_.id = NextTraceId();
+			trace_.thread = GetThreadNumber();
+			trace_.spans.reserve(16);
+			start_ = TraceSpan::clock::now();
+		}
+	}
+
+	detail::TraceRecorder::~TraceRecorder() {
+		GetCurrentSlot() = outer_;
+	}
+
+	bool detail::TraceRecorder::IsActive() const noexcept {
+		return active_;
+	}
+
+	void detail::TraceRecorder::Add(std::string_view name, std::string_view detail, TraceSpan::clock::time_point start) {
+		trace_.spans.push_back(TraceSpan{ name, std::string{ detail }, start, TraceSpan::clock::now() - start });
+	}
+
+	const Trace& detail::TraceRecorder::Finish(std::string_view detail, int result) {
+		trace_.result = result;
+		Add(kSpanDispatch, detail, start_);
+		return trace_;
+	}
+
+	detail::TraceRecorder* detail::TraceRecorder::GetCurrent() noexcept {
+		return GetCurrentSlot();
+	}
+
+	detail::TraceRecorder*& detail::TraceRecorder::GetCurrentSlot() noexcept {
+		thread_local TraceRecorder* current = nullptr;
+		return current;
+	}
+}
@@ -0,0 +1,122 @@
+#ifndef COMAD_COMMAND_TRACE_H_
+#define COMAD_COMMAND_TRACE_H_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <ComadBuildOptions.h>
+
+namespace comad::command {
+	struct TraceSpan {
+		using clock = std::chrono::steady_clock;
+
+		// one of the kSpan names below
+		std::string_view name;
+		// the token, option or command the span worked on
+		std::string detail;
+		clock::time_point start;
+		clock::duration duration;
+	};
+
+	inline constexpr std::string_view kSpanDispatch{ "HandleCommand" };
+	inline constexpr std::string_view kSpanFindNode{ "FindNode" };
+	inline constexpr std::string_view kSpanParseOption{ "ParseOption" };
+	inline constexpr std::string_view kSpanStringToValue{ "StringToValue" };
+	inline constexpr std::string_view kSpanIsValueValid{ "IsValueValid" };
+	inline constexpr std::string_view kSpanRequiredCheck{ "RequiredOptionCheck" };
+	inline constexpr std::string_view kSpanExecutor{ "Executor" };
+
+	// the spans of one dispatch in the order they ended, the dispatch span itself is last
+	struct Trace {
+		std::uint64_t id;
+		// small numbers handed out to threads in the order they first trace
+		std::uint32_t thread;
+		// what the dispatch returned, 0 for asynchronous commands that were started
+		int result;
+		std::vector<TraceSpan> spans;
+	};
+
+	class TraceSink {
+	public:
+		virtual ~TraceSink() = default;
+
+		// called on the dispatching thread once the dispatch has finished, possibly from several threads at once
+		virtual void Write(const Trace& trace) = 0;
+	};
+
+	// writes complete events of the Chrome trace event format, which chrome://tracing and Perfetto open.
+	// timestamps are microseconds since the sink was created
+	class ChromeTraceSink : public TraceSink {
+	public:
+		explicit ChromeTraceSink(std::ostream& stream);
+		~ChromeTraceSink() override;
+
+		void Write(const Trace& trace) override;
+		// ends the JSON document, traces written after it are dropped
+		void Close();
+
+	private:
+		std::mutex mutex_{ };
+		std::ostream& stream_;
+		const TraceSpan::clock::time_point epoch_;
+		bool empty_{ true };
+		bool closed_{ false };
+	};
+
+	// hands every sample_every-th dispatch of a thread to the sink
+	class Tracer {
+	public:
+		explicit Tracer(std::shared_ptr<TraceSink> sink, std::uint32_t sample_every = 1);
+
+		[[nodiscard]] bool ShouldSample() const noexcept;
+		void Submit(const Trace& trace) const;
+
+		[[nodiscard]] std::uint32_t GetSampleEvery() const noexcept;
+		[[nodiscard]] const std::shared_ptr<TraceSink>& GetSink() const noexcept;
+
+	private:
+		std::shared_ptr<TraceSink> sink_;
+		std::uint32_t sample_every_;
+	};
+
+	namespace detail {
+		// collects the spans of a sampled dispatch. while one is alive, Traced calls on its thread are recorded
+		// into it. an inactive recorder hides the recorder of the dispatch it is nested in
+		class TraceRecorder {
+		public:
+			explicit TraceRecorder(bool active);
+			~TraceRecorder();
+
+			TraceRecorder(const TraceRecorder&) = delete;
+			TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+			[[nodiscard]] bool IsActive() const noexcept;
+			void Add(std::string_view name, std::string_view detail, TraceSpan::clock::time_point start);
+			// ends the dispatch span and returns the trace
+			const Trace& Finish(std::string_view detail, int result);
+
+			static TraceRecorder* GetCurrent() noexcept;
+
+		private:
+			Trace trace_{ };
+			TraceSpan::clock::time_point start_{ };
+			bool active_;
+			TraceRecorder* outer_;
+
+			static TraceRecorder*& GetCurrentSlot() noexcept;
+		};
+
+		// calls f, recording a span around it if the thread is tracing a dispatch
+		template <typename F>
+		decltype(auto) Traced(std::string_view name, std::string_view detail, F&& f);
+	}
+}
+
+#include "CommandTrace.tcc"
+#endif
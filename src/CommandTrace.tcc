@@ -0,0 +1,23 @@
+#ifndef COMAD_COMMAND_TRACE_TCC_
+#define COMAD_COMMAND_TRACE_TCC_
+
+#include "CommandTrace.h"
+
+namespace comad::command {
+	template <typename F>
+	decltype(auto) detail::Traced(std::string_view name, std::string_view detail, F&& f) {
+		if constexpr (build_options::EnableTracing) {
+			TraceRecorder* recorder = TraceRecorder::GetCurrent();
+			if (recorder != nullptr) {
+				const TraceSpan::clock::time_point start = TraceSpan::clock::now();
+				decltype(auto) result = f();
+				recorder->Add(name, detail, start);
+				return result;
+			}
+		}
+
+		return f();
+	}
+}
+
+#endif
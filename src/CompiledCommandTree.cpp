@@ -0,0 +1,111 @@
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "CompiledCommandTree.h"
+#include "ComadBuildOptions.h"
+#include "StringUtility.h"
+
+namespace comad::command {
+	using namespace logger;
+	using namespace build_options;
+
+	namespace {
+		struct Edge {
+			std::uint64_t hash;
+			CompiledCommandTree::NodeId parent;
+			CompiledCommandTree::NodeId child;
+			std::uint32_t name_offset;
+			std::uint32_t name_length;
+		};
+	}
+
+	CompiledCommandTree::CompiledCommandTree(const CommandNode& root) {
+		std::map<std::pair<NodeId, std::string_view>, NodeId> edge_map{};
+
+		nodes_.push_back(&root);
+		for (std::size_t index = 0; index < nodes_.size(); ++index) {
+			const CommandNode& node = *nodes_[index];
+			const NodeId id = static_cast<NodeId>(index);
+			std::map<std::string_view, NodeId, std::less<>> child_ids{};
+
+			for (const auto& [name, child] : node.GetChildren()) {
+				if (nodes_.size() >= kInvalidId) {
+					throw std::length_error("command tree has too many nodes to compile");
+				}
+
+				const NodeId child_id = static_cast<NodeId>(nodes_.size());
+				nodes_.push_back(&child);
+				child_ids.emplace(name, child_id);
+				edge_map.insert_or_assign({ id, name }, child_id);
+			}
+
+			// aliases shadow child names, the same way detail::FindNode resolves them
+			for (const auto& [alias, name] : node.GetChildAliasMapping()) {
+				auto it = child_ids.find(name);
+				if (it != child_ids.end()) {
+					edge_map.insert_or_assign({ id, alias }, it->second);
+				}
+			}
+		}
+
+		if (edge_map.empty()) {
+			return;
+		}
+
+		std::vector<Edge> edges{};
+		edges.reserve(edge_map.size());
+		for (const auto& [key, child] : edge_map) {
+			const auto& [parent, name] = key;
+			if (names_.size() + name.size() > std::numeric_limits<std::uint32_t>::max()) {
+				throw std::length_error("command tree names are too long to compile");
+			}
+
+			edges.push_back(Edge{
+				.hash = utility::HashString(name, parent),
+				.parent = parent,
+				.child = child,
+				.name_offset = static_cast<std::uint32_t>(names_.size()),
+				.name_length = static_cast<std::uint32_t>(name.size())
+			});
+			names_.append(name);
+		}
+
+		std::vector<std::uint64_t> hashes{};
+		hashes.reserve(edges.size());
+		for (const Edge& edge : edges) {
+			hashes.push_back(edge.hash);
+		}
+
+		utility::PerfectHash table = utility::PerfectHash::Build(hashes);
+		slots_.assign(table.slots.size(), Slot{});
+		for (std::size_t slot = 0; slot < table.slots.size(); ++slot) {
+			if (table.slots[slot] != utility::PerfectHash::kEmptySlot) {
+				const Edge& edge = edges[table.slots[slot]];
+				slots_[slot] = Slot{
+					.parent = edge.parent,
+					.child = edge.child,
+					.name_offset = edge.name_offset,
+					.name_length = edge.name_length
+				};
+			}
+		}
+		displacements_ = std::move(table.displacements);
+		bucket_mask_ = table.bucket_mask;
+		slot_mask_ = table.slot_mask;
+
+		LogDebug("compiled command tree with ", nodes_.size(), " nodes and ", edges.size(),
+			" edges into ", slots_.size(), " slots");
+	}
+
+	std::size_t CompiledCommandTree::GetNodeCount() const noexcept {
+		return nodes_.size();
+	}
+
+	void CompiledCommandTree::RebindRoot(const CommandNode& root) noexcept {
+		if (!nodes_.empty()) {
+			nodes_[kRootId] = &root;
+		}
+	}
+}
@@ -0,0 +1,52 @@
+#ifndef COMAD_COMPILED_COMMAND_TREE_H_
+#define COMAD_COMPILED_COMMAND_TREE_H_
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CommandNode.h"
+
+namespace comad::command {
+	class CommandImage;
+
+	class CompiledCommandTree {
+	public:
+		using NodeId = std::uint32_t;
+
+		static constexpr NodeId kRootId = 0;
+		static constexpr NodeId kInvalidId = std::numeric_limits<NodeId>::max();
+
+		CompiledCommandTree() = default;
+		explicit CompiledCommandTree(const CommandNode& root);
+
+		[[nodiscard]] NodeId FindChild(NodeId parent, std::string_view name) const noexcept;
+		[[nodiscard]] const CommandNode& GetNode(NodeId id) const noexcept;
+		[[nodiscard]] std::size_t GetNodeCount() const noexcept;
+
+		void RebindRoot(const CommandNode& root) noexcept;
+
+	private:
+		struct Slot {
+			NodeId parent{ kInvalidId };
+			NodeId child{ kInvalidId };
+			std::uint32_t name_offset{ 0 };
+			std::uint32_t name_length{ 0 };
+		};
+
+		std::vector<const CommandNode*> nodes_{};
+		std::vector<std::uint32_t> displacements_{};
+		std::vector<Slot> slots_{};
+		std::string names_{};
+		std::uint64_t bucket_mask_{ 0 };
+		std::uint64_t slot_mask_{ 0 };
+
+		// images are written from the compiled tables and looked up with the same hash
+		friend class CommandImage;
+	};
+}
+
+#include "CompiledCommandTree.tcc"
+#endif
@@ -0,0 +1,32 @@
+#ifndef COMAD_COMPILED_COMMAND_TREE_TCC_
+#define COMAD_COMPILED_COMMAND_TREE_TCC_
+
+#include <cstring>
+
+#include "CompiledCommandTree.h"
+#include "StringUtility.h"
+
+namespace comad::command {
+	inline CompiledCommandTree::NodeId CompiledCommandTree::FindChild(NodeId parent, std::string_view name) const noexcept {
+		if (slots_.empty()) {
+			return kInvalidId;
+		}
+
+		const std::uint64_t hash = utility::HashString(name, parent);
+		const std::uint32_t displacement = displacements_[(hash >> 32) & bucket_mask_];
+		const Slot& slot = slots_[utility::PerfectHash::SlotHash(hash, displacement) & slot_mask_];
+
+		if (slot.parent != parent || slot.name_length != name.size() ||
+			std::memcmp(names_.data() + slot.name_offset, name.data(), name.size()) != 0) {
+			return kInvalidId;
+		}
+
+		return slot.child;
+	}
+
+	inline const CommandNode& CompiledCommandTree::GetNode(NodeId id) const noexcept {
+		return *nodes_[id];
+	}
+}
+
+#endif
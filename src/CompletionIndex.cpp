@@ -0,0 +1,273 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <mutex>
+#include <utility>
+
+#include "CompletionIndex.h"
+#include "CommandNode.h"
+
+namespace comad::command {
+	namespace {
+		template <typename T>
+		std::string NumberToText(T number) {
+			std::array<char, 32> buffer{};
+			const auto [end, error] = std::to_chars(buffer.data(), buffer.data() + buffer.size(), number);
+			return std::string{ buffer.data(), end };
+		}
+
+		// the largest unit the amount is a whole number of, so the text parses back to the same value
+		template <std::size_t N>
+		std::string WithUnit(std::uint64_t amount, const std::array<std::pair<std::uint64_t, std::string_view>, N>& units) {
+			for (const auto& [size, unit] : units) {
+				if (amount != 0 && amount % size == 0) {
+					return NumberToText(amount / size) + std::string{ unit };
+				}
+			}
+			return NumberToText(amount) + std::string{ units.back().second };
+		}
+
+		std::string ValueToText(const value::ValueWrapper& value) {
+			using value::ValueType;
+
+			switch (value.GetType()) {
+				case ValueType::kBool: return value.GetValue<bool>() ? "true" : "false";
+				case ValueType::kInt: return NumberToText(value.GetValue<int>());
+				case ValueType::kFloat: return NumberToText(value.GetValue<float>());
+				case ValueType::kString: return std::string{ value.GetStringView() };
+				case ValueType::kInt64: return NumberToText(value.GetValue<std::int64_t>());
+				case ValueType::kUInt64: return NumberToText(value.GetValue<std::uint64_t>());
+				case ValueType::kDouble: return NumberToText(value.GetValue<double>());
+				case ValueType::kByteSize: {
+					constexpr std::array<std::pair<std::uint64_t, std::string_view>, 5> units{ {
+						{ 1ull << 40, "TiB" }, { 1ull << 30, "GiB" }, { 1ull << 20, "MiB" }, { 1ull << 10, "KiB" }, { 1, "B" }
+					} };
+					return WithUnit(value.GetValue<value::ByteSize>().bytes, units);
+				}
+				case ValueType::kDuration: {
+					const auto count = value.GetValue<value::Duration>().count();
+					if (count < 0) {
+						return NumberToText(count) + "ns";
+					}
+
+					constexpr std::array<std::pair<std::uint64_t, std::string_view>, 6> units{ {
+						{ 3'600'000'000'000, "h" }, { 60'000'000'000, "m" }, { 1'000'000'000, "s" },
+						{ 1'000'000, "ms" }, { 1'000, "us" }, { 1, "ns" }
+					} };
+					return WithUnit(static_cast<std::uint64_t>(count), units);
+				}
+				default: return {};
+			}
+		}
+
+		bool IsCommand(CompletionKind kind) noexcept {
+			return kind == CompletionKind::kCommand || kind == CompletionKind::kAlias;
+		}
+
+		std::uint64_t GetUses(const PrefixTrie::Entry& entry) noexcept {
+			return entry.node != nullptr ? entry.node->GetUseCount() : 0;
+		}
+	}
+
+	PrefixTrie::PrefixTrie(std::vector<Entry> entries) :
+		entries_{ std::move(entries) }
+	{
+		std::ranges::sort(entries_, {}, &Entry::text);
+		const auto duplicates = std::ranges::unique(entries_, {}, &Entry::text);
+		entries_.erase(duplicates.begin(), duplicates.end());
+
+		nodes_.push_back(TrieNode{ 0, 0, 0, 0, 0, static_cast<std::uint32_t>(entries_.size()) });
+		BuildChildren(0);
+	}
+
+	void PrefixTrie::BuildChildren(std::uint32_t index) {
+		const TrieNode node = nodes_[index];
+		const std::size_t depth = node.label_offset + node.label_length;
+
+		// entries that end here sort before the longer ones
+		std::uint32_t first = node.entry_begin;
+		while (first < node.entry_end && entries_[first].text.size() == depth) {
+			++first;
+		}
+
+		const auto first_child = static_cast<std::uint32_t>(nodes_.size());
+		while (first < node.entry_end) {
+			const char c = entries_[first].text[depth];
+			std::uint32_t last = first + 1;
+			while (last < node.entry_end && entries_[last].text[depth] == c) {
+				++last;
+			}
+
+			// the group is sorted, so its first and last entry share the longest prefix of all of them
+			const std::string_view front = entries_[first].text;
+			const std::string_view back = entries_[last - 1].text;
+			std::size_t common = depth + 1;
+			while (common < front.size() && common < back.size() && front[common] == back[common]) {
+				++common;
+			}
+
+			nodes_.push_back(TrieNode{ static_cast<std::uint32_t>(depth), static_cast<std::uint32_t>(common - depth),
+				0, 0, first, last });
+			first = last;
+		}
+
+		const auto child_count = static_cast<std::uint32_t>(nodes_.size()) - first_child;
+		nodes_[index].first_child = first_child;
+		nodes_[index].child_count = child_count;
+		for (std::uint32_t child = first_child; child < first_child + child_count; ++child) {
+			BuildChildren(child);
+		}
+	}
+
+	std::string_view PrefixTrie::GetLabel(const TrieNode& node) const noexcept {
+		return std::string_view{ entries_[node.entry_begin].text }.substr(node.label_offset, node.label_length);
+	}
+
+	std::span<const PrefixTrie::Entry> PrefixTrie::Find(std::string_view prefix) const noexcept {
+		if (nodes_.empty()) {
+			return {};
+		}
+
+		std::uint32_t current = 0;
+		std::size_t matched = 0;
+		while (matched < prefix.size()) {
+			const TrieNode& node = nodes_[current];
+			const auto children = std::span{ nodes_ }.subspan(node.first_child, node.child_count);
+			const auto child = std::ranges::lower_bound(children, prefix[matched], {}, [this](const TrieNode& candidate) {
+				return GetLabel(candidate).front();
+			});
+			if (child == children.end() || GetLabel(*child).front() != prefix[matched]) {
+				return {};
+			}
+
+			// the prefix may end inside the label
+			const std::string_view label = GetLabel(*child);
+			const std::size_t length = std::min(label.size(), prefix.size() - matched);
+			if (label.substr(0, length) != prefix.substr(matched, length)) {
+				return {};
+			}
+
+			matched += length;
+			current = node.first_child + static_cast<std::uint32_t>(child - children.begin());
+		}
+
+		const TrieNode& found = nodes_[current];
+		return std::span{ entries_ }.subspan(found.entry_begin, found.entry_end - found.entry_begin);
+	}
+
+	std::size_t PrefixTrie::GetSize() const noexcept {
+		return entries_.size();
+	}
+
+	CompletionIndex::CompletionIndex(const CommandNode& node) {
+		using namespace build_options;
+
+		std::vector<PrefixTrie::Entry> words{};
+		for (const auto& [name, child] : node.GetChildren()) {
+			words.push_back({ name, CompletionKind::kCommand, &child });
+		}
+		for (const auto& [alias, name] : node.GetChildAliasMapping()) {
+			words.push_back({ alias, CompletionKind::kAlias, &node.GetChild(name) });
+		}
+
+		if (node.GetExecutor()) {
+			const CommandTemplate& cmd_template = node.GetTemplate();
+			for (const std::string& flag : cmd_template.flags) {
+				words.push_back({ std::string{ FlagPrefix } + flag, CompletionKind::kFlag, nullptr });
+			}
+			for (const auto& [name, option] : cmd_template.options) {
+				words.push_back({ std::string{ OptionPrefix } + name, CompletionKind::kOption, nullptr });
+
+				std::vector<PrefixTrie::Entry> values{};
+				for (const value::ValueWrapper& listed : option.supported_values.GetListedValues()) {
+					values.push_back({ ValueToText(listed), CompletionKind::kValue, nullptr });
+				}
+				if (!values.empty()) {
+					values_.emplace(name, PrefixTrie{ std::move(values) });
+				}
+			}
+			for (const auto& [short_name, name] : node.GetShortOptionMapping()) {
+				words.push_back({ std::string{ ShortOptionPrefix } + short_name, CompletionKind::kOption, nullptr });
+			}
+		}
+
+		words_ = PrefixTrie{ std::move(words) };
+	}
+
+	void CompletionIndex::Complete(std::string_view prefix, bool commands, bool rank, std::size_t count,
+								   std::vector<Completion>& completions) const
+	{
+		const std::span<const PrefixTrie::Entry> found = words_.Find(prefix);
+		const auto wanted = [commands](const PrefixTrie::Entry& entry) {
+			return commands || !IsCommand(entry.kind);
+		};
+
+		if (!rank) {
+			for (const PrefixTrie::Entry& entry : found) {
+				if (completions.size() == count) {
+					break;
+				}
+				if (wanted(entry)) {
+					completions.push_back(Completion{ entry.text, entry.kind, GetUses(entry) });
+				}
+			}
+			return;
+		}
+
+		std::vector<std::pair<std::uint64_t, const PrefixTrie::Entry*>> ranked{};
+		ranked.reserve(found.size());
+		for (const PrefixTrie::Entry& entry : found) {
+			if (wanted(entry)) {
+				ranked.emplace_back(GetUses(entry), &entry);
+			}
+		}
+
+		// entries are in order in memory, so the pointer breaks ties between equally used ones
+		const auto middle = ranked.begin() + static_cast<std::ptrdiff_t>(std::min(count, ranked.size()));
+		std::partial_sort(ranked.begin(), middle, ranked.end(), [](const auto& lhs, const auto& rhs) {
+			return lhs.first != rhs.first ? lhs.first > rhs.first : lhs.second < rhs.second;
+		});
+		for (auto it = ranked.begin(); it != middle; ++it) {
+			completions.push_back(Completion{ it->second->text, it->second->kind, it->first });
+		}
+	}
+
+	void CompletionIndex::CompleteValue(std::string_view option, std::string_view prefix, std::size_t count,
+										std::vector<Completion>& completions) const
+	{
+		const auto values = values_.find(option);
+		if (values == values_.end()) {
+			return;
+		}
+
+		for (const PrefixTrie::Entry& entry : values->second.Find(prefix)) {
+			if (completions.size() == count) {
+				break;
+			}
+			completions.push_back(Completion{ entry.text, entry.kind, 0 });
+		}
+	}
+
+	std::size_t CompletionIndex::NameHash::operator()(std::string_view name) const noexcept {
+		return std::hash<std::string_view>{}(name);
+	}
+
+	const CompletionIndex& CompletionCache::GetIndex(const CommandNode& node) {
+		{
+			const std::shared_lock lock{ mutex_ };
+			if (const auto it = indexes_.find(&node); it != indexes_.end()) {
+				return *it->second;
+			}
+		}
+
+		// built outside the lock, a thread that loses the race drops its copy
+		auto index = std::make_unique<const CompletionIndex>(node);
+		const std::unique_lock lock{ mutex_ };
+		return *indexes_.try_emplace(&node, std::move(index)).first->second;
+	}
+
+	void CompletionCache::Invalidate() {
+		const std::unique_lock lock{ mutex_ };
+		indexes_.clear();
+	}
+}
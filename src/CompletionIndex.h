@@ -0,0 +1,105 @@
+#ifndef COMAD_COMPLETION_INDEX_H_
+#define COMAD_COMPLETION_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace comad::command {
+	class CommandNode;
+
+	enum class CompletionKind {
+		kCommand,
+		kAlias,
+		kFlag,
+		kOption,
+		kValue
+	};
+
+	struct Completion {
+		std::string text;
+		CompletionKind kind;
+		std::uint64_t uses;
+	};
+
+	// a compressed prefix trie: every trie node stands for the entries that share its path and, since the
+	// entries are sorted, those are one contiguous range
+	class PrefixTrie {
+	public:
+		struct Entry {
+			std::string text;
+			CompletionKind kind;
+			// the command an entry leads to, null for flags, options and values
+			const CommandNode* node;
+		};
+
+		PrefixTrie() = default;
+		explicit PrefixTrie(std::vector<Entry> entries);
+
+		// the entries starting with prefix, in order
+		[[nodiscard]] std::span<const Entry> Find(std::string_view prefix) const noexcept;
+		[[nodiscard]] std::size_t GetSize() const noexcept;
+
+	private:
+		struct TrieNode {
+			// the label is text[label_offset, label_offset + label_length) of the first entry below the node
+			std::uint32_t label_offset{ 0 };
+			std::uint32_t label_length{ 0 };
+			std::uint32_t first_child{ 0 };
+			std::uint32_t child_count{ 0 };
+			std::uint32_t entry_begin{ 0 };
+			std::uint32_t entry_end{ 0 };
+		};
+
+		std::vector<Entry> entries_{};
+		std::vector<TrieNode> nodes_{};
+
+		void BuildChildren(std::uint32_t index);
+		[[nodiscard]] std::string_view GetLabel(const TrieNode& node) const noexcept;
+	};
+
+	// what may follow a node on the command line: its children and aliases, and its flags and options spelled
+	// with their prefixes if it can be executed. the listed values of every option have a trie of their own
+	class CompletionIndex {
+	public:
+		CompletionIndex() = default;
+		explicit CompletionIndex(const CommandNode& node);
+
+		// at most count words starting with prefix, children and aliases only if commands is set. with rank
+		// set the most used commands come first, otherwise and between equally used words the order is kept
+		void Complete(std::string_view prefix, bool commands, bool rank, std::size_t count,
+					  std::vector<Completion>& completions) const;
+		// the listed values of the option with the long name option
+		void CompleteValue(std::string_view option, std::string_view prefix, std::size_t count,
+						   std::vector<Completion>& completions) const;
+
+	private:
+		struct NameHash {
+			using is_transparent = void;
+			std::size_t operator()(std::string_view name) const noexcept;
+		};
+
+		PrefixTrie words_{};
+		std::unordered_map<std::string, PrefixTrie, NameHash, std::equal_to<>> values_{};
+	};
+
+	// indexes of the nodes of a tree that does not change, built the first time a node is completed
+	class CompletionCache {
+	public:
+		const CompletionIndex& GetIndex(const CommandNode& node);
+		void Invalidate();
+
+	private:
+		std::shared_mutex mutex_{ };
+		std::unordered_map<const CommandNode*, std::unique_ptr<const CompletionIndex>> indexes_{ };
+	};
+}
+
+#endif
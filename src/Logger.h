@@ -1,15 +1,23 @@
 #ifndef COMAD_LOGGER_H_
 #define COMAD_LOGGER_H_
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
 #include <string_view>
 #include <format>
 #include <mutex>
+#include <optional>
 #include <sstream>
 #include <concepts>
 #include <source_location>
+#include <thread>
 #include <vector>
 #include <memory>
 
+#include "RingBuffer.h"
 #include "TypeTraits.h"
 
 namespace comad::logger {
@@ -19,6 +27,14 @@ namespace comad::logger {
 		INFO
 	};
 
+	template <LogLevel L>
+	inline constexpr bool kLevelEnabled =
+#ifdef NDEBUG
+		L != LogLevel::DEBUG;
+#else
+		true;
+#endif
+
 	template <typename T>
 	concept LoggableCharType =
 		std::same_as<T, char>;
@@ -34,6 +50,11 @@ namespace comad::logger {
 
 		template <LogLevel L>
 		constexpr std::vector<StreamRefWrapper>& GetStreamsFromLevel();
+
+		template <LogLevel L>
+		constexpr const std::vector<StreamRefWrapper>& GetStreamsFromLevel() const;
+
+		std::vector<StreamRefWrapper>& GetStreamsFromLevel(LogLevel level);
 	};
 
 	template <typename T, typename CharT>
@@ -74,7 +95,42 @@ namespace comad::logger {
 		constexpr void SetSourceLocation(std::source_location loc);
 	};
 
-	struct TimeSpecifier {};
+	template <typename T>
+	concept TimeDependent = requires(T t, std::chrono::system_clock::time_point time) {
+		{ t.SetTime(time) } -> std::same_as<void>;
+	};
+
+	struct TimeSpecifier {
+		std::optional<std::chrono::system_clock::time_point> time{};
+
+		constexpr void SetTime(std::chrono::system_clock::time_point time);
+	};
+
+	enum class OverflowPolicy {
+		kDrop,
+		kBlock
+	};
+
+	struct AsyncOptions {
+		std::size_t capacity{ 8192 };
+		OverflowPolicy overflow{ OverflowPolicy::kDrop };
+		std::size_t batch_size{ 256 };
+	};
+
+	// messages up to kMaxMessageLength are copied into the record itself, longer ones go to the heap
+	template <LoggableCharType CharT>
+	struct LogRecord {
+		static constexpr std::size_t kMaxMessageLength = 256;
+
+		LogLevel level{ LogLevel::INFO };
+		std::source_location loc{};
+		std::chrono::system_clock::time_point time{};
+		std::size_t length{ 0 };
+		std::array<CharT, kMaxMessageLength> msg{};
+		std::basic_string<CharT> long_msg{};
+
+		[[nodiscard]] std::basic_string_view<CharT> GetMessage() const noexcept;
+	};
 
 	template <LoggableCharType CharT = char, typename... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
 	class Logger {
@@ -114,9 +170,25 @@ namespace comad::logger {
 		template <LogLevel L>
 		void Log(std::string_view msg, std::source_location loc = std::source_location::current());
 
+		template <LogLevel L, typename... Parts>
+		void LogParts(std::source_location loc, const Parts&... parts);
+
+		template <LogLevel L>
+		[[nodiscard]] bool HasSinks() const noexcept;
+
+		// hands formatting and writing to a background thread; messages longer than
+		// LogRecord::kMaxMessageLength are copied to the heap. must not race with logging calls
+		void EnableAsync(AsyncOptions options = {});
+		void DisableAsync();
+		[[nodiscard]] bool IsAsync() const noexcept;
+		// blocks until every message logged before the call has been written
+		void Flush();
+		[[nodiscard]] std::uint64_t GetDroppedCount() const noexcept;
+
 		template <LogLevel L>
 		Streamable<L> MakeStream(std::source_location loc = std::source_location::current());
 
+		// specifiers are configuration; changing them must not race with logging calls
 		template <std::size_t Index> requires(Index < sizeof...(FmtTypes))
 		std::tuple_element_t<Index, std::tuple<FmtTypes...>>& GetSpecifierAtIndex();
 
@@ -128,25 +200,56 @@ namespace comad::logger {
 
 		~Logger();
 	private:
+		struct AsyncState;
+
 		StreamsType streams_;
 		std::format_string<FmtTypes&...> fmt_;
+		// prototype for the per-call copies that are filled in and formatted, so concurrent
+		// log calls never share format state
 		std::tuple<FmtTypes...> specifiers_;
 		std::shared_ptr<bool> alive_;
+		std::mutex sink_mutex_{};
+		std::unique_ptr<AsyncState> async_{};
+
+		void Write(LogLevel level, std::string_view msg, std::source_location loc, std::chrono::system_clock::time_point time);
+		void Enqueue(LogLevel level, std::string_view msg, std::source_location loc);
+		void RunAsyncWriter();
+		void FlushStreams();
 
 
-		void SetFmtLogLevel(LogLevel level);
-		void SetFmtMsg(std::string_view msg);
-		void SetFmtSrcLoc(std::source_location loc);
+		static void SetFmtLogLevel(std::tuple<FmtTypes...>& specifiers, LogLevel level);
+		static void SetFmtMsg(std::tuple<FmtTypes...>& specifiers, std::string_view msg);
+		static void SetFmtSrcLoc(std::tuple<FmtTypes...>& specifiers, std::source_location loc);
+		static void SetFmtTime(std::tuple<FmtTypes...>& specifiers, std::chrono::system_clock::time_point time);
 
 		template <std::size_t... Is>
-		void SetFmtLogLevelImpl(LogLevel level, std::integer_sequence<size_t, Is...>);
+		static void SetFmtLogLevelImpl(std::tuple<FmtTypes...>& specifiers, LogLevel level, std::integer_sequence<size_t, Is...>);
 
 		template <std::size_t... Is>
-		void SetFmtMsgImpl(std::string_view msg, std::integer_sequence<size_t, Is...>);
+		static void SetFmtMsgImpl(std::tuple<FmtTypes...>& specifiers, std::string_view msg, std::integer_sequence<size_t, Is...>);
 
 		template <std::size_t... Is>
-		void SetFmtSrcLocImpl(std::source_location loc, std::integer_sequence<size_t, Is...>);
+		static void SetFmtSrcLocImpl(std::tuple<FmtTypes...>& specifiers, std::source_location loc, std::integer_sequence<size_t, Is...>);
+
+		template <std::size_t... Is>
+		static void SetFmtTimeImpl(std::tuple<FmtTypes...>& specifiers, std::chrono::system_clock::time_point time, std::integer_sequence<size_t, Is...>);
+	};
+
+	template <typename... Parts>
+	struct LogDebug {
+		explicit LogDebug(const Parts&... parts, std::source_location loc = std::source_location::current());
 	};
+
+	template <typename... Parts>
+	struct LogError {
+		explicit LogError(const Parts&... parts, std::source_location loc = std::source_location::current());
+	};
+
+	template <typename... Parts>
+	LogDebug(const Parts&...) -> LogDebug<Parts...>;
+
+	template <typename... Parts>
+	LogError(const Parts&...) -> LogError<Parts...>;
 }
 
 #include "Logger.tcc"
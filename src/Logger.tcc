@@ -1,12 +1,15 @@
 #ifndef COMAD_LOGGER_TCC_
 #define COMAD_LOGGER_TCC_
 
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <regex>
 #include <string>
 #include <source_location>
+#include <type_traits>
 
+#include "ComadBuildOptions.h"
 #include "Logger.h"
 #include "TypeTraits.h"
 
@@ -86,7 +89,7 @@ struct std::formatter<comad::logger::TimeSpecifier, CharT> {
 
 	template<typename FormatContext>
 	typename FormatContext::iterator format(comad::logger::TimeSpecifier& spec, FormatContext& ctx) const {
-		return fmt.format(std::chrono::zoned_time{std::chrono::current_zone(), std::chrono::system_clock::now() }, ctx);
+		return fmt.format(std::chrono::zoned_time{std::chrono::current_zone(), spec.time.value_or(std::chrono::system_clock::now()) }, ctx);
 	}
 };
 
@@ -155,6 +158,7 @@ namespace comad::logger {
 	CONCEPT_TO_PRED(log_level_pred, LogLevelDependent);
 	CONCEPT_TO_PRED(msg_pred, MessageDependent);
 	CONCEPT_TO_PRED(src_loc_pred, SourceLocationDependent);
+	CONCEPT_TO_PRED(time_pred, TimeDependent);
 
 	constexpr void LogLevelSpecifier::SetLogLevel(LogLevel level) { this->level = level; }
 
@@ -162,6 +166,8 @@ namespace comad::logger {
 
 	constexpr void SourceLocationSpecifier::SetSourceLocation(std::source_location loc) { this->loc = loc; }
 
+	constexpr void TimeSpecifier::SetTime(std::chrono::system_clock::time_point time) { this->time = time; }
+
 	template<LoggableCharType CharT>
 	template<LogLevel L>
 	constexpr std::vector<typename LogStreams<CharT>::StreamRefWrapper> & LogStreams<CharT>::GetStreamsFromLevel() {
@@ -172,13 +178,45 @@ namespace comad::logger {
 			return debug;
 		}
 		else if constexpr (L == LogLevel::ERROR) {
-			return info;
+			return error;
 		}
 		else {
 			throw std::runtime_error{"log level not supported"};
 		}
 	}
 
+	template<LoggableCharType CharT>
+	template<LogLevel L>
+	constexpr const std::vector<typename LogStreams<CharT>::StreamRefWrapper> & LogStreams<CharT>::GetStreamsFromLevel() const {
+		return const_cast<LogStreams&>(*this).template GetStreamsFromLevel<L>();
+	}
+
+	template<LoggableCharType CharT>
+	std::vector<typename LogStreams<CharT>::StreamRefWrapper> & LogStreams<CharT>::GetStreamsFromLevel(LogLevel level) {
+		switch (level) {
+			case LogLevel::INFO: return info;
+			case LogLevel::DEBUG: return debug;
+			case LogLevel::ERROR: return error;
+			default: throw std::runtime_error{"log level not supported"};
+		}
+	}
+
+	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
+	struct Logger<CharT, FmtTypes...>::AsyncState {
+		explicit AsyncState(const AsyncOptions& async_options) :
+			options{ async_options },
+			queue{ async_options.capacity }
+		{}
+
+		AsyncOptions options;
+		utility::RingBuffer<LogRecord<CharT>> queue;
+		alignas(utility::kCacheLineSize) std::atomic<std::uint64_t> wake{ 0 };
+		alignas(utility::kCacheLineSize) std::atomic<std::size_t> written{ 0 };
+		std::atomic<std::uint64_t> dropped{ 0 };
+		std::atomic<bool> stopping{ false };
+		std::thread writer{};
+	};
+
 	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
 	template <LogLevel L>
 	Logger<CharT, FmtTypes...>::Streamable<L>::Streamable(Logger& logger,
@@ -292,20 +330,192 @@ namespace comad::logger {
 	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
 	template <LogLevel L>
 	void Logger<CharT, FmtTypes...>::Log(std::string_view msg, std::source_location loc) {
-		SetFmtLogLevel(L);
-		SetFmtMsg(msg);
-		SetFmtSrcLoc(loc);
+		if constexpr (!kLevelEnabled<L>) {
+			return;
+		}
+		else {
+			if (!HasSinks<L>()) {
+				return;
+			}
+
+			if (async_) {
+				Enqueue(L, msg, loc);
+			}
+			else {
+				Write(L, msg, loc, std::chrono::system_clock::now());
+			}
+		}
+	}
+
+	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
+	template <LogLevel L, typename... Parts>
+	void Logger<CharT, FmtTypes...>::LogParts(std::source_location loc, const Parts&... parts) {
+		if constexpr (kLevelEnabled<L>) {
+			// nothing is formatted unless a stream is listening at this level
+			if (!HasSinks<L>()) {
+				return;
+			}
+
+			std::basic_ostringstream<CharT> msg_buf{};
+			([&msg_buf](const auto& part) {
+				if constexpr (std::is_invocable_v<decltype(part)>) {
+					msg_buf << part();
+				}
+				else {
+					msg_buf << part;
+				}
+			}(parts), ...);
+
+			Log<L>(msg_buf.view(), loc);
+		}
+	}
+
+	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
+	template <LogLevel L>
+	bool Logger<CharT, FmtTypes...>::HasSinks() const noexcept {
+		return !streams_.template GetStreamsFromLevel<L>().empty();
+	}
+
+	template <LoggableCharType CharT>
+	std::basic_string_view<CharT> LogRecord<CharT>::GetMessage() const noexcept {
+		return long_msg.empty() ? std::basic_string_view<CharT>{ msg.data(), length } : long_msg;
+	}
+
+	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
+	void Logger<CharT, FmtTypes...>::EnableAsync(AsyncOptions options) {
+		DisableAsync();
+
+		async_ = std::make_unique<AsyncState>(options);
+		async_->writer = std::thread{ [this] { RunAsyncWriter(); } };
+	}
+
+	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
+	void Logger<CharT, FmtTypes...>::DisableAsync() {
+		if (!async_) {
+			return;
+		}
+
+		async_->stopping.store(true, std::memory_order_release);
+		async_->wake.fetch_add(1, std::memory_order_release);
+		async_->wake.notify_one();
+		async_->writer.join();
+
+		async_.reset();
+	}
+
+	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
+	bool Logger<CharT, FmtTypes...>::IsAsync() const noexcept {
+		return async_ != nullptr;
+	}
+
+	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
+	void Logger<CharT, FmtTypes...>::Flush() {
+		if (!async_) {
+			FlushStreams();
+			return;
+		}
+
+		// every record whose push started before this call has a position below the target
+		const std::size_t target = async_->queue.GetPushCount();
+		std::size_t written = async_->written.load(std::memory_order_acquire);
+		while (written < target) {
+			async_->written.wait(written, std::memory_order_acquire);
+			written = async_->written.load(std::memory_order_acquire);
+		}
+	}
+
+	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
+	std::uint64_t Logger<CharT, FmtTypes...>::GetDroppedCount() const noexcept {
+		return async_ ? async_->dropped.load(std::memory_order_relaxed) : 0;
+	}
+
+	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
+	void Logger<CharT, FmtTypes...>::Write(LogLevel level, std::string_view msg, std::source_location loc,
+	                                       std::chrono::system_clock::time_point time) {
+		std::tuple<FmtTypes...> specifiers = specifiers_;
+		SetFmtLogLevel(specifiers, level);
+		SetFmtMsg(specifiers, msg);
+		SetFmtSrcLoc(specifiers, loc);
+		SetFmtTime(specifiers, time);
 		std::string formatted = std::apply([&] (FmtTypes&... specifiers) {
 			return std::format(fmt_, specifiers...);
-		}, specifiers_);
-		if constexpr (L == LogLevel::DEBUG) {
-#ifdef NDEBUG
-			return;
-#endif
+		}, specifiers);
+		formatted.push_back('\n');
+
+		// only the write itself is serialized, so lines from different threads never interleave
+		std::scoped_lock lock{ sink_mutex_ };
+		for (typename StreamsType::StreamRefWrapper s: streams_.GetStreamsFromLevel(level)) {
+			s.get() << formatted;
 		}
+	}
 
-		for (typename StreamsType::StreamRefWrapper s: streams_.template GetStreamsFromLevel<L>()) {
-			s.get() << formatted << '\n';
+	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
+	void Logger<CharT, FmtTypes...>::Enqueue(LogLevel level, std::string_view msg, std::source_location loc) {
+		const std::chrono::system_clock::time_point time = std::chrono::system_clock::now();
+		// allocated before the push, so filling the record cannot throw
+		std::basic_string<CharT> long_msg{};
+		if (msg.size() > LogRecord<CharT>::kMaxMessageLength) {
+			long_msg.assign(msg);
+		}
+
+		auto fill = [&](LogRecord<CharT>& record) {
+			record.level = level;
+			record.loc = loc;
+			record.time = time;
+			record.length = long_msg.empty() ? msg.size() : 0;
+			std::copy_n(msg.data(), record.length, record.msg.data());
+			record.long_msg = std::move(long_msg);
+		};
+
+		while (!async_->queue.TryPush(fill)) {
+			if (async_->options.overflow == OverflowPolicy::kDrop) {
+				async_->dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			std::this_thread::yield();
+		}
+
+		async_->wake.fetch_add(1, std::memory_order_release);
+		async_->wake.notify_one();
+	}
+
+	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
+	void Logger<CharT, FmtTypes...>::RunAsyncWriter() {
+		AsyncState& state = *async_;
+		auto write_record = [this](const LogRecord<CharT>& record) {
+			Write(record.level, record.GetMessage(), record.loc, record.time);
+		};
+
+		while (true) {
+			const std::uint64_t observed = state.wake.load(std::memory_order_acquire);
+
+			std::size_t batch = 0;
+			while (batch < state.options.batch_size && state.queue.TryPop(write_record)) {
+				++batch;
+			}
+
+			if (batch > 0) {
+				// streams are flushed once per batch instead of once per record
+				FlushStreams();
+				state.written.fetch_add(batch, std::memory_order_release);
+				state.written.notify_all();
+				continue;
+			}
+
+			if (state.stopping.load(std::memory_order_acquire)) {
+				break;
+			}
+			state.wake.wait(observed, std::memory_order_acquire);
+		}
+	}
+
+	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
+	void Logger<CharT, FmtTypes...>::FlushStreams() {
+		std::scoped_lock lock{ sink_mutex_ };
+		for (auto* streams : { &streams_.info, &streams_.debug, &streams_.error }) {
+			for (typename StreamsType::StreamRefWrapper s : *streams) {
+				s.get().flush();
+			}
 		}
 	}
 
@@ -340,52 +550,68 @@ namespace comad::logger {
 
 	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
 	Logger<CharT, FmtTypes...>::~Logger() {
+		DisableAsync();
 		*alive_ = false;
 	}
 
 	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
-	void Logger<CharT, FmtTypes...>::SetFmtLogLevel(LogLevel level) {
+	void Logger<CharT, FmtTypes...>::SetFmtLogLevel(std::tuple<FmtTypes...>& specifiers, LogLevel level) {
 		using Seq = typename FmtPack::template PredIndexSequence<log_level_pred>;
 
 		if constexpr (Seq::size() > 0) {
-			SetFmtLogLevelImpl(level, Seq{});
+			SetFmtLogLevelImpl(specifiers, level, Seq{});
 		}
 	}
 
 	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
-	void Logger<CharT, FmtTypes...>::SetFmtMsg(std::string_view msg) {
+	void Logger<CharT, FmtTypes...>::SetFmtMsg(std::tuple<FmtTypes...>& specifiers, std::string_view msg) {
 		using Seq = typename FmtPack::template PredIndexSequence<msg_pred>;
 
 		if constexpr (Seq::size() > 0) {
-			SetFmtMsgImpl(msg, Seq{});
+			SetFmtMsgImpl(specifiers, msg, Seq{});
 		}
 	}
 
 	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
-	void Logger<CharT, FmtTypes...>::SetFmtSrcLoc(std::source_location loc) {
+	void Logger<CharT, FmtTypes...>::SetFmtSrcLoc(std::tuple<FmtTypes...>& specifiers, std::source_location loc) {
 		using Seq = typename FmtPack::template PredIndexSequence<src_loc_pred>;
 
 		if constexpr (Seq::size() > 0) {
-			SetFmtSrcLocImpl(loc, Seq{});
+			SetFmtSrcLocImpl(specifiers, loc, Seq{});
+		}
+	}
+
+	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
+	void Logger<CharT, FmtTypes...>::SetFmtTime(std::tuple<FmtTypes...>& specifiers, std::chrono::system_clock::time_point time) {
+		using Seq = typename FmtPack::template PredIndexSequence<time_pred>;
+
+		if constexpr (Seq::size() > 0) {
+			SetFmtTimeImpl(specifiers, time, Seq{});
 		}
 	}
 
 	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
 	template <std::size_t... Is>
-	void Logger<CharT, FmtTypes...>::SetFmtLogLevelImpl(LogLevel level, std::integer_sequence<size_t, Is...>) {
-		(std::get<Is>(specifiers_).SetLogLevel(level),...);
+	void Logger<CharT, FmtTypes...>::SetFmtLogLevelImpl(std::tuple<FmtTypes...>& specifiers, LogLevel level, std::integer_sequence<size_t, Is...>) {
+		(std::get<Is>(specifiers).SetLogLevel(level),...);
+	}
+
+	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
+	template <std::size_t... Is>
+	void Logger<CharT, FmtTypes...>::SetFmtMsgImpl(std::tuple<FmtTypes...>& specifiers, std::string_view msg, std::integer_sequence<size_t, Is...>) {
+		(std::get<Is>(specifiers).SetMsg(msg),...);
 	}
 
 	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
 	template <std::size_t... Is>
-	void Logger<CharT, FmtTypes...>::SetFmtMsgImpl(std::string_view msg, std::integer_sequence<size_t, Is...>) {
-		(std::get<Is>(specifiers_).SetMsg(msg),...);
+	void Logger<CharT, FmtTypes...>::SetFmtSrcLocImpl(std::tuple<FmtTypes...>& specifiers, std::source_location loc, std::integer_sequence<size_t, Is...>) {
+		(std::get<Is>(specifiers).SetSourceLocation(loc),...);
 	}
 
 	template<LoggableCharType CharT, typename ... FmtTypes> requires (Formattable<FmtTypes, CharT> && ...)
 	template <std::size_t... Is>
-	void Logger<CharT, FmtTypes...>::SetFmtSrcLocImpl(std::source_location loc, std::integer_sequence<size_t, Is...>) {
-		(std::get<Is>(specifiers_).SetSourceLocation(loc),...);
+	void Logger<CharT, FmtTypes...>::SetFmtTimeImpl(std::tuple<FmtTypes...>& specifiers, std::chrono::system_clock::time_point time, std::integer_sequence<size_t, Is...>) {
+		(std::get<Is>(specifiers).SetTime(time),...);
 	}
 
 	inline Logger comad_logger{
@@ -400,6 +626,20 @@ namespace comad::logger {
 					SourceLocationSpecifier{},
 					MessageSpecifier{}
 	};
+
+	template <typename... Parts>
+	LogDebug<Parts...>::LogDebug(const Parts&... parts, std::source_location loc) {
+		if constexpr (build_options::Verbose && kLevelEnabled<LogLevel::DEBUG>) {
+			comad_logger.LogParts<LogLevel::DEBUG>(loc, parts...);
+		}
+	}
+
+	template <typename... Parts>
+	LogError<Parts...>::LogError(const Parts&... parts, std::source_location loc) {
+		if constexpr (build_options::Verbose && kLevelEnabled<LogLevel::ERROR>) {
+			comad_logger.LogParts<LogLevel::ERROR>(loc, parts...);
+		}
+	}
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "CommandNode.h"
+#include "ResultCache.h"
+#include "StringUtility.h"
+
+namespace comad::command {
+	using namespace value;
+
+	namespace {
+		template <typename T>
+		void AppendBytes(std::string& key, const T& value) {
+			char bytes[sizeof(T)];
+			std::memcpy(bytes, &value, sizeof(T));
+			key.append(bytes, sizeof(T));
+		}
+
+		void AppendString(std::string& key, std::string_view str) {
+			AppendBytes(key, static_cast<std::uint32_t>(str.size()));
+			key.append(str);
+		}
+
+		template <typename T>
+		void AppendList(std::string& key, const std::vector<T>& list) {
+			AppendBytes(key, static_cast<std::uint32_t>(list.size()));
+			for (const T& element : list) {
+				if constexpr (std::is_same_v<T, std::string_view>) {
+					AppendString(key, element);
+				}
+				else if constexpr (std::is_floating_point_v<T>) {
+					AppendBytes(key, element == T{ 0 } ? T{ 0 } : element);
+				}
+				else {
+					AppendBytes(key, element);
+				}
+			}
+		}
+
+		void AppendValue(std::string& key, const ValueWrapper& value) {
+			key.push_back(static_cast<char>(value.GetType()));
+
+			switch (value.GetType()) {
+			case ValueType::kBool:
+				key.push_back(value.GetValue<bool>() ? 1 : 0);
+				break;
+			case ValueType::kInt:
+				AppendBytes(key, value.GetValue<int>());
+				break;
+			case ValueType::kFloat: {
+				// 0 and -0 compare equal, so they have to be the same key
+				const float number = value.GetValue<float>();
+				AppendBytes(key, number == 0.0f ? 0.0f : number);
+				break;
+			}
+			case ValueType::kString:
+				AppendString(key, value.GetStringView());
+				break;
+			case ValueType::kInt64:
+				AppendBytes(key, value.GetValue<std::int64_t>());
+				break;
+			case ValueType::kUInt64:
+				AppendBytes(key, value.GetValue<std::uint64_t>());
+				break;
+			case ValueType::kDouble: {
+				const double number = value.GetValue<double>();
+				AppendBytes(key, number == 0.0 ? 0.0 : number);
+				break;
+			}
+			case ValueType::kByteSize:
+				AppendBytes(key, value.GetValue<ByteSize>().bytes);
+				break;
+			case ValueType::kDuration:
+				AppendBytes(key, value.GetValue<Duration>().count());
+				break;
+			case ValueType::kIntList:
+				AppendList(key, value.GetValue<std::vector<int>>());
+				break;
+			case ValueType::kInt64List:
+				AppendList(key, value.GetValue<std::vector<std::int64_t>>());
+				break;
+			case ValueType::kUInt64List:
+				AppendList(key, value.GetValue<std::vector<std::uint64_t>>());
+				break;
+			case ValueType::kDoubleList:
+				AppendList(key, value.GetValue<std::vector<double>>());
+				break;
+			case ValueType::kStringList:
+				AppendList(key, value.GetValue<std::vector<std::string_view>>());
+				break;
+			default:
+				break;
+			}
+		}
+
+		void AppendValues(std::string& key, const SlotMap<ValueWrapper>& values) {
+			for (std::size_t slot = 0; slot < values.GetSlotCount(); ++slot) {
+				if (values.Has(slot)) {
+					AppendBytes(key, static_cast<std::uint32_t>(slot));
+					AppendValue(key, values.At(slot));
+				}
+			}
+			key.push_back('\0');
+		}
+	}
+
+	void ResultCache::BuildKey(const CommandNode& node, const ExecutionContext& ctx, std::string& key) {
+		AppendBytes(key, &node);
+
+		AppendValues(key, ctx.options);
+		AppendValues(key, ctx.args);
+
+		for (std::size_t slot = 0; slot < ctx.flags.GetSlotCount(); ++slot) {
+			key.push_back(ctx.flags.Has(slot) && ctx.flags.At(slot) ? 1 : 0);
+		}
+
+		AppendBytes(key, static_cast<std::uint32_t>(ctx.extra_args.size()));
+		for (const std::string_view extra_arg : ctx.extra_args) {
+			AppendString(key, extra_arg);
+		}
+	}
+
+	std::optional<int> ResultCache::Find(std::string_view key) {
+		Shard& shard = GetShard(key);
+
+		{
+			std::shared_lock lock{ shard.mutex };
+			const auto it = shard.entries.find(key);
+			if (it != shard.entries.end() &&
+				(it->second.expiry == clock::time_point::max() || clock::now() < it->second.expiry)) {
+				const int result = it->second.result;
+				lock.unlock();
+
+				shard.hits.fetch_add(1, std::memory_order_relaxed);
+				return result;
+			}
+		}
+
+		shard.misses.fetch_add(1, std::memory_order_relaxed);
+		return std::nullopt;
+	}
+
+	void ResultCache::Store(std::string key, const CommandNode* node, CachePolicy policy, std::uint64_t generation,
+							int result) {
+		Shard& shard = GetShard(key);
+		std::unique_lock lock{ shard.mutex };
+
+		// checked under the lock, an invalidation that has already advanced the generation clears the shard
+		// only after this has stored
+		if (generation_.load() != generation) {
+			return;
+		}
+
+		const clock::time_point now = clock::now();
+		const clock::time_point expiry = policy.ttl >= clock::time_point::max() - now ?
+			clock::time_point::max() : now + policy.ttl;
+
+		if (shard.entries.size() >= kMaxShardSize && !shard.entries.contains(key)) {
+			std::erase_if(shard.entries, [now](const auto& entry) { return entry.second.expiry <= now; });
+			if (shard.entries.size() >= kMaxShardSize) {
+				shard.entries.clear();
+			}
+		}
+
+		shard.entries.insert_or_assign(std::move(key), Entry{ node, result, expiry });
+	}
+
+	std::uint64_t ResultCache::GetGeneration() const noexcept {
+		return generation_.load();
+	}
+
+	void ResultCache::Invalidate() {
+		generation_.fetch_add(1);
+		for (Shard& shard : shards_) {
+			std::unique_lock lock{ shard.mutex };
+			shard.entries.clear();
+		}
+	}
+
+	void ResultCache::Invalidate(const CommandNode& node) {
+		for (Shard& shard : shards_) {
+			std::unique_lock lock{ shard.mutex };
+			std::erase_if(shard.entries, [&node](const auto& entry) { return entry.second.node == &node; });
+		}
+	}
+
+	CacheStats ResultCache::GetStats() const {
+		CacheStats stats{ 0, 0, 0 };
+		for (const Shard& shard : shards_) {
+			stats.hits += shard.hits.load(std::memory_order_relaxed);
+			stats.misses += shard.misses.load(std::memory_order_relaxed);
+
+			std::shared_lock lock{ shard.mutex };
+			stats.size += shard.entries.size();
+		}
+
+		return stats;
+	}
+
+	void ResultCache::ResetStats() noexcept {
+		for (Shard& shard : shards_) {
+			shard.hits.store(0, std::memory_order_relaxed);
+			shard.misses.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	std::size_t ResultCache::KeyHash::operator()(std::string_view key) const noexcept {
+		return static_cast<std::size_t>(utility::HashString(key));
+	}
+
+	ResultCache::Shard& ResultCache::GetShard(std::string_view key) noexcept {
+		// the low bits pick the bucket inside the shard, so the shard is taken from the high ones
+		return shards_[(utility::HashString(key) >> 60) % kShardCount];
+	}
+}
@@ -0,0 +1,83 @@
+#ifndef COMAD_RESULT_CACHE_H_
+#define COMAD_RESULT_CACHE_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "Command.h"
+
+namespace comad::command {
+	class CommandNode;
+
+	struct CacheStats {
+		std::uint64_t hits;
+		std::uint64_t misses;
+		std::size_t size;
+	};
+
+	// results of cacheable nodes, keyed by the node and the canonical form of the parsed context.
+	// lookups from any number of threads only share a lock with the lookups of the same shard
+	class ResultCache {
+	public:
+		static constexpr std::size_t kShardCount = 16;
+		// a full shard drops its expired entries first and everything if that is not enough
+		static constexpr std::size_t kMaxShardSize = 1024;
+
+		// appends the canonical form of ctx to key. options and flags are written in slot order and
+		// values as their parsed type, so the order and spelling of the input do not matter
+		static void BuildKey(const CommandNode& node, const ExecutionContext& ctx, std::string& key);
+
+		// counts a hit or a miss
+		[[nodiscard]] std::optional<int> Find(std::string_view key);
+		// generation is taken before the lookup that missed, the result is dropped if the cache has been
+		// invalidated since. results may arrive after the node has been changed or freed, so node is only
+		// compared and never read
+		void Store(std::string key, const CommandNode* node, CachePolicy policy, std::uint64_t generation, int result);
+
+		// advances with every invalidation of the whole cache
+		[[nodiscard]] std::uint64_t GetGeneration() const noexcept;
+
+		void Invalidate();
+		void Invalidate(const CommandNode& node);
+
+		[[nodiscard]] CacheStats GetStats() const;
+		void ResetStats() noexcept;
+
+	private:
+		using clock = std::chrono::steady_clock;
+
+		struct Entry {
+			const CommandNode* node;
+			int result;
+			clock::time_point expiry;
+		};
+
+		struct KeyHash {
+			using is_transparent = void;
+			std::size_t operator()(std::string_view key) const noexcept;
+		};
+
+		struct alignas(64) Shard {
+			mutable std::shared_mutex mutex{ };
+			std::unordered_map<std::string, Entry, KeyHash, std::equal_to<>> entries{ };
+			std::atomic<std::uint64_t> hits{ 0 };
+			std::atomic<std::uint64_t> misses{ 0 };
+		};
+
+		std::array<Shard, kShardCount> shards_{ };
+		std::atomic<std::uint64_t> generation_{ 0 };
+
+		Shard& GetShard(std::string_view key) noexcept;
+	};
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef COMAD_RING_BUFFER_H_
+#define COMAD_RING_BUFFER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace comad::utility {
+	inline constexpr std::size_t kCacheLineSize = 64;
+
+	template <typename T>
+	class RingBuffer {
+	public:
+		explicit RingBuffer(std::size_t capacity);
+
+		RingBuffer(const RingBuffer&) = delete;
+		RingBuffer& operator=(const RingBuffer&) = delete;
+
+		template <typename F>
+		bool TryPush(F&& fill);
+
+		template <typename F>
+		bool TryPop(F&& consume);
+
+		[[nodiscard]] std::size_t GetCapacity() const noexcept;
+		[[nodiscard]] std::size_t GetPushCount() const noexcept;
+
+	private:
+		struct Cell {
+			std::atomic<std::size_t> sequence;
+			T value;
+		};
+
+		std::unique_ptr<Cell[]> cells_;
+		std::size_t mask_;
+		alignas(kCacheLineSize) std::atomic<std::size_t> enqueue_pos_{ 0 };
+		alignas(kCacheLineSize) std::atomic<std::size_t> dequeue_pos_{ 0 };
+	};
+}
+
+#include "RingBuffer.tcc"
+#endif
@@ -0,0 +1,95 @@
+#ifndef COMAD_RING_BUFFER_TCC_
+#define COMAD_RING_BUFFER_TCC_
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <utility>
+
+#include "RingBuffer.h"
+
+namespace comad::utility {
+	template <typename T>
+	RingBuffer<T>::RingBuffer(std::size_t capacity) :
+		cells_{ std::make_unique<Cell[]>(std::bit_ceil(std::max<std::size_t>(capacity, 2))) },
+		mask_{ std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1 }
+	{
+		for (std::size_t i = 0; i <= mask_; ++i) {
+			cells_[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	// every cell carries a sequence number telling producers and consumers whose turn it is,
+	// so neither side ever takes a lock and a full or empty buffer is detected without blocking
+	template <typename T>
+	template <typename F>
+	bool RingBuffer<T>::TryPush(F&& fill) {
+		std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+		Cell* cell;
+
+		while (true) {
+			cell = &cells_[pos & mask_];
+			const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			const auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+
+			if (diff == 0) {
+				if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			}
+			else if (diff < 0) {
+				return false;
+			}
+			else {
+				pos = enqueue_pos_.load(std::memory_order_relaxed);
+			}
+		}
+
+		std::forward<F>(fill)(cell->value);
+		cell->sequence.store(pos + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	template <typename T>
+	template <typename F>
+	bool RingBuffer<T>::TryPop(F&& consume) {
+		std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+		Cell* cell;
+
+		while (true) {
+			cell = &cells_[pos & mask_];
+			const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			const auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos + 1);
+
+			if (diff == 0) {
+				if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			}
+			else if (diff < 0) {
+				return false;
+			}
+			else {
+				pos = dequeue_pos_.load(std::memory_order_relaxed);
+			}
+		}
+
+		std::forward<F>(consume)(cell->value);
+		cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	template <typename T>
+	std::size_t RingBuffer<T>::GetCapacity() const noexcept {
+		return mask_ + 1;
+	}
+
+	template <typename T>
+	std::size_t RingBuffer<T>::GetPushCount() const noexcept {
+		return enqueue_pos_.load(std::memory_order_acquire);
+	}
+}
+
+#endif
@@ -0,0 +1,234 @@
+#ifndef COMAD_SCHEMA_H_
+#define COMAD_SCHEMA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Command.h"
+#include "CommandHandler.h"
+#include "CommandNode.h"
+#include "StringUtility.h"
+#include "TokenTable.h"
+#include "Value.h"
+
+// commands that are known at build time can be declared as types instead of being built at runtime:
+//
+//   using Commands = Schema<Cmd<"foo", Arg<"bar1", int>, Opt<"level", float>, Exec<RunFoo>>>;
+//
+// the parser for a schema is generated from these types, names are compared against constants and
+// values are stored in typed context members, so dispatch never looks up maps or checks variants
+namespace comad::schema {
+	using utility::FixedString;
+
+	template <FixedString Name, value::ValidType T>
+	struct Arg {};
+
+	// like the _o literal, the short name defaults to the first character of the name
+	template <FixedString Name, value::ValidType T, bool Required = false, char ShortName = Name.data[0]>
+	struct Opt {};
+
+	template <FixedString Name>
+	struct Flag {};
+
+	template <FixedString Name>
+	struct Alias {};
+
+	// F is invoked with the typed context of its command and returns the command's result
+	template <auto F>
+	struct Exec {};
+
+	// Elements can be any mix of Arg, Opt, Flag, Alias, nested Cmd subcommands and at most one Exec
+	template <FixedString Name, typename... Elements>
+	struct Cmd {};
+
+	namespace detail {
+		inline constexpr std::size_t kNoMatch = std::numeric_limits<std::size_t>::max();
+
+		enum class ElementKind {
+			kArg,
+			kOpt,
+			kFlag,
+			kAlias,
+			kExec,
+			kCmd
+		};
+
+		// string values are views into the dispatched input, the same as borrowed runtime values
+		template <typename T>
+		using StorageType = std::conditional_t<std::is_same_v<T, std::string>, std::string_view, T>;
+
+		template <typename E>
+		struct ElementTraits;
+
+		template <FixedString Name, value::ValidType T>
+		struct ElementTraits<Arg<Name, T>> {
+			static constexpr ElementKind kind = ElementKind::kArg;
+			static constexpr auto name = Name;
+			static constexpr bool required = false;
+			static constexpr char short_name = 0;
+			using value_type = T;
+			using storage_type = StorageType<T>;
+		};
+
+		template <FixedString Name, value::ValidType T, bool Required, char ShortName>
+		struct ElementTraits<Opt<Name, T, Required, ShortName>> {
+			static constexpr ElementKind kind = ElementKind::kOpt;
+			static constexpr auto name = Name;
+			static constexpr bool required = Required;
+			static constexpr char short_name = ShortName;
+			using value_type = T;
+			using storage_type = std::conditional_t<Required, StorageType<T>, std::optional<StorageType<T>>>;
+		};
+
+		template <FixedString Name>
+		struct ElementTraits<Flag<Name>> {
+			static constexpr ElementKind kind = ElementKind::kFlag;
+			static constexpr auto name = Name;
+			static constexpr bool required = false;
+			static constexpr char short_name = 0;
+			using value_type = bool;
+			using storage_type = bool;
+		};
+
+		template <FixedString Name>
+		struct ElementTraits<Alias<Name>> {
+			static constexpr ElementKind kind = ElementKind::kAlias;
+			static constexpr auto name = Name;
+		};
+
+		template <auto F>
+		struct ElementTraits<Exec<F>> {
+			static constexpr ElementKind kind = ElementKind::kExec;
+			static constexpr auto function = F;
+		};
+
+		template <FixedString Name, typename... Elements>
+		struct ElementTraits<Cmd<Name, Elements...>> {
+			static constexpr ElementKind kind = ElementKind::kCmd;
+			static constexpr auto name = Name;
+		};
+
+		constexpr bool IsParamKind(ElementKind kind) noexcept;
+
+		// the elements of a command that are parameters, in declaration order, as a std::tuple
+		template <typename... Elements>
+		using ParamsOf = decltype(std::tuple_cat(std::declval<
+			std::conditional_t<IsParamKind(ElementTraits<Elements>::kind), std::tuple<Elements>, std::tuple<>>>()...));
+
+		template <ElementKind Kind, typename... Elements>
+		using ElementsOf = decltype(std::tuple_cat(std::declval<
+			std::conditional_t<ElementTraits<Elements>::kind == Kind, std::tuple<Elements>, std::tuple<>>>()...));
+
+		template <std::size_t I, typename... Params>
+		using ParamTraits = ElementTraits<std::tuple_element_t<I, std::tuple<Params...>>>;
+
+		// the length is compared first and the characters against a constant of known size after
+		template <FixedString Name>
+		constexpr bool EqualsName(std::string_view str) noexcept;
+
+		template <FixedString... Names>
+		constexpr std::size_t MatchName(std::string_view str) noexcept;
+
+		template <FixedString Name, typename... Params>
+		constexpr std::size_t FindParam() noexcept;
+
+		// index of the first Is for which pred holds, pred is called with an integral_constant
+		template <typename F, std::size_t... Is>
+		constexpr std::size_t FindIndex(F&& pred, std::index_sequence<Is...>);
+
+		// calls f with index as an integral_constant, so f can use it at compile time
+		template <typename F, std::size_t... Is>
+		constexpr void VisitIndex(std::size_t index, F&& f, std::index_sequence<Is...>);
+
+		template <typename T>
+		std::optional<StorageType<T>> ParseValue(std::string_view str);
+
+		struct ContextAccess;
+
+		template <typename Tuple>
+		struct ContextFromTuple;
+
+		template <typename C>
+		struct CommandTraits;
+	}
+
+	template <typename... Params>
+	class Context {
+	public:
+		static_assert(sizeof...(Params) <= 64, "a command can have at most 64 parameters");
+
+		// refer to the dispatched input like the runtime context, so only valid during the executor call
+		std::vector<std::string_view> extra_args{ };
+
+		// args are returned as their value type, strings as std::string_view, flags as bool and
+		// options as std::optional of the value type unless they are required
+		template <FixedString Name>
+		[[nodiscard]] const auto& Get() const noexcept;
+
+		template <FixedString Name>
+		[[nodiscard]] bool Has() const noexcept;
+
+	private:
+		std::tuple<typename detail::ElementTraits<Params>::storage_type...> values_{ };
+		std::uint64_t present_{ 0 };
+		int required_option_count_{ 0 };
+
+		friend struct detail::ContextAccess;
+	};
+
+	// free versions, so generic executors do not need the template keyword
+	template <FixedString Name, typename... Params>
+	[[nodiscard]] const auto& Get(const Context<Params...>& ctx) noexcept;
+
+	template <FixedString Name, typename... Params>
+	[[nodiscard]] bool Has(const Context<Params...>& ctx) noexcept;
+
+	template <typename... Params>
+	struct detail::ContextFromTuple<std::tuple<Params...>> {
+		using type = Context<Params...>;
+	};
+
+	template <typename C>
+	using ContextOf = typename detail::CommandTraits<C>::context_type;
+
+	template <typename... Commands>
+	class Schema {
+	public:
+		static_assert(((detail::ElementTraits<Commands>::kind == detail::ElementKind::kCmd) && ...),
+			"a schema can only contain Cmd elements");
+
+		// returns kUnknownCommand if the input does not name a command of the schema
+		template <std::ranges::input_range Range> requires
+			(std::is_constructible_v<std::string_view, std::ranges::range_value_t<Range>> ||
+			std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
+		static int HandleCommand(const Range& range);
+
+		// static and runtime commands can live together, input the schema does not know is
+		// dispatched through the handler's tree
+		template <std::ranges::input_range Range> requires
+			(std::is_constructible_v<std::string_view, std::ranges::range_value_t<Range>> ||
+			std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
+		static int HandleCommand(const command::CommandHandler& fallback, const Range& range);
+
+		// adds every command as a node of a runtime tree, the node's executor converts the runtime
+		// context and calls the command's typed executor
+		static void Install(command::CommandNode& root);
+
+	private:
+		template <std::ranges::input_range Range>
+		static bool TryDispatch(const Range& range, int& result);
+	};
+}
+
+#include "Schema.tcc"
+#endif
@@ -0,0 +1,523 @@
+#ifndef COMAD_SCHEMA_TCC_
+#define COMAD_SCHEMA_TCC_
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <ComadBuildOptions.h>
+#include <ComadReturnCodes.h>
+#include <Logger.tcc>
+
+#include "Schema.h"
+
+namespace comad::schema {
+	constexpr bool detail::IsParamKind(ElementKind kind) noexcept {
+		return kind == ElementKind::kArg || kind == ElementKind::kOpt || kind == ElementKind::kFlag;
+	}
+
+	template <FixedString Name>
+	constexpr bool detail::EqualsName(std::string_view str) noexcept {
+		return str.size() == Name.size() &&
+			std::char_traits<char>::compare(str.data(), Name.data, Name.size()) == 0;
+	}
+
+	template <FixedString... Names>
+	constexpr std::size_t detail::MatchName(std::string_view str) noexcept {
+		std::size_t index = 0;
+		std::size_t found = kNoMatch;
+		static_cast<void>(((EqualsName<Names>(str) ? (found = index, true) : (++index, false)) || ...));
+		return found;
+	}
+
+	template <FixedString Name, typename... Params>
+	constexpr std::size_t detail::FindParam() noexcept {
+		std::size_t index = 0;
+		std::size_t found = kNoMatch;
+		static_cast<void>(((ElementTraits<Params>::name.View() == Name.View() ? (found = index, true) : (++index, false)) || ...));
+		return found;
+	}
+
+	template <typename F, std::size_t... Is>
+	constexpr std::size_t detail::FindIndex(F&& pred, std::index_sequence<Is...>) {
+		std::size_t found = kNoMatch;
+		static_cast<void>(((pred(std::integral_constant<std::size_t, Is>{}) && (found = Is, true)) || ...));
+		return found;
+	}
+
+	template <typename F, std::size_t... Is>
+	constexpr void detail::VisitIndex(std::size_t index, F&& f, std::index_sequence<Is...>) {
+		static_cast<void>(((index == Is && (f(std::integral_constant<std::size_t, Is>{}), true)) || ...));
+	}
+
+	template <typename T>
+	std::optional<detail::StorageType<T>> detail::ParseValue(std::string_view str) {
+		using namespace std::string_view_literals;
+		using namespace build_options;
+		using namespace logger;
+
+		if constexpr (std::is_same_v<T, bool>) {
+			if (str == "0"sv || utility::EqualsIgnoreCase(str, "false"sv)) {
+				return false;
+			}
+			if (str == "1"sv || utility::EqualsIgnoreCase(str, "true"sv)) {
+				return true;
+			}
+
+			LogError(str, " cannot be converted to bool");
+			return std::nullopt;
+		}
+		else if constexpr (std::is_same_v<T, std::string>) {
+			return str;
+		}
+		else if constexpr (std::is_same_v<T, value::ByteSize>) {
+			return command::detail::ParseByteSize(str);
+		}
+		else if constexpr (std::is_same_v<T, value::Duration>) {
+			return command::detail::ParseDuration(str);
+		}
+		else if constexpr (value::ListValueType<T>) {
+			T list{};
+			if (!command::detail::AppendList(list, str)) {
+				return std::nullopt;
+			}
+			return list;
+		}
+		else {
+			return command::detail::OptionalFromChars<T>(str);
+		}
+	}
+
+	struct detail::ContextAccess {
+		template <typename... Params>
+		static int Parse(Context<Params...>& ctx, std::span<const command::Token> tokens);
+
+		template <typename... Params>
+		static void Load(Context<Params...>& ctx, const command::ExecutionContext& runtime_ctx);
+
+		template <std::size_t I, typename... Params>
+		static int SetOption(Context<Params...>& ctx, std::string_view value);
+
+		template <std::size_t I, typename... Params>
+		static void LoadParam(Context<Params...>& ctx, const command::ExecutionContext& runtime_ctx);
+	};
+
+	template <typename... Params>
+	int detail::ContextAccess::Parse(Context<Params...>& ctx, std::span<const command::Token> tokens) {
+		using namespace build_options;
+		using namespace logger;
+
+		using indices = std::index_sequence_for<Params...>;
+
+		// positions of the args among all parameters, the n-th positional token goes to arg_slots[n]
+		static constexpr auto arg_slots = [] {
+			std::array<std::size_t, ((ElementTraits<Params>::kind == ElementKind::kArg) + ... + 0)> slots{};
+			std::size_t index = 0;
+			std::size_t slot = 0;
+			((ElementTraits<Params>::kind == ElementKind::kArg ? (slots[slot++] = index++) : index++), ...);
+			return slots;
+		}();
+		constexpr int required_count = (ElementTraits<Params>::required + ... + 0);
+
+		const auto find_short = [](char short_name, bool bool_only) {
+			return FindIndex([short_name, bool_only](auto I) {
+				using traits = ParamTraits<I, Params...>;
+				return traits::kind == ElementKind::kOpt && traits::short_name == short_name &&
+					(!bool_only || std::is_same_v<typename traits::value_type, bool>);
+			}, indices{});
+		};
+		const auto set_option = [&ctx](std::size_t option, std::string_view value) {
+			int ret = retc::kOptionNotParsed;
+			VisitIndex(option, [&ctx, &ret, value](auto I) {
+				if constexpr (ParamTraits<I, Params...>::kind == ElementKind::kOpt) {
+					ret = SetOption<I>(ctx, value);
+				}
+			}, indices{});
+			return ret;
+		};
+
+		std::size_t arg_index = 0;
+		for (std::size_t i = 0; i < tokens.size(); ++i) {
+			const command::Token& token = tokens[i];
+
+			if (token.IsFlagPrefixed()) {
+				const std::string_view flag_name = token.GetFlagName();
+				const std::size_t flag = FindIndex([flag_name](auto I) {
+					using traits = ParamTraits<I, Params...>;
+					return traits::kind == ElementKind::kFlag && EqualsName<traits::name>(flag_name);
+				}, indices{});
+
+				if (flag != kNoMatch) {
+					VisitIndex(flag, [&ctx](auto I) {
+						if constexpr (ParamTraits<I, Params...>::kind == ElementKind::kFlag) {
+							std::get<I>(ctx.values_) = true;
+							ctx.present_ |= std::uint64_t{ 1 } << I;
+						}
+					}, indices{});
+					continue;
+				}
+				else if constexpr (!SkipUnknownFlag) {
+					LogError("unknown flag ", flag_name);
+					return retc::kUnknownFlag;
+				}
+			}
+
+			if (token.IsOption()) {
+				std::string_view name = token.GetOptionName();
+				std::optional<std::string_view> value{};
+				bool inline_value = false;
+
+				if (token.IsLongOption()) {
+					if (const std::size_t separator = name.find('='); separator != std::string_view::npos) {
+						value = name.substr(separator + 1);
+						name = name.substr(0, separator);
+						inline_value = true;
+					}
+				}
+
+				// a full name behind the short prefix is still accepted, as in -level 5
+				std::size_t option = token.IsShortOption() && name.size() == 1 ? find_short(name[0], false) : kNoMatch;
+				if (option == kNoMatch) {
+					option = FindIndex([name](auto I) {
+						using traits = ParamTraits<I, Params...>;
+						return traits::kind == ElementKind::kOpt && EqualsName<traits::name>(name);
+					}, indices{});
+				}
+
+				int ret = retc::kOptionNotParsed;
+				if (option == kNoMatch && token.IsShortOption() && name.size() > 1 && find_short(name[0], false) != kNoMatch) {
+					// -abc sets every bool option it names, otherwise the rest is the value of the first one as in -l5
+					inline_value = true;
+					if (std::ranges::all_of(name, [&find_short](char c) { return find_short(c, true) != kNoMatch; })) {
+						for (const char c : name) {
+							ret = set_option(find_short(c, true), "true");
+							if (ret != retc::kOptionParsed) {
+								break;
+							}
+						}
+					}
+					else {
+						ret = set_option(find_short(name[0], false), name.substr(1));
+					}
+				}
+				else if (option == kNoMatch) {
+					if constexpr (!SkipUnknownOption) {
+						LogError("unknown option ", name);
+						return retc::kUnknownOption;
+					}
+				}
+				else {
+					if (!inline_value && i + 1 < tokens.size()) {
+						value = tokens[i + 1].GetText();
+					}
+					if (value) {
+						ret = set_option(option, *value);
+					}
+				}
+
+				if (ret < 0) { return ret; }
+
+				if (ret == retc::kOptionParsed) {
+					i += !inline_value;
+					continue;
+				}
+			}
+
+			if (arg_index < arg_slots.size()) {
+				bool parsed = false;
+				VisitIndex(arg_slots[arg_index], [&ctx, &parsed, text = token.GetText()](auto I) {
+					using traits = ParamTraits<I, Params...>;
+					if constexpr (traits::kind == ElementKind::kArg) {
+						if (auto value = ParseValue<typename traits::value_type>(text)) {
+							std::get<I>(ctx.values_) = std::move(*value);
+							ctx.present_ |= std::uint64_t{ 1 } << I;
+							parsed = true;
+						}
+					}
+				}, indices{});
+
+				if (parsed) {
+					++arg_index;
+				}
+				else if constexpr (!SkipInvalidValueParse) {
+					LogError("invalid argument");
+					return retc::kInvalidValueParse;
+				}
+			}
+			else {
+				if constexpr (CacheExtraArgs) ctx.extra_args.push_back(token.GetText());
+			}
+		}
+
+		if (ctx.required_option_count_ < required_count) {
+			LogError("all required options have not been passed");
+			return retc::kMissingRequiredOptions;
+		}
+
+		return 0;
+	}
+
+	template <std::size_t I, typename... Params>
+	int detail::ContextAccess::SetOption(Context<Params...>& ctx, std::string_view value) {
+		using namespace build_options;
+		using namespace logger;
+
+		using traits = ParamTraits<I, Params...>;
+		// a list option is never a duplicate, every occurrence adds its elements
+		constexpr bool is_list = value::ListValueType<typename traits::value_type>;
+
+		const bool passed_before = (ctx.present_ >> I) & 1;
+		if constexpr (!SkipDupeOption && !is_list) {
+			if (passed_before) {
+				LogError("option ", traits::name.View(), " has already been passed");
+				return retc::kDupeOption;
+			}
+		}
+
+		auto parsed = ParseValue<typename traits::value_type>(value);
+		if (!parsed) {
+			if constexpr (!SkipInvalidValueParse) {
+				LogError("failed to parse value for option ", traits::name.View());
+				return retc::kInvalidValueParse;
+			}
+			else {
+				return retc::kOptionNotParsed;
+			}
+		}
+
+		if constexpr (is_list) {
+			if (passed_before) {
+				auto& stored = std::get<I>(ctx.values_);
+				auto& list = [&stored]() -> auto& {
+					if constexpr (traits::required) {
+						return stored;
+					}
+					else {
+						return *stored;
+					}
+				}();
+				list.insert(list.end(), parsed->begin(), parsed->end());
+				return retc::kOptionParsed;
+			}
+		}
+
+		// the first occurrence wins when duplicates are skipped
+		if (!passed_before) {
+			std::get<I>(ctx.values_) = std::move(*parsed);
+			ctx.present_ |= std::uint64_t{ 1 } << I;
+			ctx.required_option_count_ += traits::required;
+		}
+
+		return retc::kOptionParsed;
+	}
+
+	template <typename... Params>
+	void detail::ContextAccess::Load(Context<Params...>& ctx, const command::ExecutionContext& runtime_ctx) {
+		[&]<std::size_t... Is>(std::index_sequence<Is...>) {
+			(LoadParam<Is>(ctx, runtime_ctx), ...);
+		}(std::index_sequence_for<Params...>{});
+
+		ctx.extra_args.assign(runtime_ctx.extra_args.begin(), runtime_ctx.extra_args.end());
+	}
+
+	template <std::size_t I, typename... Params>
+	void detail::ContextAccess::LoadParam(Context<Params...>& ctx, const command::ExecutionContext& runtime_ctx) {
+		using traits = ParamTraits<I, Params...>;
+		using value_type = typename traits::value_type;
+
+		if constexpr (traits::kind == ElementKind::kFlag) {
+			const auto it = runtime_ctx.flags.find(traits::name.View());
+			if (it != runtime_ctx.flags.end() && it->second) {
+				std::get<I>(ctx.values_) = true;
+				ctx.present_ |= std::uint64_t{ 1 } << I;
+			}
+		}
+		else {
+			const auto& values = traits::kind == ElementKind::kArg ? runtime_ctx.args : runtime_ctx.options;
+			const auto it = values.find(traits::name.View());
+			if (it == values.end()) {
+				return;
+			}
+
+			if constexpr (std::is_same_v<value_type, std::string>) {
+				std::get<I>(ctx.values_) = it->second.GetStringView();
+			}
+			else {
+				std::get<I>(ctx.values_) = it->second.template GetValue<value_type>();
+			}
+			ctx.present_ |= std::uint64_t{ 1 } << I;
+			ctx.required_option_count_ += traits::required;
+		}
+	}
+
+	template <FixedString Name, typename... Elements>
+	struct detail::CommandTraits<Cmd<Name, Elements...>> {
+		using context_type = typename ContextFromTuple<ParamsOf<Elements...>>::type;
+
+		using aliases = ElementsOf<ElementKind::kAlias, Elements...>;
+		using children = ElementsOf<ElementKind::kCmd, Elements...>;
+		using executors = ElementsOf<ElementKind::kExec, Elements...>;
+
+		static_assert(std::tuple_size_v<executors> <= 1, "a command can only have one executor");
+		static constexpr bool has_executor = std::tuple_size_v<executors> == 1;
+
+		static bool Matches(std::string_view str) noexcept {
+			return []<typename... As>(std::tuple<As...>*, std::string_view str) {
+				return MatchName<Name, ElementTraits<As>::name...>(str) != kNoMatch;
+			}(static_cast<aliases*>(nullptr), str);
+		}
+
+		// tokens start with the name this command is tried against
+		static bool TryDispatch(std::span<const command::Token> tokens, int& result) {
+			using namespace build_options;
+			using namespace logger;
+
+			if (!Matches(tokens.front().GetText())) {
+				return false;
+			}
+
+			const std::span<const command::Token> rest = tokens.subspan(1);
+			const bool child_matched = !rest.empty() && []<typename... Cs>(std::tuple<Cs...>*, [[maybe_unused]] auto child_tokens, [[maybe_unused]] int& child_result) {
+				return (CommandTraits<Cs>::TryDispatch(child_tokens, child_result) || ...);
+			}(static_cast<children*>(nullptr), rest, result);
+
+			if (child_matched) {
+				return true;
+			}
+
+			if constexpr (has_executor) {
+				context_type ctx{};
+				result = ContextAccess::Parse(ctx, rest);
+				if (result >= 0) {
+					result = std::invoke(ElementTraits<std::tuple_element_t<0, executors>>::function, std::as_const(ctx));
+				}
+			}
+			else {
+				LogDebug("unknown command ", Name.View());
+				result = retc::kUnknownCommand;
+			}
+			return true;
+		}
+
+		static int Execute(const command::ExecutionContext& runtime_ctx) {
+			context_type ctx{};
+			ContextAccess::Load(ctx, runtime_ctx);
+			return std::invoke(ElementTraits<std::tuple_element_t<0, executors>>::function, std::as_const(ctx));
+		}
+
+		static void Install(command::CommandNode& parent) {
+			command::CommandNode& node = parent >> Name.View();
+
+			command::CommandTemplate cmd_template{};
+			([&cmd_template]<typename E>(std::type_identity<E>) {
+				using traits = ElementTraits<E>;
+
+				if constexpr (traits::kind == ElementKind::kAlias) {
+					cmd_template.aliases.emplace(traits::name.View());
+				}
+				else if constexpr (traits::kind == ElementKind::kFlag) {
+					cmd_template.flags.emplace(traits::name.View());
+				}
+				else if constexpr (traits::kind == ElementKind::kArg) {
+					cmd_template.args.emplace_back(std::string{ traits::name.View() },
+						value::ValueTypeTraits<typename traits::value_type>::type);
+				}
+				else if constexpr (traits::kind == ElementKind::kOpt) {
+					command::CommandOption option{};
+					option(value::ValueTypeTraits<typename traits::value_type>::type)[traits::required];
+					option.short_name = traits::short_name;
+					cmd_template.options.emplace(traits::name.View(), std::move(option));
+				}
+			}(std::type_identity<Elements>{}), ...);
+			node.SetTemplate(std::move(cmd_template));
+
+			if constexpr (has_executor) {
+				node = &Execute;
+			}
+
+			[&node]<typename... Cs>(std::tuple<Cs...>*) {
+				(CommandTraits<Cs>::Install(node), ...);
+			}(static_cast<children*>(nullptr));
+		}
+	};
+
+	template <typename... Params>
+	template <FixedString Name>
+	const auto& Context<Params...>::Get() const noexcept {
+		constexpr std::size_t index = detail::FindParam<Name, Params...>();
+		static_assert(index != detail::kNoMatch, "the command has no parameter with this name");
+		return std::get<index>(values_);
+	}
+
+	template <typename... Params>
+	template <FixedString Name>
+	bool Context<Params...>::Has() const noexcept {
+		constexpr std::size_t index = detail::FindParam<Name, Params...>();
+		static_assert(index != detail::kNoMatch, "the command has no parameter with this name");
+		return (present_ >> index) & 1;
+	}
+
+	template <FixedString Name, typename... Params>
+	const auto& Get(const Context<Params...>& ctx) noexcept {
+		return ctx.template Get<Name>();
+	}
+
+	template <FixedString Name, typename... Params>
+	bool Has(const Context<Params...>& ctx) noexcept {
+		return ctx.template Has<Name>();
+	}
+
+	template <typename... Commands>
+	template <std::ranges::input_range Range>
+	bool Schema<Commands...>::TryDispatch(const Range& range, int& result) {
+		const std::span<const command::Token> tokens =
+			command::detail::GetThreadTokenTable().Assign(std::ranges::begin(range), std::ranges::end(range));
+
+		return !tokens.empty() && (detail::CommandTraits<Commands>::TryDispatch(tokens, result) || ...);
+	}
+
+	template <typename... Commands>
+	template <std::ranges::input_range Range> requires
+		(std::is_constructible_v<std::string_view, std::ranges::range_value_t<Range>> ||
+		std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
+	int Schema<Commands...>::HandleCommand(const Range& range) {
+		using namespace build_options;
+		using namespace logger;
+
+		if (std::ranges::empty(range)) {
+			LogError("no input provided");
+			return retc::kNoInput;
+		}
+
+		int result = retc::kUnknownCommand;
+		if (!TryDispatch(range, result)) {
+			LogDebug("unknown command ", std::string_view{ *std::ranges::begin(range) });
+		}
+		return result;
+	}
+
+	template <typename... Commands>
+	template <std::ranges::input_range Range> requires
+		(std::is_constructible_v<std::string_view, std::ranges::range_value_t<Range>> ||
+		std::is_convertible_v<std::ranges::range_value_t<Range>, std::string_view>)
+	int Schema<Commands...>::HandleCommand(const command::CommandHandler& fallback, const Range& range) {
+		int result = retc::kUnknownCommand;
+		if (TryDispatch(range, result)) {
+			return result;
+		}
+
+		return fallback.HandleCommand(range);
+	}
+
+	template <typename... Commands>
+	void Schema<Commands...>::Install(command::CommandNode& root) {
+		(detail::CommandTraits<Commands>::Install(root), ...);
+	}
+}
+
+#endif
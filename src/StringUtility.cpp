@@ -0,0 +1,157 @@
+#include "StringUtility.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COMAD_HAS_SSE2 1
+#endif
+
+namespace comad::utility {
+	bool detail::HasWhitespaceVectorized(std::string_view str) noexcept {
+		const char* it = str.data();
+		const char* const end = it + str.size();
+
+		// a byte is whitespace if it is a space or if subtracting '\t' leaves it at most 4, unsigned
+#if defined(__AVX2__)
+		const __m256i space = _mm256_set1_epi8(' ');
+		const __m256i tab = _mm256_set1_epi8('\t');
+		const __m256i control_range = _mm256_set1_epi8('\r' - '\t');
+		for (; end - it >= 32; it += 32) {
+			const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+			const __m256i shifted = _mm256_sub_epi8(bytes, tab);
+			const __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, control_range), shifted);
+			if (_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(bytes, space), control)) != 0) {
+				return true;
+			}
+		}
+#elif defined(COMAD_HAS_SSE2)
+		const __m128i space = _mm_set1_epi8(' ');
+		const __m128i tab = _mm_set1_epi8('\t');
+		const __m128i control_range = _mm_set1_epi8('\r' - '\t');
+		for (; end - it >= 16; it += 16) {
+			const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+			const __m128i shifted = _mm_sub_epi8(bytes, tab);
+			const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, control_range), shifted);
+			if (_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, space), control)) != 0) {
+				return true;
+			}
+		}
+#endif
+
+		for (; it != end; ++it) {
+			if (IsWhitespace(*it)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void FindSeparators(std::string_view str, char separator, std::vector<std::uint32_t>& offsets) {
+		const char* const begin = str.data();
+		const char* it = begin;
+		const char* const end = it + str.size();
+
+		// every matching byte sets a bit of the mask, the bits are taken off from the lowest
+#if defined(__AVX2__)
+		const __m256i needle = _mm256_set1_epi8(separator);
+		for (; end - it >= 32; it += 32) {
+			const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+			auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, needle)));
+			for (; mask != 0; mask &= mask - 1) {
+				offsets.push_back(static_cast<std::uint32_t>(it - begin) + std::countr_zero(mask));
+			}
+		}
+#elif defined(COMAD_HAS_SSE2)
+		const __m128i needle = _mm_set1_epi8(separator);
+		for (; end - it >= 16; it += 16) {
+			const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+			auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, needle)));
+			for (; mask != 0; mask &= mask - 1) {
+				offsets.push_back(static_cast<std::uint32_t>(it - begin) + std::countr_zero(mask));
+			}
+		}
+#endif
+
+		for (; it != end; ++it) {
+			if (*it == separator) {
+				offsets.push_back(static_cast<std::uint32_t>(it - begin));
+			}
+		}
+	}
+
+	PerfectHash PerfectHash::Build(std::span<const std::uint64_t> hashes) {
+		constexpr std::uint32_t kMaxDisplacement = 1u << 16;
+
+		PerfectHash table{};
+		if (hashes.empty()) {
+			return table;
+		}
+
+		const std::size_t bucket_count = std::bit_ceil(std::max<std::size_t>(1, hashes.size() / 4));
+		std::size_t slot_count = std::bit_ceil(hashes.size() + hashes.size() / 4 + 1);
+
+		std::vector<std::vector<std::uint32_t>> buckets(bucket_count);
+		for (std::size_t i = 0; i < hashes.size(); ++i) {
+			buckets[(hashes[i] >> 32) & (bucket_count - 1)].push_back(static_cast<std::uint32_t>(i));
+		}
+		std::ranges::stable_sort(buckets, std::ranges::greater{}, &std::vector<std::uint32_t>::size);
+
+		table.bucket_mask = bucket_count - 1;
+		std::vector<std::uint64_t> candidates{};
+
+		// the largest buckets are placed first, while most slots are free. if a bucket fits nowhere, the
+		// slots are doubled and everything is placed again
+		bool placed = false;
+		while (!placed) {
+			table.slot_mask = slot_count - 1;
+			table.slots.assign(slot_count, kEmptySlot);
+			table.displacements.assign(bucket_count, 0);
+			placed = true;
+
+			for (const std::vector<std::uint32_t>& bucket : buckets) {
+				if (bucket.empty()) {
+					break;
+				}
+
+				bool found = false;
+				for (std::uint32_t displacement = 0; !found && displacement < kMaxDisplacement; ++displacement) {
+					candidates.clear();
+					found = true;
+
+					for (const std::uint32_t key : bucket) {
+						const std::uint64_t slot = SlotHash(hashes[key], displacement) & table.slot_mask;
+						if (table.slots[slot] != kEmptySlot || std::ranges::find(candidates, slot) != candidates.end()) {
+							found = false;
+							break;
+						}
+						candidates.push_back(slot);
+					}
+
+					if (found) {
+						table.displacements[(hashes[bucket.front()] >> 32) & table.bucket_mask] = displacement;
+						for (std::size_t i = 0; i < bucket.size(); ++i) {
+							table.slots[candidates[i]] = bucket[i];
+						}
+					}
+				}
+
+				if (!found) {
+					placed = false;
+					slot_count *= 2;
+					break;
+				}
+			}
+		}
+
+		return table;
+	}
+}
@@ -1,15 +1,71 @@
 #ifndef COMAD_STRING_UTILITY_H_
 #define COMAD_STRING_UTILITY_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include <ComadBuildOptions.h>
 
 namespace comad::utility {
+	// a string literal that can be passed as a template argument, the terminator is kept in data
+	template <std::size_t N>
+	struct FixedString {
+		char data[N]{};
+
+		constexpr FixedString(const char (&str)[N]) noexcept;
+
+		[[nodiscard]] constexpr std::size_t size() const noexcept;
+		[[nodiscard]] constexpr std::string_view View() const noexcept;
+	};
+
+	constexpr bool IsWhitespace(char c) noexcept;
+
 	constexpr bool HasWhitespace(std::string_view str);
 
+	// ASCII only, which is all the literals the library compares against need
+	constexpr bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs) noexcept;
+
 	constexpr std::string_view CStringToStringView(const char* c_str, std::size_t max_size = comad::build_options::kMaxCStringLength);
+
+	std::uint64_t HashString(std::string_view str, std::uint64_t seed = 0) noexcept;
+
+	constexpr std::uint64_t MixHash(std::uint64_t hash) noexcept;
+
+	// a perfect hash over a set of distinct hashes, built by hash and displace. keys are put into buckets
+	// by the high half of their hash and every bucket gets the first displacement that drops all of its
+	// keys into free slots, so a lookup is one hash, one slot and one compare
+	struct PerfectHash {
+		static constexpr std::uint32_t kEmptySlot = std::numeric_limits<std::uint32_t>::max();
+
+		std::vector<std::uint32_t> displacements{};
+		// the index of the hash placed in each slot, kEmptySlot for free ones
+		std::vector<std::uint32_t> slots{};
+		std::uint64_t bucket_mask{ 0 };
+		std::uint64_t slot_mask{ 0 };
+
+		static PerfectHash Build(std::span<const std::uint64_t> hashes);
+
+		// a key is looked up in SlotHash(hash, displacement of its bucket) & slot_mask
+		[[nodiscard]] static constexpr std::uint64_t SlotHash(std::uint64_t hash, std::uint32_t displacement) noexcept;
+	};
+
+	// splits a line with shell-like quoting and escapes. quotes and escapes are removed by
+	// compacting the line in place, so every token is a view into it. returns false if a quote
+	// is left open or the line ends with a lone backslash
+	bool TokenizeLine(std::span<char> line, std::vector<std::string_view>& tokens);
+
+	// appends the offset of every occurrence of separator in str, found a block of bytes at a time
+	void FindSeparators(std::string_view str, char separator, std::vector<std::uint32_t>& offsets);
+
+	namespace detail {
+		// SSE2/AVX2 scan behind HasWhitespace at runtime, scalar where neither is available
+		bool HasWhitespaceVectorized(std::string_view str) noexcept;
+	}
 }
 
 #include "StringUtility.tcc"
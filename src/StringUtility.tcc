@@ -1,27 +1,70 @@
 #ifndef COMAD_STRING_UTILITY_TCC_
 #define COMAD_STRING_UTILITY_TCC_
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <cmath>
 #include <stdexcept>
+#include <span>
 #include <string_view>
+#include <type_traits>
+#include <vector>
 
 #include "StringUtility.h"
 
 namespace comad::utility {
+	template <std::size_t N>
+	constexpr FixedString<N>::FixedString(const char (&str)[N]) noexcept {
+		std::copy_n(str, N, data);
+	}
+
+	template <std::size_t N>
+	constexpr std::size_t FixedString<N>::size() const noexcept {
+		return N - 1;
+	}
+
+	template <std::size_t N>
+	constexpr std::string_view FixedString<N>::View() const noexcept {
+		return { data, N - 1 };
+	}
+
+	constexpr bool IsWhitespace(char c) noexcept {
+		// '\t', '\n', '\v', '\f' and '\r' are the contiguous range 9-13
+		return c == ' ' || static_cast<unsigned char>(c - '\t') <= '\r' - '\t';
+	}
+
 	constexpr bool HasWhitespace(std::string_view str) {
-		using namespace std::string_view_literals;
+		if (!std::is_constant_evaluated()) {
+			return detail::HasWhitespaceVectorized(str);
+		}
 
 		for (char c : str) {
-			if (" \t\n\f\r\v"sv.find_first_of(c) != std::string_view::npos) {
+			if (IsWhitespace(c)) {
 				return true;
 			}
 		}
 		return false;
 	}
 
+	constexpr bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs) noexcept {
+		if (lhs.size() != rhs.size()) {
+			return false;
+		}
+
+		constexpr auto to_lower = [](char c) constexpr noexcept {
+			return c >= 'A' && c <= 'Z' ? static_cast<char>(c | 0x20) : c;
+		};
+
+		for (std::size_t i = 0; i < lhs.size(); ++i) {
+			if (to_lower(lhs[i]) != to_lower(rhs[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
+
 	constexpr std::string_view CStringToStringView(const char* c_str, std::size_t max_size) {
 		if (std::is_constant_evaluated()) {
 			std::size_t size = 0;
@@ -50,6 +93,100 @@ namespace comad::utility {
 			}
 		}
 	}
+
+	inline std::uint64_t HashString(std::string_view str, std::uint64_t seed) noexcept {
+		constexpr std::uint64_t kMultiplier = 0x9E3779B97F4A7C15ull;
+
+		std::uint64_t hash = MixHash(seed ^ (str.size() * kMultiplier));
+		const char* it = str.data();
+		std::size_t remaining = str.size();
+
+		for (; remaining >= sizeof(std::uint64_t); remaining -= sizeof(std::uint64_t), it += sizeof(std::uint64_t)) {
+			std::uint64_t word;
+			std::memcpy(&word, it, sizeof(word));
+			hash = MixHash(hash ^ word) * kMultiplier;
+		}
+
+		if (remaining > 0) {
+			std::uint64_t word = 0;
+			std::memcpy(&word, it, remaining);
+			hash = MixHash(hash ^ word) * kMultiplier;
+		}
+
+		return MixHash(hash);
+	}
+
+	inline bool TokenizeLine(std::span<char> line, std::vector<std::string_view>& tokens) {
+		tokens.clear();
+
+		char* in = line.data();
+		char* const end = in + line.size();
+
+		while (true) {
+			while (in != end && IsWhitespace(*in)) {
+				++in;
+			}
+			if (in == end || *in == '#') {
+				return true;
+			}
+
+			// unquoted tokens are never written to, only tokens that lose quotes or escapes are compacted
+			char* const token_begin = in;
+			char* out = in;
+			while (in != end && !IsWhitespace(*in)) {
+				const char c = *in++;
+				if (c == '\'') {
+					char* const closing = static_cast<char*>(std::memchr(in, '\'', end - in));
+					if (closing == nullptr) {
+						return false;
+					}
+					out = std::copy(in, closing, out);
+					in = closing + 1;
+				}
+				else if (c == '"') {
+					while (in != end && *in != '"') {
+						// inside double quotes a backslash only escapes a quote or another backslash
+						if (*in == '\\' && in + 1 != end && (in[1] == '"' || in[1] == '\\')) {
+							++in;
+						}
+						*out++ = *in++;
+					}
+					if (in == end) {
+						return false;
+					}
+					++in;
+				}
+				else if (c == '\\') {
+					if (in == end) {
+						return false;
+					}
+					*out++ = *in++;
+				}
+				else {
+					// out only falls behind once something was removed, before that the byte is already in place
+					if (out != in - 1) {
+						*out = c;
+					}
+					++out;
+				}
+			}
+
+			tokens.emplace_back(token_begin, out - token_begin);
+		}
+	}
+
+	constexpr std::uint64_t MixHash(std::uint64_t hash) noexcept {
+		hash ^= hash >> 33;
+		hash *= 0xFF51AFD7ED558CCDull;
+		hash ^= hash >> 33;
+		hash *= 0xC4CEB9FE1A85EC53ull;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+	constexpr std::uint64_t PerfectHash::SlotHash(std::uint64_t hash, std::uint32_t displacement) noexcept {
+		return displacement == 0 ? hash : MixHash(hash + displacement * 0x9E3779B97F4A7C15ull);
+	}
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <mutex>
+#include <utility>
+
+#include "SuggestionIndex.h"
+#include "CommandNode.h"
+
+namespace comad::command {
+	namespace {
+		std::uint64_t HashText(std::string_view text) noexcept {
+			std::uint64_t hash = 14695981039346656037ull;
+			for (const char c : text) {
+				hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+			}
+			return hash;
+		}
+
+		void CollectDeletes(std::string& text, std::size_t first, std::size_t remaining, std::vector<std::uint64_t>& hashes) {
+			hashes.push_back(HashText(text));
+			if (remaining == 0) {
+				return;
+			}
+
+			// only positions from first on, so every set of deleted positions is visited once
+			for (std::size_t i = first; i < text.size(); ++i) {
+				const char deleted = text[i];
+				text.erase(i, 1);
+				CollectDeletes(text, i, remaining - 1, hashes);
+				text.insert(i, 1, deleted);
+			}
+		}
+
+		// the hashes of word and of every string left after deleting up to max_distance characters from it,
+		// sorted and without duplicates
+		std::vector<std::uint64_t> CollectDeletes(std::string_view word, std::size_t max_distance) {
+			std::string text{ word };
+			std::vector<std::uint64_t> hashes{};
+			CollectDeletes(text, 0, max_distance, hashes);
+
+			std::ranges::sort(hashes);
+			hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+			return hashes;
+		}
+
+		std::size_t EditDistance(std::string_view a, std::string_view b, std::size_t limit,
+								 std::vector<std::size_t>& rows)
+		{
+			if (a.size() > b.size()) {
+				std::swap(a, b);
+			}
+			if (b.size() - a.size() > limit) {
+				return limit + 1;
+			}
+
+			// the row two back is kept for swaps of neighbouring characters
+			const std::size_t width = a.size() + 1;
+			rows.assign(width * 3, 0);
+			std::size_t* before = rows.data();
+			std::size_t* previous = before + width;
+			std::size_t* current = previous + width;
+			for (std::size_t i = 0; i < width; ++i) {
+				previous[i] = i;
+			}
+
+			for (std::size_t j = 1; j <= b.size(); ++j) {
+				current[0] = j;
+				std::size_t row_min = current[0];
+				for (std::size_t i = 1; i < width; ++i) {
+					const std::size_t cost = a[i - 1] == b[j - 1] ? 0 : 1;
+					current[i] = std::min({ previous[i] + 1, current[i - 1] + 1, previous[i - 1] + cost });
+					if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1]) {
+						current[i] = std::min(current[i], before[i - 2] + 1);
+					}
+					row_min = std::min(row_min, current[i]);
+				}
+				if (row_min > limit) {
+					return limit + 1;
+				}
+
+				std::swap(before, previous);
+				std::swap(previous, current);
+			}
+
+			return std::min(previous[a.size()], limit + 1);
+		}
+	}
+
+	SuggestionIndex::SuggestionIndex(std::vector<std::string> names, std::size_t max_distance) :
+		names_{ std::move(names) },
+		max_distance_{ max_distance }
+	{
+		std::ranges::sort(names_);
+		names_.erase(std::unique(names_.begin(), names_.end()), names_.end());
+
+		for (std::size_t i = 0; i < names_.size(); ++i) {
+			for (const std::uint64_t hash : CollectDeletes(names_[i], max_distance_)) {
+				entries_.push_back(Entry{ hash, static_cast<std::uint32_t>(i) });
+			}
+		}
+
+		std::ranges::sort(entries_, [](const Entry& lhs, const Entry& rhs) {
+			return lhs.hash != rhs.hash ? lhs.hash < rhs.hash : lhs.name < rhs.name;
+		});
+	}
+
+	std::vector<Suggestion> SuggestionIndex::Find(std::string_view word, std::size_t count) const {
+		std::vector<Suggestion> suggestions{};
+		if (names_.empty() || count == 0) {
+			return suggestions;
+		}
+
+		std::vector<std::uint32_t> candidates{};
+		for (const std::uint64_t hash : CollectDeletes(word, max_distance_)) {
+			auto it = std::ranges::lower_bound(entries_, hash, {}, &Entry::hash);
+			for (; it != entries_.end() && it->hash == hash; ++it) {
+				candidates.push_back(it->name);
+			}
+		}
+		std::ranges::sort(candidates);
+		candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+		// candidates are in name order, so a stable sort by distance keeps equally near names sorted
+		std::vector<std::size_t> rows{};
+		for (const std::uint32_t candidate : candidates) {
+			const std::size_t distance = EditDistance(word, names_[candidate], max_distance_, rows);
+			if (distance <= max_distance_) {
+				suggestions.push_back(Suggestion{ names_[candidate], distance });
+			}
+		}
+		std::ranges::stable_sort(suggestions, {}, &Suggestion::distance);
+		if (suggestions.size() > count) {
+			suggestions.erase(suggestions.begin() + static_cast<std::ptrdiff_t>(count), suggestions.end());
+		}
+
+		return suggestions;
+	}
+
+	std::size_t SuggestionIndex::GetSize() const noexcept {
+		return names_.size();
+	}
+
+	std::size_t SuggestionIndex::GetMaxDistance() const noexcept {
+		return max_distance_;
+	}
+
+	std::size_t SuggestionIndex::GetEditDistance(std::string_view a, std::string_view b, std::size_t limit) {
+		std::vector<std::size_t> rows{};
+		return EditDistance(a, b, limit, rows);
+	}
+
+	SuggestionIndex BuildCommandIndex(const CommandNode& node) {
+		std::vector<std::string> names{};
+		names.reserve(node.GetChildren().size() + node.GetChildAliasMapping().size());
+		for (const auto& [name, child] : node.GetChildren()) {
+			names.push_back(name);
+		}
+		for (const auto& [alias, name] : node.GetChildAliasMapping()) {
+			names.push_back(alias);
+		}
+		return SuggestionIndex{ std::move(names) };
+	}
+
+	SuggestionIndex BuildOptionIndex(const CommandNode& node) {
+		std::vector<std::string> names{};
+		names.reserve(node.GetTemplate().options.size());
+		for (const auto& [name, option] : node.GetTemplate().options) {
+			names.push_back(name);
+		}
+		return SuggestionIndex{ std::move(names) };
+	}
+
+	const SuggestionIndex& SuggestionCache::GetCommandIndex(const CommandNode& node) {
+		return GetIndex(commands_, node, &BuildCommandIndex);
+	}
+
+	const SuggestionIndex& SuggestionCache::GetOptionIndex(const CommandNode& node) {
+		return GetIndex(options_, node, &BuildOptionIndex);
+	}
+
+	void SuggestionCache::Invalidate() {
+		const std::unique_lock lock{ mutex_ };
+		commands_.clear();
+		options_.clear();
+	}
+
+	const SuggestionIndex& SuggestionCache::GetIndex(IndexMap& indexes, const CommandNode& node,
+													 SuggestionIndex (*build)(const CommandNode&))
+	{
+		{
+			const std::shared_lock lock{ mutex_ };
+			if (const auto it = indexes.find(&node); it != indexes.end()) {
+				return *it->second;
+			}
+		}
+
+		// built outside the lock, a thread that loses the race drops its copy
+		auto index = std::make_unique<const SuggestionIndex>(build(node));
+		const std::unique_lock lock{ mutex_ };
+		return *indexes.try_emplace(&node, std::move(index)).first->second;
+	}
+}
@@ -0,0 +1,78 @@
+#ifndef COMAD_SUGGESTION_INDEX_H_
+#define COMAD_SUGGESTION_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace comad::command {
+	class CommandNode;
+
+	struct Suggestion {
+		std::string name;
+		std::size_t distance;
+	};
+
+	// symmetric delete index in the style of SymSpell: every name is filed under the hashes of the strings
+	// left after deleting up to max_distance characters from it, so a query only has to generate the deletes
+	// of the word itself. names that share one are verified with the optimal string alignment distance
+	class SuggestionIndex {
+	public:
+		static constexpr std::size_t kDefaultMaxDistance = 2;
+
+		SuggestionIndex() = default;
+		explicit SuggestionIndex(std::vector<std::string> names, std::size_t max_distance = kDefaultMaxDistance);
+
+		// at most count names within the max distance of word, nearest first and equally near ones by name
+		[[nodiscard]] std::vector<Suggestion> Find(std::string_view word, std::size_t count = 3) const;
+
+		[[nodiscard]] std::size_t GetSize() const noexcept;
+		[[nodiscard]] std::size_t GetMaxDistance() const noexcept;
+
+		// edits, deletions and insertions of a character and swaps of neighbouring ones count one each.
+		// anything above limit is returned as limit + 1
+		static std::size_t GetEditDistance(std::string_view a, std::string_view b, std::size_t limit);
+
+	private:
+		struct Entry {
+			std::uint64_t hash;
+			std::uint32_t name;
+		};
+
+		std::vector<std::string> names_{};
+		// sorted by hash
+		std::vector<Entry> entries_{};
+		std::size_t max_distance_{ kDefaultMaxDistance };
+	};
+
+	// the children and aliases of a node as one index
+	SuggestionIndex BuildCommandIndex(const CommandNode& node);
+	// the long names of a node's options
+	SuggestionIndex BuildOptionIndex(const CommandNode& node);
+
+	// indexes of the nodes of a tree that does not change, built the first time a node is asked about
+	class SuggestionCache {
+	public:
+		const SuggestionIndex& GetCommandIndex(const CommandNode& node);
+		const SuggestionIndex& GetOptionIndex(const CommandNode& node);
+
+		void Invalidate();
+
+	private:
+		using IndexMap = std::unordered_map<const CommandNode*, std::unique_ptr<const SuggestionIndex>>;
+
+		std::shared_mutex mutex_{ };
+		IndexMap commands_{ };
+		IndexMap options_{ };
+
+		const SuggestionIndex& GetIndex(IndexMap& indexes, const CommandNode& node,
+										SuggestionIndex (*build)(const CommandNode&));
+	};
+}
+
+#endif
@@ -0,0 +1,151 @@
+#include <algorithm>
+
+#include "ComadBuildOptions.h"
+#include "ThreadPool.h"
+
+namespace comad::command {
+	namespace {
+		struct WorkerIdentity {
+			const ThreadPool* pool{ nullptr };
+			std::size_t index{ 0 };
+		};
+
+		thread_local WorkerIdentity current_worker{};
+	}
+
+	ThreadPool::ScheduleAwaiter::ScheduleAwaiter(ThreadPool& pool) noexcept :
+		pool_{ &pool }
+	{}
+
+	bool ThreadPool::ScheduleAwaiter::await_ready() const noexcept {
+		return false;
+	}
+
+	void ThreadPool::ScheduleAwaiter::await_suspend(std::coroutine_handle<> awaiting) const {
+		pool_->Post(awaiting);
+	}
+
+	void ThreadPool::ScheduleAwaiter::await_resume() const noexcept {}
+
+	ThreadPool::ThreadPool(std::size_t thread_count) {
+		if (thread_count == 0) {
+			thread_count = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		queues_.reserve(thread_count);
+		for (std::size_t i = 0; i < thread_count; ++i) {
+			queues_.push_back(std::make_unique<WorkQueue>());
+		}
+
+		threads_.reserve(thread_count);
+		for (std::size_t i = 0; i < thread_count; ++i) {
+			threads_.emplace_back([this, i] { Run(i); });
+		}
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard lock{ sleep_mutex_ };
+			stopping_ = true;
+		}
+		wake_condition_.notify_all();
+
+		for (std::thread& thread : threads_) {
+			thread.join();
+		}
+
+		// a handle can finish and let the pool be destroyed before the call that queued it returns
+		while (posting_.load(std::memory_order_acquire) != 0) {
+			std::this_thread::yield();
+		}
+	}
+
+	void ThreadPool::Post(std::coroutine_handle<> handle) {
+		const std::size_t index = current_worker.pool == this ?
+			current_worker.index : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+
+		// the count is raised before the handle is queued and the idle workers are read after it, while
+		// a worker raises idle_ before it reads the count. with both sequentially consistent one of the
+		// two sees the other, so a worker never sleeps through this handle
+		posting_.fetch_add(1, std::memory_order_relaxed);
+		pending_.fetch_add(1);
+		try {
+			WorkQueue& queue = *queues_[index];
+			std::lock_guard lock{ queue.mutex };
+			queue.handles.push_back(handle);
+		}
+		catch (...) {
+			pending_.fetch_sub(1);
+			posting_.fetch_sub(1, std::memory_order_release);
+			throw;
+		}
+
+		if (idle_.load() != 0) {
+			// taking the mutex waits for a worker that is about to wait to actually do so
+			std::lock_guard sleep_lock{ sleep_mutex_ };
+			wake_condition_.notify_one();
+		}
+		posting_.fetch_sub(1, std::memory_order_release);
+	}
+
+	ThreadPool::ScheduleAwaiter ThreadPool::Schedule() noexcept {
+		return ScheduleAwaiter{ *this };
+	}
+
+	std::size_t ThreadPool::GetThreadCount() const noexcept {
+		return threads_.size();
+	}
+
+	ThreadPool& ThreadPool::GetDefault() {
+		static ThreadPool pool{ build_options::kThreadPoolSize };
+		return pool;
+	}
+
+	void ThreadPool::Run(std::size_t index) {
+		current_worker = WorkerIdentity{ this, index };
+
+		while (true) {
+			std::coroutine_handle<> handle{};
+			if (TryPop(index, handle)) {
+				pending_.fetch_sub(1, std::memory_order_relaxed);
+				handle.resume();
+				continue;
+			}
+
+			std::unique_lock lock{ sleep_mutex_ };
+			idle_.fetch_add(1);
+			wake_condition_.wait(lock, [this] {
+				return stopping_ || pending_.load() != 0;
+			});
+			idle_.fetch_sub(1, std::memory_order_relaxed);
+
+			if (stopping_ && pending_.load() == 0) {
+				return;
+			}
+		}
+	}
+
+	bool ThreadPool::TryPop(std::size_t index, std::coroutine_handle<>& handle) {
+		{
+			WorkQueue& own = *queues_[index];
+			std::lock_guard lock{ own.mutex };
+			if (!own.handles.empty()) {
+				handle = own.handles.back();
+				own.handles.pop_back();
+				return true;
+			}
+		}
+
+		for (std::size_t offset = 1; offset < queues_.size(); ++offset) {
+			WorkQueue& other = *queues_[(index + offset) % queues_.size()];
+			std::lock_guard lock{ other.mutex };
+			if (!other.handles.empty()) {
+				handle = other.handles.front();
+				other.handles.pop_front();
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
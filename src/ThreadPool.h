@@ -0,0 +1,72 @@
+#ifndef COMAD_THREAD_POOL_H_
+#define COMAD_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace comad::command {
+	// runs coroutines on a fixed set of workers. every worker has its own queue, work posted from a
+	// worker goes to the back of its queue and idle workers steal from the front of the others
+	class ThreadPool {
+	public:
+		// awaiting it continues the coroutine on one of the pool's workers
+		class ScheduleAwaiter {
+		public:
+			explicit ScheduleAwaiter(ThreadPool& pool) noexcept;
+
+			bool await_ready() const noexcept;
+			void await_suspend(std::coroutine_handle<> awaiting) const;
+			void await_resume() const noexcept;
+
+		private:
+			ThreadPool* pool_;
+		};
+
+		// 0 uses one worker per hardware thread
+		explicit ThreadPool(std::size_t thread_count = 0);
+		// finishes the queued work before joining, coroutines that are suspended elsewhere are not waited for
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		void Post(std::coroutine_handle<> handle);
+		[[nodiscard]] ScheduleAwaiter Schedule() noexcept;
+
+		[[nodiscard]] std::size_t GetThreadCount() const noexcept;
+
+		// created on first use with COMAD_THREAD_POOL_SIZE workers
+		static ThreadPool& GetDefault();
+
+	private:
+		struct WorkQueue {
+			std::mutex mutex{ };
+			std::deque<std::coroutine_handle<>> handles{ };
+		};
+
+		std::vector<std::unique_ptr<WorkQueue>> queues_{ };
+		std::vector<std::thread> threads_{ };
+		std::atomic<std::size_t> next_queue_{ 0 };
+		std::atomic<std::size_t> pending_{ 0 };
+		// workers that hold or wait on the sleep mutex, posting only takes it while there are any
+		std::atomic<std::size_t> idle_{ 0 };
+		// calls to Post that may still touch the pool after queueing their handle
+		std::atomic<std::size_t> posting_{ 0 };
+
+		std::mutex sleep_mutex_{ };
+		std::condition_variable wake_condition_{ };
+		bool stopping_{ false };
+
+		void Run(std::size_t index);
+		bool TryPop(std::size_t index, std::coroutine_handle<>& handle);
+	};
+}
+
+#endif
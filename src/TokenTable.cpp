@@ -0,0 +1,134 @@
+#include "TokenTable.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include "ComadBuildOptions.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define COMAD_TOKEN_SIMD_WIDTH 32
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COMAD_TOKEN_SIMD_WIDTH 16
+#else
+#define COMAD_TOKEN_SIMD_WIDTH 0
+#endif
+
+namespace comad::command {
+	namespace {
+		using namespace build_options;
+
+		std::uint8_t ClassifyScalar(std::string_view text) noexcept {
+			std::uint8_t traits = kPositional;
+			if (text.starts_with(FlagPrefix)) {
+				traits |= kFlagPrefixed;
+			}
+			if (text.starts_with(OptionPrefix)) {
+				traits |= kLongOption;
+			}
+			else if (text.size() > ShortOptionPrefix.size() && text.starts_with(ShortOptionPrefix)) {
+				traits |= kShortOption;
+			}
+			return traits;
+		}
+
+#if COMAD_TOKEN_SIMD_WIDTH > 0
+		constexpr std::size_t kBlockSize = COMAD_TOKEN_SIMD_WIDTH;
+
+		// the vector path compares the first two bytes of every token, so longer prefixes take the scalar one
+		constexpr bool kVectorizable = [] {
+			for (std::string_view prefix : { FlagPrefix, OptionPrefix, ShortOptionPrefix }) {
+				if (prefix.empty() || prefix.size() > 2) {
+					return false;
+				}
+			}
+			return true;
+		}();
+
+#if COMAD_TOKEN_SIMD_WIDTH == 32
+		using Vector = __m256i;
+
+		Vector Load(const std::uint8_t* bytes) noexcept { return _mm256_load_si256(reinterpret_cast<const Vector*>(bytes)); }
+		void Store(std::uint8_t* bytes, Vector v) noexcept { _mm256_store_si256(reinterpret_cast<Vector*>(bytes), v); }
+		Vector Broadcast(char c) noexcept { return _mm256_set1_epi8(c); }
+		Vector Equal(Vector a, Vector b) noexcept { return _mm256_cmpeq_epi8(a, b); }
+		Vector And(Vector a, Vector b) noexcept { return _mm256_and_si256(a, b); }
+		Vector AndNot(Vector a, Vector b) noexcept { return _mm256_andnot_si256(a, b); }
+		Vector Or(Vector a, Vector b) noexcept { return _mm256_or_si256(a, b); }
+#else
+		using Vector = __m128i;
+
+		Vector Load(const std::uint8_t* bytes) noexcept { return _mm_load_si128(reinterpret_cast<const Vector*>(bytes)); }
+		void Store(std::uint8_t* bytes, Vector v) noexcept { _mm_store_si128(reinterpret_cast<Vector*>(bytes), v); }
+		Vector Broadcast(char c) noexcept { return _mm_set1_epi8(c); }
+		Vector Equal(Vector a, Vector b) noexcept { return _mm_cmpeq_epi8(a, b); }
+		Vector And(Vector a, Vector b) noexcept { return _mm_and_si128(a, b); }
+		Vector AndNot(Vector a, Vector b) noexcept { return _mm_andnot_si128(a, b); }
+		Vector Or(Vector a, Vector b) noexcept { return _mm_or_si128(a, b); }
+#endif
+
+		Vector MatchPrefix(std::string_view prefix, Vector first, Vector second) noexcept {
+			Vector match = Equal(first, Broadcast(prefix[0]));
+			if (prefix.size() == 2) {
+				match = And(match, Equal(second, Broadcast(prefix[1])));
+			}
+			return match;
+		}
+
+		// the leading bytes of kBlockSize tokens are gathered into lanes and all prefixes are tested at once
+		void ClassifyBlock(Token* tokens) noexcept {
+			alignas(kBlockSize) std::array<std::uint8_t, kBlockSize> first{};
+			alignas(kBlockSize) std::array<std::uint8_t, kBlockSize> second{};
+			alignas(kBlockSize) std::array<std::uint8_t, kBlockSize> has_short_name{};
+			alignas(kBlockSize) std::array<std::uint8_t, kBlockSize> traits{};
+
+			for (std::size_t i = 0; i < kBlockSize; ++i) {
+				const Token& token = tokens[i];
+				first[i] = token.length > 0 ? static_cast<std::uint8_t>(token.data[0]) : 0;
+				second[i] = token.length > 1 ? static_cast<std::uint8_t>(token.data[1]) : 0;
+				has_short_name[i] = token.length > ShortOptionPrefix.size() ? 0xFF : 0;
+			}
+
+			const Vector first_bytes = Load(first.data());
+			const Vector second_bytes = Load(second.data());
+
+			const Vector flag = MatchPrefix(FlagPrefix, first_bytes, second_bytes);
+			const Vector long_option = MatchPrefix(OptionPrefix, first_bytes, second_bytes);
+			const Vector short_option = AndNot(long_option,
+				And(MatchPrefix(ShortOptionPrefix, first_bytes, second_bytes), Load(has_short_name.data())));
+
+			Store(traits.data(), Or(Or(And(flag, Broadcast(kFlagPrefixed)), And(long_option, Broadcast(kLongOption))),
+				And(short_option, Broadcast(kShortOption))));
+
+			for (std::size_t i = 0; i < kBlockSize; ++i) {
+				tokens[i].traits = traits[i];
+			}
+		}
+#endif
+	}
+
+	void ClassifyTokens(std::span<Token> tokens) noexcept {
+		std::size_t i = 0;
+
+#if COMAD_TOKEN_SIMD_WIDTH > 0
+		if constexpr (kVectorizable) {
+			for (; i + kBlockSize <= tokens.size(); i += kBlockSize) {
+				ClassifyBlock(tokens.data() + i);
+			}
+		}
+#endif
+
+		for (; i < tokens.size(); ++i) {
+			tokens[i].traits = ClassifyScalar(tokens[i].GetText());
+		}
+	}
+
+	TokenTable& detail::GetThreadTokenTable() noexcept {
+		thread_local TokenTable table{};
+		return table;
+	}
+}
@@ -0,0 +1,56 @@
+#ifndef COMAD_TOKEN_TABLE_H_
+#define COMAD_TOKEN_TABLE_H_
+
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace comad::command {
+	enum TokenTraits : std::uint8_t {
+		kPositional = 0,
+		kFlagPrefixed = 1 << 0,
+		kLongOption = 1 << 1,
+		kShortOption = 1 << 2
+	};
+
+	// one argv element with its prefixes resolved up front. a token can carry both the flag and
+	// the short option trait when the prefixes overlap, the dispatcher decides which one applies
+	struct Token {
+		const char* data{ nullptr };
+		std::uint32_t length{ 0 };
+		std::uint8_t traits{ kPositional };
+
+		[[nodiscard]] std::string_view GetText() const noexcept;
+		[[nodiscard]] std::string_view GetFlagName() const noexcept;
+		[[nodiscard]] std::string_view GetOptionName() const noexcept;
+
+		[[nodiscard]] bool IsFlagPrefixed() const noexcept;
+		[[nodiscard]] bool IsOption() const noexcept;
+		[[nodiscard]] bool IsLongOption() const noexcept;
+		[[nodiscard]] bool IsShortOption() const noexcept;
+
+		static Token Classify(std::string_view text) noexcept;
+	};
+
+	// tags every token in one sweep, vectorized where the target supports it
+	void ClassifyTokens(std::span<Token> tokens) noexcept;
+
+	class TokenTable {
+	public:
+		template <std::input_iterator iter, std::sentinel_for<iter> sentinel>
+		std::span<const Token> Assign(iter first, sentinel last);
+
+	private:
+		std::vector<Token> tokens_{};
+	};
+
+	namespace detail {
+		// dispatch finishes with the table before an executor runs, so nested dispatch can share it
+		TokenTable& GetThreadTokenTable() noexcept;
+	}
+}
+
+#include "TokenTable.tcc"
+#endif
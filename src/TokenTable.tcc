@@ -0,0 +1,64 @@
+#ifndef COMAD_TOKEN_TABLE_TCC_
+#define COMAD_TOKEN_TABLE_TCC_
+
+#include <string_view>
+
+#include <ComadBuildOptions.h>
+
+#include "TokenTable.h"
+
+namespace comad::command {
+	inline std::string_view Token::GetText() const noexcept {
+		return std::string_view{ data, length };
+	}
+
+	inline std::string_view Token::GetFlagName() const noexcept {
+		return GetText().substr(build_options::FlagPrefix.size());
+	}
+
+	inline std::string_view Token::GetOptionName() const noexcept {
+		if (IsLongOption()) {
+			return GetText().substr(build_options::OptionPrefix.size());
+		}
+		if (IsShortOption()) {
+			return GetText().substr(build_options::ShortOptionPrefix.size());
+		}
+		return GetText();
+	}
+
+	inline bool Token::IsFlagPrefixed() const noexcept {
+		return (traits & kFlagPrefixed) != 0;
+	}
+
+	inline bool Token::IsOption() const noexcept {
+		return (traits & (kLongOption | kShortOption)) != 0;
+	}
+
+	inline bool Token::IsLongOption() const noexcept {
+		return (traits & kLongOption) != 0;
+	}
+
+	inline bool Token::IsShortOption() const noexcept {
+		return (traits & kShortOption) != 0;
+	}
+
+	inline Token Token::Classify(std::string_view text) noexcept {
+		Token token{ text.data(), static_cast<std::uint32_t>(text.size()) };
+		ClassifyTokens(std::span<Token>{ &token, 1 });
+		return token;
+	}
+
+	template <std::input_iterator iter, std::sentinel_for<iter> sentinel>
+	std::span<const Token> TokenTable::Assign(iter first, sentinel last) {
+		tokens_.clear();
+		for (; first != last; ++first) {
+			const std::string_view text{ *first };
+			tokens_.push_back(Token{ text.data(), static_cast<std::uint32_t>(text.size()) });
+		}
+
+		ClassifyTokens(tokens_);
+		return tokens_;
+	}
+}
+
+#endif
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+#include "TreeSnapshot.h"
+
+namespace comad::command::detail {
+	TreeSnapshot::TreeSnapshot(const CommandNode& borrowed_root) :
+		root{ &borrowed_root },
+		compiled{ borrowed_root }
+	{}
+
+	TreeSnapshot::TreeSnapshot(CommandNode&& owned) :
+		owned_root{ std::move(owned) },
+		root{ &*owned_root },
+		compiled{ *owned_root }
+	{}
+
+	void TreeSnapshot::RebindRoot(const CommandNode& borrowed_root) noexcept {
+		root = &borrowed_root;
+		compiled.RebindRoot(borrowed_root);
+		suggestions.Invalidate();
+		completions.Invalidate();
+	}
+
+	SnapshotDomain::~SnapshotDomain() {
+		delete current_.load(std::memory_order_relaxed);
+	}
+
+	std::size_t SnapshotDomain::GetThreadShard() noexcept {
+		static std::atomic<std::size_t> next{ 0 };
+		thread_local const std::size_t shard = next.fetch_add(1, std::memory_order_relaxed) % kShardCount;
+		return shard;
+	}
+
+	std::size_t SnapshotDomain::Publish(std::unique_ptr<TreeSnapshot> snapshot) {
+		const std::lock_guard lock{ writer_mutex_ };
+
+		// reserved up front, so the replaced snapshot cannot be lost to a failed allocation. nothing is
+		// allocated if nothing is replaced
+		if (current_.load(std::memory_order_relaxed) != nullptr) {
+			retired_.reserve(retired_.size() + 1);
+		}
+		TreeSnapshot* const previous = current_.exchange(snapshot.release());
+		if (previous != nullptr) {
+			retired_.push_back(Retired{ std::unique_ptr<TreeSnapshot>{ previous }, epoch_.load(std::memory_order_relaxed) });
+		}
+
+		return Reclaim();
+	}
+
+	std::unique_ptr<TreeSnapshot> SnapshotDomain::Take() noexcept {
+		const std::lock_guard lock{ writer_mutex_ };
+
+		retired_.clear();
+		return std::unique_ptr<TreeSnapshot>{ current_.exchange(nullptr) };
+	}
+
+	std::size_t SnapshotDomain::GetRetiredCount() const {
+		const std::lock_guard lock{ writer_mutex_ };
+		return retired_.size();
+	}
+
+	bool SnapshotDomain::HasReaders(std::uint64_t epoch) const noexcept {
+		return std::ranges::any_of(readers_[epoch & 1], [](const ReaderCount& readers) {
+			return readers.count.load() != 0;
+		});
+	}
+
+	std::size_t SnapshotDomain::Reclaim() {
+		// readers of the epoch before the current one may still hold anything retired since, the epoch moves
+		// on once they are gone. twice at most, after that the same readers would be checked again
+		for (int i = 0; i < 2; ++i) {
+			const std::uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+			if (HasReaders(epoch - 1)) {
+				break;
+			}
+			epoch_.store(epoch + 1);
+		}
+
+		const std::uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+		const std::size_t retired_count = retired_.size();
+		std::erase_if(retired_, [epoch](const Retired& retired) { return retired.epoch + 2 <= epoch; });
+		return retired_count - retired_.size();
+	}
+}
@@ -0,0 +1,116 @@
+#ifndef COMAD_TREE_SNAPSHOT_H_
+#define COMAD_TREE_SNAPSHOT_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "CommandNode.h"
+#include "CompiledCommandTree.h"
+#include "CompletionIndex.h"
+#include "SuggestionIndex.h"
+
+namespace comad::command::detail {
+	// a tree as dispatch sees it, never modified while it is published. the root is either owned by the
+	// snapshot or the handler's own tree, which then must not change until the snapshot is dropped.
+	// the indexes built for suggestions and completions go away with the nodes they refer to
+	struct TreeSnapshot {
+		explicit TreeSnapshot(const CommandNode& borrowed_root);
+		explicit TreeSnapshot(CommandNode&& owned);
+
+		TreeSnapshot(const TreeSnapshot&) = delete;
+		TreeSnapshot& operator=(const TreeSnapshot&) = delete;
+
+		// for a borrowed root that has been moved, the caches are dropped with the old address
+		void RebindRoot(const CommandNode& borrowed_root) noexcept;
+
+		std::optional<CommandNode> owned_root{};
+		const CommandNode* root;
+		CompiledCommandTree compiled;
+		mutable SuggestionCache suggestions{};
+		mutable CompletionCache completions{};
+	};
+
+	class SnapshotDomain;
+
+	// keeps the snapshot that was published when it was created alive, it may be released on any thread
+	class SnapshotGuard {
+	public:
+		SnapshotGuard(SnapshotGuard&& other) noexcept;
+		SnapshotGuard& operator=(SnapshotGuard&&) = delete;
+		~SnapshotGuard();
+
+		// null if nothing was published
+		[[nodiscard]] const TreeSnapshot* Get() const noexcept;
+
+	private:
+		std::atomic<std::int64_t>* readers_;
+		const TreeSnapshot* snapshot_;
+
+		SnapshotGuard(std::atomic<std::int64_t>* readers, const TreeSnapshot* snapshot) noexcept;
+
+		friend class SnapshotDomain;
+	};
+
+	// publishes snapshots to dispatching threads without locks, in the style of sleepable RCU. readers count
+	// themselves into one of two sets of counters, picked by the parity of the epoch they saw, and load the
+	// snapshot afterwards. a replaced snapshot is retired with the epoch it was replaced in and freed once the
+	// epoch has advanced twice past it, since readers only ever belong to the current or the previous epoch.
+	// the epoch only advances while no reader of the previous one is left, so writers never wait for readers
+	class SnapshotDomain {
+	public:
+		static constexpr std::size_t kShardCount = 16;
+
+		SnapshotDomain() = default;
+		~SnapshotDomain();
+
+		SnapshotDomain(const SnapshotDomain&) = delete;
+		SnapshotDomain& operator=(const SnapshotDomain&) = delete;
+
+		[[nodiscard]] SnapshotGuard Pin() const noexcept;
+
+		// replaces the published snapshot, snapshot may be null. safe while other threads pin. returns how
+		// many retired snapshots could be freed
+		std::size_t Publish(std::unique_ptr<TreeSnapshot> snapshot);
+
+		// unpublishes the snapshot and frees every retired one. no thread may pin or read a pinned snapshot at
+		// the same time, guards that are only held, like those of asynchronous commands, may be released later
+		std::unique_ptr<TreeSnapshot> Take() noexcept;
+
+		// the published snapshot without pinning it, only valid until the next Publish
+		[[nodiscard]] const TreeSnapshot* GetUnpinned() const noexcept;
+
+		[[nodiscard]] std::size_t GetRetiredCount() const;
+
+	private:
+		struct alignas(64) ReaderCount {
+			std::atomic<std::int64_t> count{ 0 };
+		};
+
+		struct Retired {
+			std::unique_ptr<TreeSnapshot> snapshot;
+			std::uint64_t epoch;
+		};
+
+		std::atomic<TreeSnapshot*> current_{ nullptr };
+		std::atomic<std::uint64_t> epoch_{ 0 };
+		mutable std::array<std::array<ReaderCount, kShardCount>, 2> readers_{};
+
+		// writers are serialized among each other, readers never take it
+		mutable std::mutex writer_mutex_{};
+		std::vector<Retired> retired_{};
+
+		bool HasReaders(std::uint64_t epoch) const noexcept;
+		std::size_t Reclaim();
+
+		static std::size_t GetThreadShard() noexcept;
+	};
+}
+
+#include "TreeSnapshot.tcc"
+#endif
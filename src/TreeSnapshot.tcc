@@ -0,0 +1,54 @@
+#ifndef COMAD_TREE_SNAPSHOT_TCC_
+#define COMAD_TREE_SNAPSHOT_TCC_
+
+#include <utility>
+
+#include "TreeSnapshot.h"
+
+namespace comad::command::detail {
+	inline SnapshotGuard::SnapshotGuard(std::atomic<std::int64_t>* readers, const TreeSnapshot* snapshot) noexcept :
+		readers_{ readers },
+		snapshot_{ snapshot }
+	{}
+
+	inline SnapshotGuard::SnapshotGuard(SnapshotGuard&& other) noexcept :
+		readers_{ std::exchange(other.readers_, nullptr) },
+		snapshot_{ std::exchange(other.snapshot_, nullptr) }
+	{}
+
+	inline SnapshotGuard::~SnapshotGuard() {
+		if (readers_ != nullptr) {
+			// release, so whatever the reader did with the snapshot happens before it is freed
+			readers_->fetch_sub(1, std::memory_order_release);
+		}
+	}
+
+	inline const TreeSnapshot* SnapshotGuard::Get() const noexcept {
+		return snapshot_;
+	}
+
+	inline SnapshotGuard SnapshotDomain::Pin() const noexcept {
+		// the epoch is checked again after counting in, a reader that counted into a set a writer has already
+		// found empty sees the new epoch and moves over. all of it is sequentially consistent, the protocol
+		// relies on a single order of the counters, the epoch and the snapshot pointer
+		const std::size_t shard = GetThreadShard();
+		std::atomic<std::int64_t>* readers;
+		while (true) {
+			const std::uint64_t epoch = epoch_.load();
+			readers = &readers_[epoch & 1][shard].count;
+			readers->fetch_add(1);
+			if (epoch_.load() == epoch) {
+				break;
+			}
+			readers->fetch_sub(1, std::memory_order_release);
+		}
+
+		return SnapshotGuard{ readers, current_.load() };
+	}
+
+	inline const TreeSnapshot* SnapshotDomain::GetUnpinned() const noexcept {
+		return current_.load(std::memory_order_acquire);
+	}
+}
+
+#endif
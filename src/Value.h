@@ -1,12 +1,16 @@
 #ifndef COMAD_VALUE_TRAITS_H_
 #define COMAD_VALUE_TRAITS_H_
 
+#include <chrono>
+#include <compare>
 #include <map>
 #include <variant>
 #include <concepts>
 #include <string>
 #include <string_view>
+#include <vector>
 #include <cstddef>
+#include <cstdint>
 
 namespace comad {
 	template<typename T>
@@ -20,10 +24,39 @@ namespace comad {
 			kBool,
 			kInt,
 			kFloat,
-			kString
+			kString,
+			// after the first four so command images keep their numbers
+			kInt64,
+			kUInt64,
+			kDouble,
+			kByteSize,
+			kDuration,
+			// lists are written with their elements separated by build_options::ListSeparator
+			kIntList,
+			kInt64List,
+			kUInt64List,
+			kDoubleList,
+			kStringList
 		};
 
-		using ValueVariant = std::variant<bool, int, float, std::string>;
+		// a number of bytes, written with a decimal (kB, MB, ...) or binary (KiB, MiB, ...) unit
+		struct ByteSize {
+			std::uint64_t bytes{ 0 };
+
+			friend constexpr auto operator<=>(const ByteSize&, const ByteSize&) = default;
+		};
+
+		// written as whole numbers with units, like 250ms or 1h30m
+		using Duration = std::chrono::nanoseconds;
+
+		// string list elements refer to the dispatched input like borrowed strings, until the list is copied
+		using ValueVariant = std::variant<bool, int, float, std::string, std::int64_t, std::uint64_t, double, ByteSize,
+			Duration, std::vector<int>, std::vector<std::int64_t>, std::vector<std::uint64_t>, std::vector<double>,
+			std::vector<std::string_view>>;
+
+		// the types a single value can have, options of a list type check each element against these
+		using ScalarVariant = std::variant<bool, int, float, std::string, std::int64_t, std::uint64_t, double, ByteSize,
+			Duration>;
 
 		template<typename T>
 		struct ValueTypeTraits;
@@ -59,6 +92,81 @@ namespace comad {
 			static constexpr std::string_view name = std::string_view{"string"};
 		};
 
+		template<>
+		struct ValueTypeTraits<std::int64_t> {
+			static constexpr ValueType type = ValueType::kInt64;
+			static constexpr std::size_t variant_index = ValueVariant{ std::int64_t{ 0 } }.index();
+			static constexpr std::string_view name = std::string_view{"int64"};
+		};
+
+		template<>
+		struct ValueTypeTraits<std::uint64_t> {
+			static constexpr ValueType type = ValueType::kUInt64;
+			static constexpr std::size_t variant_index = ValueVariant{ std::uint64_t{ 0 } }.index();
+			static constexpr std::string_view name = std::string_view{"uint64"};
+		};
+
+		template<>
+		struct ValueTypeTraits<double> {
+			static constexpr ValueType type = ValueType::kDouble;
+			static constexpr std::size_t variant_index = ValueVariant{ .0 }.index();
+			static constexpr std::string_view name = std::string_view{"double"};
+		};
+
+		template<>
+		struct ValueTypeTraits<ByteSize> {
+			static constexpr ValueType type = ValueType::kByteSize;
+			static constexpr std::size_t variant_index = ValueVariant{ ByteSize{} }.index();
+			static constexpr std::string_view name = std::string_view{"bytesize"};
+		};
+
+		template<>
+		struct ValueTypeTraits<Duration> {
+			static constexpr ValueType type = ValueType::kDuration;
+			static constexpr std::size_t variant_index = ValueVariant{ Duration{} }.index();
+			static constexpr std::string_view name = std::string_view{"duration"};
+		};
+
+		template<>
+		struct ValueTypeTraits<std::vector<int>> {
+			static constexpr ValueType type = ValueType::kIntList;
+			static constexpr std::size_t variant_index = ValueVariant{ std::vector<int>{} }.index();
+			static constexpr std::string_view name = std::string_view{"int list"};
+			using element_type = int;
+		};
+
+		template<>
+		struct ValueTypeTraits<std::vector<std::int64_t>> {
+			static constexpr ValueType type = ValueType::kInt64List;
+			static constexpr std::size_t variant_index = ValueVariant{ std::vector<std::int64_t>{} }.index();
+			static constexpr std::string_view name = std::string_view{"int64 list"};
+			using element_type = std::int64_t;
+		};
+
+		template<>
+		struct ValueTypeTraits<std::vector<std::uint64_t>> {
+			static constexpr ValueType type = ValueType::kUInt64List;
+			static constexpr std::size_t variant_index = ValueVariant{ std::vector<std::uint64_t>{} }.index();
+			static constexpr std::string_view name = std::string_view{"uint64 list"};
+			using element_type = std::uint64_t;
+		};
+
+		template<>
+		struct ValueTypeTraits<std::vector<double>> {
+			static constexpr ValueType type = ValueType::kDoubleList;
+			static constexpr std::size_t variant_index = ValueVariant{ std::vector<double>{} }.index();
+			static constexpr std::string_view name = std::string_view{"double list"};
+			using element_type = double;
+		};
+
+		template<>
+		struct ValueTypeTraits<std::vector<std::string_view>> {
+			static constexpr ValueType type = ValueType::kStringList;
+			static constexpr std::size_t variant_index = ValueVariant{ std::vector<std::string_view>{} }.index();
+			static constexpr std::string_view name = std::string_view{"string list"};
+			using element_type = std::string_view;
+		};
+
 		template<typename T>
 		concept ValidType = requires() {
 			{ ValueTypeTraits<T>::type } -> std::convertible_to<ValueType>;
@@ -66,9 +174,46 @@ namespace comad {
 			{ ValueTypeTraits<T>::name } -> std::convertible_to<std::string_view>;
 		};
 
+		template <typename T>
+		concept ListValueType = ValidType<T> && requires() {
+			typename ValueTypeTraits<T>::element_type;
+		};
+
+		// a type a single value can have, which bounds and supported value lists are made of
+		template <typename T>
+		concept ScalarValueType = ValidType<T> && !ListValueType<T>;
+
+		// the type of the elements of a list type, kUnknown for every other type
+		constexpr ValueType ElementType(ValueType type) noexcept {
+			switch (type) {
+				case ValueType::kIntList: return ValueType::kInt;
+				case ValueType::kInt64List: return ValueType::kInt64;
+				case ValueType::kUInt64List: return ValueType::kUInt64;
+				case ValueType::kDoubleList: return ValueType::kDouble;
+				case ValueType::kStringList: return ValueType::kString;
+				default: return ValueType::kUnknown;
+			}
+		}
+
+		// the list type of elements of type element, kUnknown if there is none
+		constexpr ValueType ListOf(ValueType element) noexcept {
+			switch (element) {
+				case ValueType::kInt: return ValueType::kIntList;
+				case ValueType::kInt64: return ValueType::kInt64List;
+				case ValueType::kUInt64: return ValueType::kUInt64List;
+				case ValueType::kDouble: return ValueType::kDoubleList;
+				case ValueType::kString: return ValueType::kStringList;
+				default: return ValueType::kUnknown;
+			}
+		}
+
+		constexpr bool IsListType(ValueType type) noexcept {
+			return ElementType(type) != ValueType::kUnknown;
+		}
+
 		template <typename T>
 		concept ValueRange = std::ranges::input_range<T> &&
-			ValidType<std::ranges::range_value_t<T>>;
+			ScalarValueType<std::ranges::range_value_t<T>>;
 
 		inline const std::map<ValueType, std::string_view> ValueTypeNames = []<typename... Ts>(std::variant<Ts...>) {
 			std::map<ValueType, std::string_view> ret;
@@ -1,5 +1,13 @@
 #include "ValueUtility.h"
 
+#include <algorithm>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
 namespace comad::value {
 	SupportedValueHolder::SupportedValueHolder(ValueType type) :
 		supported_values_{ type }
@@ -21,15 +29,187 @@ namespace comad::value {
 		}
 	}
 
+	const ValueBounds* SupportedValueHolder::GetBounds() const noexcept {
+		return std::get_if<ValueBounds>(&supported_values_);
+	}
+
+	bool SupportedValueHolder::IsList() const noexcept {
+		return std::holds_alternative<List>(supported_values_);
+	}
+
+	std::vector<ValueWrapper> SupportedValueHolder::GetListedValues() const {
+		if (const List* list = std::get_if<List>(&supported_values_)) {
+			return list->GetValues();
+		}
+		return {};
+	}
+
 	ValueType SupportedValueHolder::List::GetValueType() const noexcept {
 		return value_type_;
 	}
 
+	std::vector<ValueWrapper> SupportedValueHolder::List::GetValues() const {
+		return values_;
+	}
+
+	ValueWrapper::ValueWrapper(const ValueWrapper& other) :
+		type_{ other.type_ },
+		value_{ other.value_ },
+		borrowed_{ other.borrowed_ },
+		list_chars_{ other.list_chars_ },
+		is_borrowed_{ other.is_borrowed_ }
+	{
+		Materialize();
+	}
+
+	ValueWrapper& ValueWrapper::operator=(const ValueWrapper& other) {
+		if (this != &other) {
+			*this = ValueWrapper{ other };
+		}
+		return *this;
+	}
+
+	ValueWrapper ValueWrapper::Borrow(std::string_view str) noexcept {
+		ValueWrapper wrapper{};
+		wrapper.type_ = ValueType::kString;
+		wrapper.borrowed_ = str;
+		wrapper.is_borrowed_ = true;
+		return wrapper;
+	}
+
+	std::string_view ValueWrapper::GetStringView() const {
+		if (type_ != ValueType::kString) {
+			throw std::runtime_error("value wrapper does not hold the requested type");
+		}
+		if (is_borrowed_) {
+			return borrowed_;
+		}
+		return std::get<std::string>(value_);
+	}
+
 	ValueType ValueWrapper::GetType() const noexcept {
 		return type_;
 	}
 
+	bool ValueWrapper::IsBorrowed() const noexcept {
+		return is_borrowed_;
+	}
+
+	std::size_t ValueWrapper::GetListSize() const noexcept {
+		return std::visit([]<typename T>(const T& value) -> std::size_t {
+			if constexpr (ListValueType<T>) {
+				return value.size();
+			}
+			else {
+				return 0;
+			}
+		}, value_);
+	}
+
+	void ValueWrapper::Materialize() {
+		if (!is_borrowed_) {
+			return;
+		}
+
+		if (type_ == ValueType::kStringList) {
+			// the elements are copied back to back and the views are pointed at the copies
+			auto& elements = std::get<std::vector<std::string_view>>(value_);
+			std::size_t size = 0;
+			for (const std::string_view element : elements) {
+				size += element.size();
+			}
+
+			auto chars = std::make_shared<std::string>();
+			chars->reserve(size);
+			for (const std::string_view element : elements) {
+				chars->append(element);
+			}
+
+			std::size_t offset = 0;
+			for (std::string_view& element : elements) {
+				element = std::string_view{ chars->data() + offset, element.size() };
+				offset += element.size();
+			}
+			list_chars_ = std::move(chars);
+		}
+		else {
+			value_ = std::string{ borrowed_ };
+			borrowed_ = {};
+		}
+		is_borrowed_ = false;
+	}
+
+	bool ValueBounds::IsInBounds(std::string_view str) const {
+		if (type_ != ValueType::kString) {
+			throw std::invalid_argument("bounds are not for the passed type");
+		}
+
+		return std::get<Interval<std::string>>(interval_).Contains(str);
+	}
+
+	bool SupportedValueHolder::IsValid(std::string_view str) const noexcept {
+		if (const ValueType* type = std::get_if<ValueType>(&supported_values_)) {
+			return *type == ValueType::kString;
+		}
+		if (const ValueBounds* bounds = std::get_if<ValueBounds>(&supported_values_)) {
+			return bounds->GetValueType() == ValueType::kString && bounds->IsInBounds(str);
+		}
+		return std::get<List>(supported_values_).IsValid(str);
+	}
+
+	bool SupportedValueHolder::IsValid(const ValueWrapper& value) const noexcept {
+		switch (value.GetType())
+		{
+			case ValueType::kBool: return IsValid(value.GetValue<bool>());
+			case ValueType::kInt: return IsValid(value.GetValue<int>());
+			case ValueType::kFloat: return IsValid(value.GetValue<float>());
+			case ValueType::kString: return IsValid(value.GetStringView());
+			case ValueType::kInt64: return IsValid(value.GetValue<std::int64_t>());
+			case ValueType::kUInt64: return IsValid(value.GetValue<std::uint64_t>());
+			case ValueType::kDouble: return IsValid(value.GetValue<double>());
+			case ValueType::kByteSize: return IsValid(value.GetValue<ByteSize>());
+			case ValueType::kDuration: return IsValid(value.GetValue<Duration>());
+			case ValueType::kIntList:
+			case ValueType::kInt64List:
+			case ValueType::kUInt64List:
+			case ValueType::kDoubleList:
+			case ValueType::kStringList: return AreValid(value);
+			default: return false;
+		}
+	}
+
+	bool SupportedValueHolder::AreValid(const ValueWrapper& list, std::size_t first) const noexcept {
+		const auto elements = [first]<typename T>(const std::vector<T>& values) {
+			return std::span<const T>{ values }.subspan(std::min(first, values.size()));
+		};
+
+		switch (list.GetType())
+		{
+			case ValueType::kIntList: return AreValid(elements(list.GetValue<std::vector<int>>()));
+			case ValueType::kInt64List: return AreValid(elements(list.GetValue<std::vector<std::int64_t>>()));
+			case ValueType::kUInt64List: return AreValid(elements(list.GetValue<std::vector<std::uint64_t>>()));
+			case ValueType::kDoubleList: return AreValid(elements(list.GetValue<std::vector<double>>()));
+			case ValueType::kStringList: return AreValid(elements(list.GetValue<std::vector<std::string_view>>()));
+			default: return false;
+		}
+	}
+
+	bool SupportedValueHolder::List::IsValid(std::string_view str) const noexcept {
+		if (const StringSet* set = std::get_if<StringSet>(&set_)) {
+			return set->Contains(str);
+		}
+		return false;
+	}
+
 	ValueType ValueBounds::GetValueType() const noexcept {
 		return type_;
 	}
+
+	const ValueWrapper& ValueBounds::GetMin() const noexcept {
+		return min_;
+	}
+
+	const ValueWrapper& ValueBounds::GetMax() const noexcept {
+		return max_;
+	}
 }
@@ -1,42 +1,83 @@
 #ifndef COMAD_VALUE_UTILITY_H_
 #define COMAD_VALUE_UTILITY_H_
 
-#include <any>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <variant>
+#include <vector>
 
 #include "Value.h"
+#include "ValueValidator.h"
 
 namespace comad::value {
 	class ValueWrapper {
 	public:
+		ValueWrapper() = default;
+
+		// a string list keeps referring to the characters its views point into until it is copied
 		template<ValidType T>
 		explicit ValueWrapper(T t);
 
+		// a copy never borrows, so values that outlive the input they were parsed from stay valid
+		ValueWrapper(const ValueWrapper& other);
+		ValueWrapper(ValueWrapper&& other) noexcept = default;
+		ValueWrapper& operator=(const ValueWrapper& other);
+		ValueWrapper& operator=(ValueWrapper&& other) noexcept = default;
+
+		// a string value that refers to str instead of owning a copy of it
+		static ValueWrapper Borrow(std::string_view str) noexcept;
+
+		// a borrowed string is copied into owned storage the first time it is requested as std::string
 		template <ValidType T>
 		auto GetValue() -> T&;
 
+		// never modifies the value, so a value may be read from several threads. strings are
+		// returned by value since a borrowed one has no owned storage to refer to
 		template <ValidType T>
-		auto GetValue() const -> const T&;
+		auto GetValue() const -> std::conditional_t<std::is_same_v<T, std::string>, std::string, const T&>;
+
+		[[nodiscard]] std::string_view GetStringView() const;
 
 		[[nodiscard]] ValueType GetType() const noexcept;
+		[[nodiscard]] bool IsBorrowed() const noexcept;
+		// the number of elements of a list value, 0 for every other value
+		[[nodiscard]] std::size_t GetListSize() const noexcept;
+
+		void Materialize();
 
 	private:
 		ValueType type_{ ValueType::kUnknown };
 		ValueVariant value_;
+		std::string_view borrowed_{};
+		// the characters of a string list that has been materialized, shared by its copies
+		std::shared_ptr<const std::string> list_chars_{};
+		bool is_borrowed_{ false };
 	};
 
 	class ValueBounds {
 	public:
-		template <ValidType T>
+		template <ScalarValueType T>
 		ValueBounds(T t1, T t2);
 
-		bool IsInBounds(const ValidType auto& t) const;
+		bool IsInBounds(const ScalarValueType auto& t) const;
+		bool IsInBounds(std::string_view str) const;
+		// strings are passed as views
+		template <typename T>
+		bool AreInBounds(std::span<const T> values) const;
 
 		[[nodiscard]] ValueType GetValueType() const noexcept;
+		[[nodiscard]] const ValueWrapper& GetMin() const noexcept;
+		[[nodiscard]] const ValueWrapper& GetMax() const noexcept;
 	private:
 		ValueType type_;
 		ValueWrapper min_;
 		ValueWrapper max_;
+		IntervalVariant interval_;
 	};
 
 	class SupportedValueHolder {
@@ -46,26 +87,49 @@ namespace comad::value {
 		explicit SupportedValueHolder(ValueBounds bounds);
 		explicit SupportedValueHolder(ValueRange auto&& values);
 
-		template <ValidType T, ValidType... TOthers> requires (std::conjunction_v<std::is_same<T, TOthers>...>)
+		template <ScalarValueType T, ScalarValueType... TOthers> requires (std::conjunction_v<std::is_same<T, TOthers>...>)
 		explicit SupportedValueHolder(T value, TOthers... others);
 
-		bool IsValid(const ValidType auto& t) const noexcept;
+		bool IsValid(const ScalarValueType auto& t) const noexcept;
+		bool IsValid(std::string_view str) const noexcept;
+		// false if value is not of the holder's type. a list is valid if all of its elements are
+		bool IsValid(const ValueWrapper& value) const noexcept;
+
+		// true if every value is valid. the constraint is looked up once for all of them, strings are passed as views
+		template <typename T> requires (ScalarValueType<T> || std::is_same_v<T, std::string_view>)
+		bool AreValid(std::span<const T> values) const noexcept;
+		// the elements of a list value from first on
+		bool AreValid(const ValueWrapper& list, std::size_t first = 0) const noexcept;
 
 		[[nodiscard]] ValueType GetValueType() const noexcept;
 
+		// null unless the holder was made from bounds
+		[[nodiscard]] const ValueBounds* GetBounds() const noexcept;
+		[[nodiscard]] bool IsList() const noexcept;
+		// the values of a list holder, in the order of the range it was made from
+		[[nodiscard]] std::vector<ValueWrapper> GetListedValues() const;
+
 	private:
 		class List {
 		public:
 			explicit List(ValueRange auto&& range);
 
-			bool IsValid(const ValidType auto& t) const noexcept;
+			bool IsValid(const ScalarValueType auto& t) const noexcept;
+			bool IsValid(std::string_view str) const noexcept;
+			template <typename T>
+			bool AreValid(std::span<const T> values) const noexcept;
 
 			[[nodiscard]] ValueType GetValueType() const noexcept;
+			[[nodiscard]] std::vector<ValueWrapper> GetValues() const;
 
 		private:
-			std::any supported_values_{ nullptr };
+			template <ScalarValueType T>
+			List(std::in_place_type_t<T>, std::vector<T> values);
+
+			// the values are copied into a set built for their type when the option is registered
+			ValueSetVariant set_;
 			ValueType value_type_{ ValueType::kUnknown };
-			bool (*contains_)(const std::any& supported_values, const void* object);
+			std::vector<ValueWrapper> values_{};
 		};
 
 		std::variant<ValueType, ValueBounds, List> supported_values_{ ValueType::kUnknown };
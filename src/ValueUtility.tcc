@@ -1,8 +1,14 @@
 #ifndef COMAD_VALUE_UTILS_TCC_
 #define COMAD_VALUE_UTILS_TCC_
 
+#include <algorithm>
 #include <set>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "Value.h"
 
@@ -10,83 +16,139 @@ namespace comad::value {
 	template <ValidType T>
 	ValueWrapper::ValueWrapper(T t) :
 		type_{ ValueTypeTraits<T>::type },
-		value_{ t } {}
+		value_{ std::move(t) },
+		is_borrowed_{ std::is_same_v<T, std::vector<std::string_view>> } {}
 
 	template <ValidType T>
 	auto ValueWrapper::GetValue() -> T& {
 		if (type_ != ValueTypeTraits<T>::type) {
 			throw std::runtime_error("value wrapper does not hold the requested type");
 		}
+		if constexpr (std::is_same_v<T, std::string>) {
+			Materialize();
+		}
 		return std::get<ValueTypeTraits<T>::variant_index>(value_);
 	}
 
 	template <ValidType T>
-	auto ValueWrapper::GetValue() const -> const T& {
+	auto ValueWrapper::GetValue() const -> std::conditional_t<std::is_same_v<T, std::string>, std::string, const T&> {
 		if (type_ != ValueTypeTraits<T>::type) {
 			throw std::runtime_error("value wrapper does not hold the requested type");
 		}
-		return std::get<ValueTypeTraits<T>::variant_index>(value_);
+		if constexpr (std::is_same_v<T, std::string>) {
+			return std::string{ GetStringView() };
+		}
+		else {
+			return std::get<ValueTypeTraits<T>::variant_index>(value_);
+		}
 	}
 
-	template<ValidType T>
+	template<ScalarValueType T>
 	ValueBounds::ValueBounds(T t1, T t2) :
 		type_{ ValueTypeTraits<T>::type },
 		min_{ t1 },
-		max_{ t2 }
+		max_{ t2 },
+		interval_{ t2 < t1 ? Interval<T>{ t2, t1 } : Interval<T>{ t1, t2 } }
 	{
 		if (t2 < t1) std::swap(min_, max_);
 	}
 
-	bool ValueBounds::IsInBounds(const ValidType auto& t) const {
+	bool ValueBounds::IsInBounds(const ScalarValueType auto& t) const {
 		using type = std::remove_cvref_t<decltype(t)>;
 
-		if (type_ != ValueTypeTraits<type>::type) {
+		const Interval<type>* interval = std::get_if<Interval<type>>(&interval_);
+		if (interval == nullptr) {
 			throw std::invalid_argument("bounds are not for the passed type");
 		}
 
-		return min_.GetValue<type>() < t &&
-			t < max_.GetValue<type>();
+		return interval->Contains(t);
+	}
+
+	template <typename T>
+	bool ValueBounds::AreInBounds(std::span<const T> values) const {
+		const Interval<StoredType<T>>* interval = std::get_if<Interval<StoredType<T>>>(&interval_);
+		if (interval == nullptr) {
+			throw std::invalid_argument("bounds are not for the passed type");
+		}
+
+		return interval->ContainsAll(values);
 	}
 
 	SupportedValueHolder::SupportedValueHolder(ValueRange auto&& values) :
 		supported_values_{ List(std::forward<decltype(values)>(values)) }
 	{}
 
-	template <ValidType T, ValidType... TOthers> requires (std::conjunction_v<std::is_same<T, TOthers>...>)
+	template <ScalarValueType T, ScalarValueType... TOthers> requires (std::conjunction_v<std::is_same<T, TOthers>...>)
 	SupportedValueHolder::SupportedValueHolder(T value, TOthers ...others) :
 		SupportedValueHolder(std::set<T>{ { value, std::forward<TOthers>(others)... } })
 	{}
 
-	bool SupportedValueHolder::IsValid(const ValidType auto& t) const noexcept {
-		if (const ValueType* type = std::get_if<ValueType>(&supported_values_)) {
-			return *type == ValueTypeTraits<decltype(t)>::type;
+	bool SupportedValueHolder::IsValid(const ScalarValueType auto& t) const noexcept {
+		using type = std::remove_cvref_t<decltype(t)>;
+
+		if (const ValueType* value_type = std::get_if<ValueType>(&supported_values_)) {
+			return *value_type == ValueTypeTraits<type>::type;
 		}
 		if (const ValueBounds* bounds = std::get_if<ValueBounds>(&supported_values_)) {
-			return bounds->IsInBounds(t);
+			return bounds->GetValueType() == ValueTypeTraits<type>::type && bounds->IsInBounds(t);
 		}
 		return std::get<List>(supported_values_).IsValid(t);
 	}
 
-	bool SupportedValueHolder::List::IsValid(const ValidType auto& t) const noexcept {
-		if (value_type_ == ValueTypeTraits<decltype(t)>::type) {
-			return contains_(supported_values_, &t);
+	template <typename T> requires (ScalarValueType<T> || std::is_same_v<T, std::string_view>)
+	bool SupportedValueHolder::AreValid(std::span<const T> values) const noexcept {
+		constexpr ValueType type = ValueTypeTraits<StoredType<T>>::type;
+
+		if (const ValueType* value_type = std::get_if<ValueType>(&supported_values_)) {
+			return *value_type == type;
+		}
+		if (const ValueBounds* bounds = std::get_if<ValueBounds>(&supported_values_)) {
+			return bounds->GetValueType() == type && bounds->AreInBounds(values);
+		}
+		return std::get<List>(supported_values_).AreValid(values);
+	}
+
+	bool SupportedValueHolder::List::IsValid(const ScalarValueType auto& t) const noexcept {
+		if (const auto* set = std::get_if<ValueSet<decltype(t)>>(&set_)) {
+			return set->Contains(t);
 		}
 		return false;
 	}
 
-	SupportedValueHolder::List::List(ValueRange auto&& range) :
-		supported_values_{ range },
-		value_type_{ ValueTypeTraits<std::ranges::range_value_t<decltype(range)>>::type },
-		contains_{ [](const std::any& supported_values, const void* object) -> bool {
-			using range_type = std::remove_cvref_t<decltype(range)>;
-			using value_type = std::ranges::range_value_t<range_type>;
+	template <typename T>
+	bool SupportedValueHolder::List::AreValid(std::span<const T> values) const noexcept {
+		const auto* set = std::get_if<ValueSet<StoredType<T>>>(&set_);
+		if (set == nullptr) {
+			return false;
+		}
 
-			const value_type& val = *static_cast<const value_type*>(object);
-			const range_type& range = std::any_cast<const range_type&>(supported_values);
+		bool contains = true;
+		for (const T& value : values) {
+			contains &= set->Contains(value);
+		}
+		return contains;
+	}
 
-			return std::ranges::find(range, val) != range.end();
-		} }
+	SupportedValueHolder::List::List(ValueRange auto&& range) :
+		List(std::in_place_type<std::ranges::range_value_t<decltype(range)>>, [&range] {
+			std::vector<std::ranges::range_value_t<decltype(range)>> values{};
+			for (const auto& value : range) {
+				values.push_back(value);
+			}
+			return values;
+		}())
 	{}
+
+	template <ScalarValueType T>
+	SupportedValueHolder::List::List(std::in_place_type_t<T>, std::vector<T> values) :
+		set_{ ValueSet<T>{ values } },
+		value_type_{ ValueTypeTraits<T>::type }
+	{
+		values_.reserve(values.size());
+		for (const auto& value : values) {
+			values_.emplace_back(static_cast<T>(value));
+		}
+	}
 }
 
 #endif
\ No newline at end of file
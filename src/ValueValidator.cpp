@@ -0,0 +1,85 @@
+#include "ValueValidator.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace comad::value {
+	BoolSet::BoolSet(const std::vector<bool>& values) noexcept {
+		for (const bool value : values) {
+			mask_ |= static_cast<std::uint8_t>(1u << static_cast<unsigned>(value));
+		}
+	}
+
+	IntSet::IntSet(std::vector<int> values) {
+		std::ranges::sort(values);
+		values.erase(std::unique(values.begin(), values.end()), values.end());
+		if (values.empty()) {
+			return;
+		}
+
+		const std::int64_t min = values.front();
+		const auto bit_count = static_cast<std::uint64_t>(static_cast<std::int64_t>(values.back()) - min + 1);
+		if (bit_count > values.size() * 32) {
+			sorted_ = SortedSet<int>{ std::move(values) };
+			return;
+		}
+
+		min_ = min;
+		bit_count_ = bit_count;
+		bits_.assign((bit_count + 63) / 64, 0);
+		for (const int value : values) {
+			const auto index = static_cast<std::uint64_t>(static_cast<std::int64_t>(value) - min);
+			bits_[index >> 6] |= std::uint64_t{ 1 } << (index & 63);
+		}
+		dense_ = true;
+	}
+
+	bool IntSet::IsDense() const noexcept {
+		return dense_;
+	}
+
+	StringSet::StringSet(std::vector<std::string> values) {
+		std::ranges::sort(values);
+		values.erase(std::unique(values.begin(), values.end()), values.end());
+
+		std::vector<Slot> entries{};
+		entries.reserve(values.size());
+		for (const std::string& value : values) {
+			if (chars_.size() + value.size() >= kEmpty) {
+				throw std::length_error("supported values are too long to index");
+			}
+			entries.push_back(Slot{ static_cast<std::uint32_t>(chars_.size()), static_cast<std::uint32_t>(value.size()) });
+			chars_.append(value);
+		}
+
+		if (entries.size() <= kMaxLinear) {
+			slots_ = std::move(entries);
+			return;
+		}
+
+		std::vector<std::uint64_t> hashes{};
+		hashes.reserve(entries.size());
+		for (const std::string& value : values) {
+			hashes.push_back(utility::HashString(value));
+		}
+
+		utility::PerfectHash table = utility::PerfectHash::Build(hashes);
+		slots_.assign(table.slots.size(), Slot{});
+		for (std::size_t slot = 0; slot < table.slots.size(); ++slot) {
+			if (table.slots[slot] != utility::PerfectHash::kEmptySlot) {
+				slots_[slot] = entries[table.slots[slot]];
+			}
+		}
+		displacements_ = std::move(table.displacements);
+		bucket_mask_ = table.bucket_mask;
+		slot_mask_ = table.slot_mask;
+		hashed_ = true;
+	}
+
+	bool StringSet::IsHashed() const noexcept {
+		return hashed_;
+	}
+}
@@ -0,0 +1,189 @@
+#ifndef COMAD_VALUE_VALIDATOR_H_
+#define COMAD_VALUE_VALIDATOR_H_
+
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "Value.h"
+
+namespace comad::value {
+	// the values strictly between min and max. strings are compared as views
+	template <typename T>
+	class Interval {
+	public:
+		using key_type = std::conditional_t<std::is_same_v<T, std::string>, std::string_view, T>;
+
+		Interval(T min, T max);
+
+		// both compares are made and combined without a branch
+		[[nodiscard]] bool Contains(key_type value) const noexcept;
+		// so are the results for every value, a loop the compiler can vectorize
+		[[nodiscard]] bool ContainsAll(std::span<const key_type> values) const noexcept;
+
+	private:
+		T min_;
+		T max_;
+	};
+
+	// a sorted array searched without a branch per step
+	template <typename T>
+	class SortedSet {
+	public:
+		SortedSet() = default;
+		explicit SortedSet(std::vector<T> values);
+
+		[[nodiscard]] bool Contains(T value) const noexcept;
+
+	private:
+		std::vector<T> sorted_{};
+	};
+
+	class BoolSet {
+	public:
+		explicit BoolSet(const std::vector<bool>& values) noexcept;
+
+		[[nodiscard]] bool Contains(bool value) const noexcept;
+
+	private:
+		// bit 0 for false, bit 1 for true
+		std::uint8_t mask_{ 0 };
+	};
+
+	// a bitset over [min, max] of the values if it takes no more memory than the values themselves would,
+	// a sorted array otherwise
+	class IntSet {
+	public:
+		explicit IntSet(std::vector<int> values);
+
+		[[nodiscard]] bool Contains(int value) const noexcept;
+		[[nodiscard]] bool IsDense() const noexcept;
+
+	private:
+		std::int64_t min_{ 0 };
+		std::uint64_t bit_count_{ 0 };
+		std::vector<std::uint64_t> bits_{};
+		SortedSet<int> sorted_{};
+		bool dense_{ false };
+	};
+
+	// a sorted array, NaN is never contained
+	template <std::floating_point T>
+	class FloatSet {
+	public:
+		explicit FloatSet(std::vector<T> values);
+
+		[[nodiscard]] bool Contains(T value) const noexcept;
+
+	private:
+		SortedSet<T> sorted_{};
+	};
+
+	// a few strings are compared one by one. more are placed with a perfect hash, so a lookup is one hash,
+	// one slot and one compare
+	class StringSet {
+	public:
+		static constexpr std::size_t kMaxLinear = 8;
+
+		explicit StringSet(std::vector<std::string> values);
+
+		[[nodiscard]] bool Contains(std::string_view value) const noexcept;
+		[[nodiscard]] bool IsHashed() const noexcept;
+
+	private:
+		static constexpr std::uint32_t kEmpty = std::numeric_limits<std::uint32_t>::max();
+
+		struct Slot {
+			std::uint32_t offset{ 0 };
+			std::uint32_t length{ kEmpty };
+		};
+
+		// every value back to back, slots point into it
+		std::string chars_{};
+		// one per value if the set is not hashed
+		std::vector<Slot> slots_{};
+		std::vector<std::uint32_t> displacements_{};
+		std::uint64_t bucket_mask_{ 0 };
+		std::uint64_t slot_mask_{ 0 };
+		bool hashed_{ false };
+
+		[[nodiscard]] bool Equals(const Slot& slot, std::string_view value) const noexcept;
+	};
+
+	template <typename T>
+	struct ValueSetTraits;
+
+	template <>
+	struct ValueSetTraits<bool> {
+		using type = BoolSet;
+	};
+
+	template <>
+	struct ValueSetTraits<int> {
+		using type = IntSet;
+	};
+
+	template <>
+	struct ValueSetTraits<float> {
+		using type = FloatSet<float>;
+	};
+
+	template <>
+	struct ValueSetTraits<std::string> {
+		using type = StringSet;
+	};
+
+	template <>
+	struct ValueSetTraits<std::int64_t> {
+		using type = SortedSet<std::int64_t>;
+	};
+
+	template <>
+	struct ValueSetTraits<std::uint64_t> {
+		using type = SortedSet<std::uint64_t>;
+	};
+
+	template <>
+	struct ValueSetTraits<double> {
+		using type = FloatSet<double>;
+	};
+
+	template <>
+	struct ValueSetTraits<ByteSize> {
+		using type = SortedSet<ByteSize>;
+	};
+
+	template <>
+	struct ValueSetTraits<Duration> {
+		using type = SortedSet<Duration>;
+	};
+
+	template <typename T>
+	using ValueSet = typename ValueSetTraits<std::remove_cvref_t<T>>::type;
+
+	// the type a value is stored as for the type it is looked up by, strings are looked up as views
+	template <typename T>
+	using StoredType = std::conditional_t<std::is_same_v<T, std::string_view>, std::string, T>;
+
+	template <typename Variant>
+	struct ValidatorVariants;
+
+	template <typename... Ts>
+	struct ValidatorVariants<std::variant<Ts...>> {
+		using sets = std::variant<ValueSet<Ts>...>;
+		using intervals = std::variant<Interval<Ts>...>;
+	};
+
+	// one alternative for every type a single value can have, list elements are checked against them
+	using ValueSetVariant = typename ValidatorVariants<ScalarVariant>::sets;
+	using IntervalVariant = typename ValidatorVariants<ScalarVariant>::intervals;
+}
+
+#include "ValueValidator.tcc"
+#endif
@@ -0,0 +1,107 @@
+#ifndef COMAD_VALUE_VALIDATOR_TCC_
+#define COMAD_VALUE_VALIDATOR_TCC_
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#include "ValueValidator.h"
+#include "StringUtility.h"
+
+namespace comad::value {
+	template <typename T>
+	SortedSet<T>::SortedSet(std::vector<T> values) :
+		sorted_{ std::move(values) }
+	{
+		std::ranges::sort(sorted_);
+		sorted_.erase(std::unique(sorted_.begin(), sorted_.end()), sorted_.end());
+	}
+
+	template <typename T>
+	bool SortedSet<T>::Contains(T value) const noexcept {
+		if (sorted_.empty()) {
+			return false;
+		}
+
+		// a lower bound where the compiler turns the select into a conditional move
+		const T* base = sorted_.data();
+		std::size_t length = sorted_.size();
+		while (length > 1) {
+			const std::size_t half = length / 2;
+			base = base[half - 1] < value ? base + half : base;
+			length -= half;
+		}
+		return *base == value;
+	}
+
+	template <typename T>
+	Interval<T>::Interval(T min, T max) :
+		min_{ std::move(min) },
+		max_{ std::move(max) }
+	{}
+
+	template <typename T>
+	bool Interval<T>::Contains(key_type value) const noexcept {
+		return (key_type{ min_ } < value) & (value < key_type{ max_ });
+	}
+
+	template <typename T>
+	bool Interval<T>::ContainsAll(std::span<const key_type> values) const noexcept {
+		const key_type min{ min_ };
+		const key_type max{ max_ };
+
+		bool contains = true;
+		for (const key_type& value : values) {
+			contains &= (min < value) & (value < max);
+		}
+		return contains;
+	}
+
+	inline bool BoolSet::Contains(bool value) const noexcept {
+		return ((mask_ >> static_cast<unsigned>(value)) & 1u) != 0;
+	}
+
+	inline bool IntSet::Contains(int value) const noexcept {
+		if (dense_) {
+			// values below min wrap around to indexes past the end
+			const auto index = static_cast<std::uint64_t>(static_cast<std::int64_t>(value) - min_);
+			return index < bit_count_ && ((bits_[index >> 6] >> (index & 63)) & 1) != 0;
+		}
+		return sorted_.Contains(value);
+	}
+
+	template <std::floating_point T>
+	FloatSet<T>::FloatSet(std::vector<T> values) {
+		// NaN compares unequal to everything, including itself, and would break the order
+		std::erase_if(values, [](T value) { return std::isnan(value); });
+		sorted_ = SortedSet<T>{ std::move(values) };
+	}
+
+	template <std::floating_point T>
+	bool FloatSet<T>::Contains(T value) const noexcept {
+		return sorted_.Contains(value);
+	}
+
+	inline bool StringSet::Contains(std::string_view value) const noexcept {
+		if (!hashed_) {
+			for (const Slot& slot : slots_) {
+				if (Equals(slot, value)) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		const std::uint64_t hash = utility::HashString(value);
+		const std::uint32_t displacement = displacements_[(hash >> 32) & bucket_mask_];
+		return Equals(slots_[utility::PerfectHash::SlotHash(hash, displacement) & slot_mask_], value);
+	}
+
+	inline bool StringSet::Equals(const Slot& slot, std::string_view value) const noexcept {
+		return slot.length == value.size() &&
+			(value.empty() || std::memcmp(chars_.data() + slot.offset, value.data(), value.size()) == 0);
+	}
+}
+
+#endif
@@ -1,8 +1,75 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 #include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
 #include <iostream>
+#include <limits>
+#include <memory>
 
 #include "Comad.h"
 
+static std::atomic<std::size_t> allocation_count{ 0 };
+
+// every form that the replaced operator delete may free is replaced, including the nothrow and array
+// ones the standard library uses for temporary buffers
+void* operator new(std::size_t size) {
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+		return ptr;
+	}
+	throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+	return operator new(size, tag);
+}
+
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+	std::free(ptr);
+}
+
 int main() {
 	using namespace comad;
 	using namespace comad::command;
@@ -33,6 +100,53 @@ int main() {
 
 	bool failed = false;
 
+	//test lazy message formatting
+	Logger quiet_logger{ {}, "{0}{1}{2}", LogLevelSpecifier{}, SourceLocationSpecifier{}, MessageSpecifier{} };
+	bool formatted = false;
+	quiet_logger.LogParts<LogLevel::ERROR>(std::source_location::current(), "not formatted ", [&formatted] {
+		formatted = true;
+		return 0;
+	});
+
+	if (formatted) {
+		std::cerr << "lazy logging test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test asynchronous logging
+	std::ostringstream async_sink{};
+	Logger async_logger{ {.info = {std::ref(async_sink)}}, "{0}{1}{2}",
+		LogLevelSpecifier{}, SourceLocationSpecifier{}, MessageSpecifier{} };
+	async_logger.EnableAsync({ .capacity = 64, .overflow = OverflowPolicy::kBlock });
+	for (int i = 0; i < 1000; ++i) {
+		async_logger.Info("async message");
+	}
+	// longer than a record holds, written in full like a synchronous message
+	const std::string long_message(LogRecord<char>::kMaxMessageLength * 2, 'x');
+	async_logger.Info(long_message);
+	async_logger.Flush();
+
+	const std::string async_output = async_sink.str();
+	const auto async_lines = std::count(async_output.begin(), async_output.end(), '\n');
+
+	std::ostringstream drop_sink{};
+	Logger drop_logger{ {.info = {std::ref(drop_sink)}}, "{0}{1}{2}",
+		LogLevelSpecifier{}, SourceLocationSpecifier{}, MessageSpecifier{} };
+	drop_logger.EnableAsync({ .capacity = 2, .overflow = OverflowPolicy::kDrop });
+	for (int i = 0; i < 1000; ++i) {
+		drop_logger.Info("dropped message");
+	}
+	drop_logger.Flush();
+
+	const std::string drop_output = drop_sink.str();
+	const auto drop_lines = std::count(drop_output.begin(), drop_output.end(), '\n');
+
+	if (async_lines != 1001 || async_output.find(long_message + '\n') == std::string::npos ||
+		async_logger.GetDroppedCount() != 0 ||
+		drop_lines + static_cast<long>(drop_logger.GetDroppedCount()) != 1000) {
+		std::cerr << "async logging test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
 
 
 	//test simple command parsing
@@ -138,6 +252,1176 @@ int main() {
 		failed = true;
 	}
 
+	//test inline option values, bundled short options and positionals named like options
+	CommandHandler option_form_test{};
+	(option_form_test.GetCommandNode() >> "test15"sv)("name"_as, "level"_o(ValueType::kInt),
+		"all"_o(ValueType::kBool), "brief"_o(ValueType::kBool), "color"_o(ValueType::kBool)) =
+	[](const ExecutionContext& ctx) {
+		const auto level = ctx.options.find("level"sv);
+		if (ctx.args.find("name"sv)->second.GetStringView() != "level"sv || level == ctx.options.end()) {
+			return -1;
+		}
+		if (ctx.options.size() == 4 && ctx.options.find("all"sv)->second.GetValue<bool>() &&
+			ctx.options.find("brief"sv)->second.GetValue<bool>() && ctx.options.find("color"sv)->second.GetValue<bool>()) {
+			return level->second.GetValue<int>();
+		}
+		return ctx.options.size() == 1 ? -level->second.GetValue<int>() : -1;
+	};
+
+	if (option_form_test.HandleCommand("test15"sv, "level"sv, "--level=5"sv, "-abc"sv) != 5 ||
+		option_form_test.HandleCommand("test15"sv, "-l7"sv, "level"sv) != -7 ||
+		option_form_test.HandleCommand("test15"sv, "-level"sv, "8"sv, "level"sv) != -8 ||
+		option_form_test.HandleCommand("test15"sv, "level"sv, "-cba"sv, "-l"sv, "9"sv) != 9) {
+		std::cerr << "option form test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test compiled command tree
+	CommandHandler freeze_test{};
+
+	freeze_test.GetCommandNode() >> "test7"sv | "t7"sv = [](const ExecutionContext&) {
+		return 7;
+	};
+	freeze_test.GetCommandNode() >> "test7"sv >> "subcmd"sv | "sc"sv = [](const ExecutionContext&) {
+		return 8;
+	};
+	freeze_test.GetCommandNode() >> "t8"sv = [](const ExecutionContext&) {
+		return -1;
+	};
+	freeze_test.GetCommandNode() >> "test8"sv | "t8"sv = [](const ExecutionContext&) {
+		return 9;
+	};
+	freeze_test.Freeze();
+
+	if (!freeze_test.IsFrozen() ||
+		freeze_test.HandleCommand("test7"sv) != 7 ||
+		freeze_test.HandleCommand("t7"sv, "sc"sv) != 8 ||
+		freeze_test.HandleCommand("test7"sv, "subcmd"sv) != 8 ||
+		freeze_test.HandleCommand("t8"sv) != 9 ||
+		freeze_test.HandleCommand("unknown"sv) != retc::kUnknownCommand) {
+		std::cerr << "compiled command tree test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	CommandHandler moved_freeze_test{ std::move(freeze_test) };
+	if (moved_freeze_test.HandleCommand("t7"sv, "sc"sv) != 8) {
+		std::cerr << "moved compiled command tree test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	moved_freeze_test.GetCommandNode() >> "test9"sv = [](const ExecutionContext&) {
+		return 10;
+	};
+	if (moved_freeze_test.IsFrozen() || moved_freeze_test.HandleCommand("test9"sv) != 10) {
+		std::cerr << "thawed command tree test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test reusable execution contexts
+	CommandHandler allocation_test{};
+	(allocation_test.GetCommandNode() >> "test10"sv)("flag"_fl, "count"_ai, "name"_as,
+		"level"_o(ValueBounds{ 0, 10 }), "mode"_o("fast"s, "slow"s)) = [](const ExecutionContext& ctx) {
+		if (ctx.flags.find("flag"sv)->second &&
+			ctx.args.find("count"sv)->second.GetValue<int>() == 3 &&
+			ctx.options.find("level"sv)->second.GetValue<int>() == 5 &&
+			ctx.options.contains("mode"sv) && ctx.extra_args.size() == 1) {
+			return 10;
+		}
+
+		return -1;
+	};
+	allocation_test.Freeze();
+
+	const std::array allocation_test_input{ "test10"sv, "-fflag"sv, "3"sv, "--level"sv, "5"sv,
+		"-m"sv, "fast"sv, "name"sv, "extra"sv };
+	bool allocation_test_passed = allocation_test.HandleCommand(allocation_test_input) == 10;
+
+	// the values stay in a context passed by the caller, looked up by name like in a std::map
+	ExecutionContext lookup_ctx{};
+	allocation_test_passed &= allocation_test.HandleCommand(lookup_ctx, allocation_test_input) == 10 &&
+		lookup_ctx.options.at("level"sv).GetValue<int>() == 5 && lookup_ctx.args.at("name"sv).GetValue<std::string>() == "name"sv &&
+		lookup_ctx.flags.at("flag"sv);
+	try {
+		static_cast<void>(lookup_ctx.options.at("missing"sv));
+		allocation_test_passed = false;
+	}
+	catch (const std::out_of_range&) {}
+
+	// rebinding a used context and filling it again reuses its storage, in every logging configuration
+	const ContextLayout& allocation_layout =
+		std::as_const(allocation_test).GetCommandNode().GetChild("test10"sv).GetContextLayout();
+	const std::size_t level_slot = allocation_layout.options.Find("level"sv);
+	const std::size_t rebinds_before = allocation_count.load();
+	for (int i = 0; i < 100; ++i) {
+		lookup_ctx.Bind(allocation_layout);
+		lookup_ctx.flags.Set(allocation_layout.flags.Find("flag"sv), true);
+		lookup_ctx.args.Set(allocation_layout.args.Find("count"sv), ValueWrapper{ i });
+		lookup_ctx.options.Set(level_slot, ValueWrapper{ 5 });
+		lookup_ctx.extra_args.push_back("extra"sv);
+	}
+	allocation_test_passed &= allocation_count.load() == rebinds_before &&
+		lookup_ctx.options.at("level"sv).GetValue<int>() == 5 && lookup_ctx.args.at("count"sv).GetValue<int>() == 99;
+
+	//debug logging formats its messages, so whole dispatches are only counted when it is compiled out
+	if constexpr (!build_options::Verbose || !kLevelEnabled<LogLevel::DEBUG>) {
+		const std::size_t allocations_before = allocation_count.load();
+		for (int i = 0; i < 100; ++i) {
+			allocation_test_passed &= allocation_test.HandleCommand(allocation_test_input) == 10;
+		}
+		allocation_test_passed &= allocation_count.load() == allocations_before;
+	}
+
+	if (!allocation_test_passed) {
+		std::cerr << "execution context allocation test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test that string values borrow from the input and copies own their strings
+	static const std::string borrow_name = "a name that does not fit into the small string buffer"s;
+	static const std::string borrow_extra = "extra"s;
+	static std::optional<ValueWrapper> borrow_copy{};
+	static std::vector<std::string> borrow_extra_args{};
+
+	const std::array borrow_test_input{ "test11"sv, std::string_view{ borrow_name }, "--mode"sv, "TRUE"sv,
+		std::string_view{ borrow_extra } };
+
+	CommandHandler borrow_test{};
+	(borrow_test.GetCommandNode() >> "test11"sv)("name"_as, "mode"_o(ValueType::kBool)) = [](const ExecutionContext& ctx) {
+		const ValueWrapper& name = ctx.args.find("name"sv)->second;
+		if (!name.IsBorrowed() || name.GetStringView().data() != borrow_name.data() ||
+			name.GetValue<std::string>() != borrow_name || !name.IsBorrowed() ||
+			!ctx.options.find("mode"sv)->second.GetValue<bool>() ||
+			ctx.extra_args.size() != 1 || ctx.extra_args[0].data() != borrow_extra.data()) {
+			return -1;
+		}
+
+		borrow_copy = name;
+		borrow_extra_args = ctx.MaterializeExtraArgs();
+		return 11;
+	};
+
+	if (borrow_test.HandleCommand(borrow_test_input) != 11 || !borrow_copy || borrow_copy->IsBorrowed() ||
+		borrow_copy->GetStringView().data() == borrow_name.data() ||
+		borrow_copy->GetValue<std::string>() != borrow_name ||
+		borrow_extra_args != std::vector{ borrow_extra }) {
+		std::cerr << "borrowed string value test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test token classification across vector blocks and scalar tails
+	std::vector<std::string_view> classify_input{};
+	for (int i = 0; i < 10; ++i) {
+		classify_input.insert(classify_input.end(), { "-fflag"sv, "--long"sv, "-s"sv, "value"sv, "-"sv });
+	}
+	TokenTable classify_table{};
+	const std::span<const Token> classified = classify_table.Assign(classify_input.begin(), classify_input.end());
+
+	bool classify_passed = classified.size() == classify_input.size();
+	for (std::size_t i = 0; classify_passed && i < classified.size(); i += 5) {
+		classify_passed = classified[i].IsFlagPrefixed() && classified[i].IsShortOption() &&
+			classified[i].GetFlagName() == "flag"sv &&
+			classified[i + 1].IsLongOption() && !classified[i + 1].IsFlagPrefixed() &&
+			classified[i + 1].GetOptionName() == "long"sv &&
+			classified[i + 2].IsShortOption() && classified[i + 2].GetOptionName() == "s"sv &&
+			classified[i + 3].traits == kPositional && classified[i + 4].traits == kPositional;
+	}
+
+	std::string whitespace_input(100, 'x');
+	classify_passed &= !utility::HasWhitespace(whitespace_input);
+	for (std::size_t i : { 0, 15, 16, 31, 32, 63, 99 }) {
+		std::string with_whitespace = whitespace_input;
+		with_whitespace[i] = i % 2 == 0 ? ' ' : '\v';
+		classify_passed &= utility::HasWhitespace(with_whitespace);
+	}
+
+	if (!classify_passed) {
+		std::cerr << "token classification test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test command streams
+	CommandHandler stream_test{};
+	(stream_test.GetCommandNode() >> "test11"sv)("text"_as, "count"_ai) = [](const ExecutionContext& ctx) {
+		if (ctx.args.find("text"sv)->second.GetValue<std::string>() == "hello \"quoted\" world"sv) {
+			return ctx.args.find("count"sv)->second.GetValue<int>();
+		}
+
+		return -1;
+	};
+
+	const std::string stream_input =
+		"test11 'hello \"quoted\"'\\ world 1\n"
+		"\n"
+		"# comment line\n"
+		"  test11 \"hello \\\"quoted\\\" world\" 2 # trailing comment\r\n"
+		"test11 'unterminated 3\n"
+		"unknown\n"
+		"test11 hello\\ \\\"quoted\\\"\\ world 4";
+	std::istringstream stream_source{ stream_input };
+	const std::vector<LineResult> stream_results = stream_test.HandleStream(stream_source);
+
+	const auto stream_results_match = [](const std::vector<LineResult>& results) {
+		const std::array<LineResult, 5> expected{ LineResult{ 1, 1 }, LineResult{ 4, 2 },
+			LineResult{ 5, retc::kMalformedLine }, LineResult{ 6, retc::kUnknownCommand }, LineResult{ 7, 4 } };
+
+		return std::ranges::equal(results, expected, [](const LineResult& lhs, const LineResult& rhs) {
+			return lhs.line == rhs.line && lhs.result == rhs.result;
+		});
+	};
+
+	const std::filesystem::path stream_file = std::filesystem::temp_directory_path() / "comad_stream_test.txt";
+	{
+		std::ofstream file{ stream_file, std::ios::binary };
+		file << stream_input;
+	}
+	const std::vector<LineResult> file_results = stream_test.HandleFile(stream_file);
+
+	//the file is mapped privately, so tokenizing it in place must leave it untouched
+	std::ifstream file_after{ stream_file, std::ios::binary };
+	const std::string file_contents{ std::istreambuf_iterator<char>{ file_after }, std::istreambuf_iterator<char>{} };
+	file_after.close();
+	std::filesystem::remove(stream_file);
+
+	if (!stream_results_match(stream_results) || !stream_results_match(file_results) || file_contents != stream_input) {
+		std::cerr << "command stream test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test concurrent dispatch and logging
+	const unsigned int thread_count = std::max(4u, std::thread::hardware_concurrency());
+	constexpr int kConcurrentIterations = 200;
+
+	std::ostringstream concurrent_sink{};
+	Logger concurrent_logger{ {.info = {std::ref(concurrent_sink)}}, "{0}|{1}|{2}",
+		LogLevelSpecifier{}, SourceLocationSpecifier{}, MessageSpecifier{} };
+	std::atomic<int> concurrent_failures{ 0 };
+	std::vector<std::thread> concurrent_threads{};
+
+	for (unsigned int t = 0; t < thread_count; ++t) {
+		concurrent_threads.emplace_back([&, t] {
+			const std::string count = std::to_string(t % 9 + 1);
+			const std::string message = "thread " + std::to_string(t);
+			const std::array input{ "test10"sv, "-fflag"sv, "3"sv, "--level"sv, "5"sv,
+				"-m"sv, "fast"sv, "name"sv, "extra"sv };
+
+			for (int i = 0; i < kConcurrentIterations; ++i) {
+				if (allocation_test.HandleCommand(input) != 10 ||
+					arg_test.HandleCommand("test5"sv, "true"sv, "5"sv, "1.0f"sv, "value"sv) != 5 ||
+					option_test.HandleCommand("test6"sv, "--boolopt"sv, "false"sv, "--intopt"sv, "6"sv,
+						"--floatopt"sv, count, "--stringopt"sv, "value1"sv) != 6) {
+					concurrent_failures.fetch_add(1);
+				}
+				concurrent_logger.Info(message);
+			}
+		});
+	}
+	for (std::thread& thread : concurrent_threads) {
+		thread.join();
+	}
+
+	std::istringstream concurrent_output{ concurrent_sink.str() };
+	std::size_t concurrent_lines = 0;
+	for (std::string line; std::getline(concurrent_output, line); ++concurrent_lines) {
+		//every line has to come out whole, with the message of the thread that logged it
+		if (std::count(line.begin(), line.end(), '|') != 2 || line.find("|thread "sv) == std::string::npos) {
+			concurrent_failures.fetch_add(1);
+		}
+	}
+
+	if (concurrent_failures.load() != 0 || concurrent_lines != thread_count * kConcurrentIterations) {
+		std::cerr << "concurrent dispatch test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test compile time schemas, on their own and next to runtime commands
+	using SchemaTest = schema::Schema<
+		schema::Cmd<"test12", schema::Alias<"t12">,
+			schema::Arg<"count", int>, schema::Arg<"name", std::string>,
+			schema::Opt<"level", float, true>, schema::Opt<"mode", bool>, schema::Flag<"verbose">,
+			schema::Exec<[](const auto& ctx) {
+				if (Get<"count">(ctx) == 3 && Get<"name">(ctx) == "name"sv && Get<"level">(ctx) == 2.5f &&
+					Get<"mode">(ctx) == true && Get<"verbose">(ctx) && Has<"mode">(ctx) &&
+					ctx.extra_args.size() == 1 && ctx.extra_args[0] == "extra"sv) {
+					return 12;
+				}
+				return -1;
+			}>,
+			schema::Cmd<"sub", schema::Exec<[](const auto&) { return 13; }>>>>;
+
+	const std::array schema_test_input{ "test12"sv, "-fverbose"sv, "3"sv, "--level"sv, "2.5"sv, "name"sv,
+		"-m"sv, "true"sv, "extra"sv };
+	const std::array schema_alias_input{ "t12"sv, "3"sv, "name"sv, "-l"sv, "2.5"sv, "--mode"sv, "1"sv,
+		"-fverbose"sv, "extra"sv };
+
+	CommandHandler schema_fallback{};
+	schema_fallback.GetCommandNode() >> "test14"sv = [](const ExecutionContext&) {
+		return 14;
+	};
+
+	CommandHandler schema_runtime{};
+	SchemaTest::Install(schema_runtime.GetCommandNode());
+
+	bool schema_passed = SchemaTest::HandleCommand(schema_test_input) == 12 &&
+		SchemaTest::HandleCommand(schema_alias_input) == 12 &&
+		SchemaTest::HandleCommand(std::array{ "test12"sv, "3"sv, "name"sv, "--level=2.5"sv, "-m1"sv,
+			"-fverbose"sv, "extra"sv }) == 12 &&
+		SchemaTest::HandleCommand(std::array{ "test12"sv, "sub"sv }) == 13 &&
+		SchemaTest::HandleCommand(std::array{ "test12"sv, "3"sv }) == retc::kMissingRequiredOptions &&
+		SchemaTest::HandleCommand(std::array{ "test14"sv }) == retc::kUnknownCommand &&
+		SchemaTest::HandleCommand(schema_fallback, std::array{ "test14"sv }) == 14 &&
+		SchemaTest::HandleCommand(schema_fallback, schema_test_input) == 12;
+
+	for (int i = 0; i < 2; ++i) {
+		schema_passed &= schema_runtime.HandleCommand(schema_test_input) == 12 &&
+			schema_runtime.HandleCommand(schema_alias_input) == 12 &&
+			schema_runtime.HandleCommand("test12"sv, "sub"sv) == 13;
+		schema_runtime.Freeze();
+	}
+
+	if (!schema_passed) {
+		std::cerr << "schema test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test executors with captured state, stored without allocating
+	int executor_calls = 0;
+	const auto executor_state = std::make_shared<int>(17);
+	bool executor_passed = true;
+	{
+		CommandHandler executor_test{};
+		const std::size_t allocations_before = allocation_count.load();
+		CommandExecutor counting{ [&executor_calls](const ExecutionContext&) { return ++executor_calls; } };
+		CommandExecutor copied{ counting };
+		executor_passed &= allocation_count.load() == allocations_before;
+
+		executor_test.GetCommandNode() >> "test16"sv = std::move(copied);
+		executor_test.GetCommandNode().AddNode("test17"sv);
+		executor_test.GetCommandNode().GetChild("test17"sv).SetExecutor([executor_state](const ExecutionContext&) {
+			return *executor_state;
+		});
+		CommandExecutor shared = executor_test.GetCommandNode().GetChild("test17"sv).GetExecutor();
+
+		executor_passed &= !copied && counting(ExecutionContext{}) == 1 &&
+			executor_test.HandleCommand("test16"sv) == 2 && executor_test.HandleCommand("test16"sv) == 3 &&
+			executor_test.HandleCommand("test17"sv) == 17 && shared(ExecutionContext{}) == 17 &&
+			executor_state.use_count() == 3;
+
+		executor_test.Freeze();
+		executor_passed &= executor_test.HandleCommand("test16"sv) == 4;
+	}
+	executor_passed &= executor_state.use_count() == 1;
+
+	if (!executor_passed) {
+		std::cerr << "executor test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test asynchronous dispatch and coroutine executors
+	struct AsyncGate {
+		// stands in for an I/O completion, the suspended executor holds no worker until it is posted again
+		struct Awaiter {
+			AsyncGate* gate;
+
+			bool await_ready() const noexcept { return false; }
+			void await_suspend(std::coroutine_handle<> handle) const noexcept {
+				gate->waiting = handle;
+				gate->suspended.store(true);
+				gate->suspended.notify_one();
+			}
+			void await_resume() const noexcept {}
+		};
+
+		std::coroutine_handle<> waiting{};
+		std::atomic<bool> suspended{ false };
+
+		Awaiter Wait() noexcept { return Awaiter{ this }; }
+	};
+
+	ThreadPool async_pool{ 1 };
+	AsyncGate async_gate{};
+	CommandHandler async_test{};
+	(async_test.GetCommandNode() >> "test18"sv)("value"_ai) = [&async_gate](const ExecutionContext& ctx) -> CommandTask {
+		co_await async_gate.Wait();
+		co_return ctx.args.find("value"sv)->second.GetValue<int>();
+	};
+	(async_test.GetCommandNode() >> "test19"sv)("name"_as) = [](const ExecutionContext& ctx) {
+		return static_cast<int>(ctx.args.find("name"sv)->second.GetStringView().size() +
+			(ctx.extra_args.empty() ? 0 : ctx.extra_args[0].size()));
+	};
+	async_test.GetCommandNode() >> "test20"sv = [](const ExecutionContext&) -> int {
+		throw std::runtime_error{ "test20" };
+	};
+	async_test.GetCommandNode() >> "test21"sv = [&async_pool](const ExecutionContext&) -> CommandTask {
+		co_await async_pool.Schedule();
+		co_return 21;
+	};
+	async_test.GetCommandNode() >> "test22"sv = [&async_test, &async_pool](const ExecutionContext&) -> CommandTask {
+		co_return co_await async_test.HandleCommandAsync(async_pool, std::array{ "test19"sv, "name"sv }) + 18;
+	};
+
+	const CommandFuture gated = async_test.HandleCommandAsync(async_pool, std::array{ "test18"sv, "18"sv });
+	async_gate.suspended.wait(false);
+
+	// the only worker is free while test18 waits, and the input can go away before the command runs
+	std::vector<std::string> async_input{ "test19"s, "a name that does not fit into the small string buffer"s, "extra"s };
+	const CommandFuture owned = async_test.HandleCommandAsync(async_pool, async_input);
+	async_input.clear();
+	async_input.shrink_to_fit();
+	bool async_passed = owned.Get() == 58 && !gated.IsReady();
+
+	async_pool.Post(async_gate.waiting);
+	async_passed &= gated.Get() == 18 &&
+		async_test.HandleCommandAsync(async_pool, std::array{ "test23"sv }).Get() == retc::kUnknownCommand &&
+		async_test.HandleCommand("test21"sv) == 21 &&
+		async_test.HandleCommandAsync(std::array{ "test21"sv }).Get() == 21 &&
+		async_test.HandleCommandAsync(async_pool, std::array{ "test22"sv }).Get() == 22;
+
+	try {
+		async_test.HandleCommandAsync(async_pool, std::array{ "test20"sv }).Get();
+		async_passed = false;
+	}
+	catch (const std::runtime_error&) {}
+
+	if (!async_passed) {
+		std::cerr << "asynchronous dispatch test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test result caching of pure and expiring commands
+	int cache_runs = 0;
+	CommandHandler cache_test{};
+	CommandNode& cached_node = cache_test.GetCommandNode() >> "test24"sv;
+	cached_node("name"_as, "level"_o(ValueType::kInt), "mode"_o(ValueType::kString), "verbose"_fl) =
+		[&cache_runs](const ExecutionContext& ctx) {
+			++cache_runs;
+			return ctx.options.find("level"sv)->second.GetValue<int>();
+		};
+	cached_node.SetCachePolicy(CachePolicy{});
+	CommandNode& expiring_node = cache_test.GetCommandNode() >> "test25"sv;
+	expiring_node = [&cache_runs](const ExecutionContext&) { return ++cache_runs; };
+	expiring_node.SetCachePolicy(CachePolicy{ std::chrono::steady_clock::duration::zero() });
+	cache_test.Freeze();
+
+	// options in any order and values in any spelling that parses to the same context share a result
+	bool cache_passed = cache_test.HandleCommand("test24"sv, "name"sv, "--level"sv, "05"sv, "-m"sv, "fast"sv) == 5 &&
+		cache_test.HandleCommand("test24"sv, "name"sv, "-mfast"sv, "--level=5"sv) == 5 &&
+		cache_test.HandleCommand("test24"sv, "-m"sv, "fast"sv, "name"sv, "-l5"sv) == 5 && cache_runs == 1 &&
+		cache_test.HandleCommand("test24"sv, "name"sv, "--level"sv, "5"sv, "-fverbose"sv, "-m"sv, "fast"sv) == 5 &&
+		cache_test.HandleCommand("test24"sv, "other"sv, "--level"sv, "5"sv, "-m"sv, "fast"sv) == 5 && cache_runs == 3 &&
+		cache_test.HandleCommandAsync(async_pool, std::array{ "test24"sv, "name"sv, "-l5"sv, "-mfast"sv }).IsReady() &&
+		cache_test.HandleCommand("test25"sv) == 4 && cache_test.HandleCommand("test25"sv) == 5 && cache_runs == 5;
+
+	const CacheStats cache_stats = cache_test.GetCacheStats();
+	cache_passed &= cache_stats.hits == 3 && cache_stats.misses == 5 && cache_stats.size == 4;
+
+	cache_test.InvalidateCache(cached_node);
+	cache_passed &= cache_test.HandleCommand("test24"sv, "name"sv, "-l5"sv, "-mfast"sv) == 5 && cache_runs == 6 &&
+		cache_test.GetCacheStats().size == 2;
+	cache_test.InvalidateCache();
+	cache_test.ResetCacheStats();
+	cache_passed &= cache_test.GetCacheStats().size == 0 && cache_test.GetCacheStats().hits == 0 &&
+		cache_test.HandleCommandAsync(async_pool, std::array{ "test24"sv, "name"sv, "-l5"sv, "-mfast"sv }).Get() == 5 &&
+		cache_test.HandleCommand("test24"sv, "name"sv, "-l5"sv, "-mfast"sv) == 5 && cache_runs == 7;
+
+	// a running command keeps its context and does not cache its result once the tree has been replaced
+	AsyncGate cache_gate{};
+	CommandNode& gated_cached_node = cache_test.GetCommandNode() >> "test26"sv;
+	gated_cached_node("level"_o(ValueType::kInt)) = [&cache_gate](const ExecutionContext& ctx) -> CommandTask {
+		co_await cache_gate.Wait();
+		co_return ctx.options.begin()->first == "level"sv ? ctx.options.at("level"sv).GetValue<int>() : -1;
+	};
+	gated_cached_node.SetCachePolicy(CachePolicy{});
+	cache_test.Freeze();
+
+	const CommandFuture replaced = cache_test.HandleCommandAsync(async_pool, std::array{ "test26"sv, "-l26"sv });
+	cache_gate.suspended.wait(false);
+	cache_test.GetCommandNode() = CommandNode{};
+	async_pool.Post(cache_gate.waiting);
+	cache_passed &= replaced.Get() == 26 && cache_test.GetCacheStats().size == 0;
+
+	// the same holds for a synchronous command that invalidates the cache while it runs
+	CommandNode& invalidating_node = cache_test.GetCommandNode() >> "test27"sv;
+	invalidating_node = [&cache_test, &cache_runs](const ExecutionContext&) {
+		cache_test.InvalidateCache();
+		return ++cache_runs;
+	};
+	invalidating_node.SetCachePolicy(CachePolicy{});
+	cache_test.Freeze();
+	cache_passed &= cache_test.HandleCommand("test27"sv) == 8 && cache_test.GetCacheStats().size == 0 &&
+		cache_test.HandleCommand("test27"sv) == 9;
+
+	if (!cache_passed) {
+		std::cerr << "result cache test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test batch registration, indexes are built once the batch is closed
+	CommandHandler batch_test{};
+	{
+		CommandBatch batch{ batch_test.GetCommandNode() };
+		for (int i = 0; i < 3; ++i) {
+			CommandNode& node = batch_test.GetCommandNode() >> "batch"sv >> ("test" + std::to_string(26 + i));
+			node | ("b" + std::to_string(i)) | "shared"sv;
+			node("name"_as, "mode"_o(ValueType::kString)[true]);
+			node("level"_o(ValueType::kInt)[true]);
+			node = [i](const ExecutionContext& ctx) {
+				return 26 + i + ctx.options.find("level"sv)->second.GetValue<int>();
+			};
+		}
+	}
+
+	const CommandNode& batch_parent = std::as_const(batch_test).GetCommandNode().GetChild("batch"sv);
+	bool batch_passed = batch_parent.GetChild("test26"sv).GetRequiredOptionCount() == 2 &&
+		batch_parent.GetChildNameFromAlias("shared"sv) == "test26"sv &&
+		!batch_parent.GetChild("test27"sv).GetTemplate().aliases.contains("shared") &&
+		batch_test.HandleCommand("batch"sv, "b1"sv, "name"sv, "-mfast"sv, "-l1"sv) == 28 &&
+		batch_test.HandleCommand("batch"sv, "shared"sv, "name"sv, "-mfast"sv, "-l0"sv) == 26 &&
+		batch_test.HandleCommand("batch"sv, "test28"sv, "name"sv, "-l0"sv) == retc::kMissingRequiredOptions;
+
+	// setting a template again replaces its required options instead of adding to them
+	CommandNode& batch_child = batch_test.GetCommandNode().GetChild("batch"sv).GetChild("test26"sv);
+	batch_child.SetTemplate(CommandTemplate{ batch_child.GetTemplate() });
+	batch_passed &= batch_child.GetRequiredOptionCount() == 2 &&
+		batch_test.GetCommandNode().GetChild("batch"sv).Remove("b2"sv) &&
+		!batch_test.GetCommandNode().GetChild("batch"sv).HasChild("test28"sv) &&
+		!batch_test.GetCommandNode().GetChild("batch"sv).HasChildAlias("b2"sv) &&
+		batch_test.GetCommandNode().GetChild("batch"sv).HasChildAlias("shared"sv);
+
+	if (!batch_passed) {
+		std::cerr << "batch registration test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test command images, dispatched from a mapped file with executors bound by id
+	ExecutorRegistry image_registry{};
+	image_registry.Register("test29", [](const ExecutionContext& ctx) {
+		return 29 + ctx.options.find("level"sv)->second.GetValue<int>() + (ctx.flags.contains("force"sv) ? 100 : 0);
+	});
+	image_registry.Register("test30", [](const ExecutionContext& ctx) {
+		return static_cast<int>(ctx.args.find("name"sv)->second.GetStringView().size()) +
+			static_cast<int>(ctx.options.find("mode"sv)->second.GetStringView().size());
+	});
+
+	CommandNode image_root{};
+	CommandNode& image_test29 = image_root >> "image"sv >> "test29"sv;
+	image_test29 | "t29"sv;
+	image_test29("force"_fl, "level"_o(ValueBounds{ 0, 10 })[true]);
+	image_registry.Bind(image_test29, "test29"sv);
+	CommandNode& image_test30 = image_root >> "image"sv >> "test30"sv;
+	image_test30("name"_as, "mode"_o("fast"s, "slow"s), "ratio"_o(ValueType::kFloat));
+	image_registry.Bind(image_test30, "test30"sv);
+
+	const std::filesystem::path image_file = std::filesystem::temp_directory_path() / "comad_image_test.bin";
+	CommandImage::Save(image_root, image_file);
+	bool image_passed = false;
+	{
+		const CommandImage image{ image_file, image_registry };
+		const auto image_dispatch = [&image](auto... args) {
+			return image.HandleCommand(std::array<std::string_view, sizeof...(args)>{ args... });
+		};
+		image_passed = image.GetNodeCount() == 4 &&
+			image_dispatch("image"sv, "t29"sv, "--level"sv, "5"sv, "-fforce"sv) == 134 &&
+			image_dispatch("image"sv, "test29"sv, "--level"sv, "10"sv) == retc::kInvalidOptionValue &&
+			image_dispatch("image"sv, "test29"sv) == retc::kMissingRequiredOptions &&
+			image_dispatch("image"sv, "test30"sv, "abc"sv, "-m"sv, "slow"sv) == 7 &&
+			image_dispatch("image"sv, "test30"sv, "abc"sv, "-m"sv, "medium"sv) == retc::kInvalidOptionValue &&
+			image_dispatch("image"sv, "test31"sv) == retc::kUnknownCommand &&
+			image_dispatch() == retc::kNoInput &&
+			image.GetNode(image.FindChild(image.FindChild(CommandImage::kRootId, "image"sv), "test30"sv))
+				.GetOption("mode"sv).short_name == 'm';
+	}
+	std::filesystem::remove(image_file);
+
+	// images of other versions are rejected, executors without an id cannot be written
+	std::vector<std::byte> image_bytes = CommandImage::Serialize(image_root);
+	image_bytes[8] = std::byte{ 0xFF };
+	try {
+		const CommandImage image{ image_bytes, image_registry };
+		image_passed = false;
+	}
+	catch (const std::runtime_error&) {}
+
+	image_test30 = [](const ExecutionContext&) { return 0; };
+	try {
+		image_bytes = CommandImage::Serialize(image_root);
+		image_passed = false;
+	}
+	catch (const std::invalid_argument&) {}
+
+	if (!image_passed) {
+		std::cerr << "command image test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test dispatch metrics and latency histograms
+	LatencyHistogram histogram{};
+	for (int i = 1; i <= 1000; ++i) {
+		histogram.Record(std::chrono::nanoseconds{ i });
+	}
+	const auto median = histogram.GetPercentile(50.0).count();
+	bool metrics_passed = histogram.GetCount() == 1000 && histogram.GetMean().count() == 500 &&
+		median >= 500 && median <= 500 + 500 / static_cast<long>(LatencyHistogram::kSubBucketCount) &&
+		histogram.GetMax().count() >= 1000 && histogram.GetPercentile(100.0) == histogram.GetMax();
+
+	CommandHandler metrics_test{};
+	(metrics_test.GetCommandNode() >> "test31"sv)("level"_o(ValueBounds{ 0, 10 })[true]) = [](const ExecutionContext&) {
+		return 31;
+	};
+
+	if constexpr (build_options::EnableMetrics) {
+		std::ostringstream stats_output{};
+		metrics_test.AddStatsCommand("stats"sv, stats_output);
+		for (int i = 0; i < 3; ++i) {
+			metrics_passed &= metrics_test.HandleCommand("test31"sv, "--level"sv, "5"sv) == 31;
+		}
+		metrics_passed &= metrics_test.HandleCommand("test31"sv, "--level"sv, "50"sv) == retc::kInvalidOptionValue &&
+			metrics_test.HandleCommand("test31"sv) == retc::kMissingRequiredOptions &&
+			metrics_test.HandleCommand("test32"sv) == retc::kUnknownCommand;
+
+		const MetricsSnapshot metrics = metrics_test.GetMetrics();
+		const NodeMetrics* test31_metrics = metrics.Find("test31"sv);
+		const NodeMetrics* root_metrics = metrics.Find(""sv);
+		metrics_passed &= test31_metrics != nullptr && root_metrics != nullptr &&
+			test31_metrics->calls == 5 && test31_metrics->GetErrorCount() == 2 &&
+			test31_metrics->GetErrorCount(retc::kInvalidOptionValue) == 1 &&
+			test31_metrics->GetLatency(DispatchPhase::kLookup).GetCount() == 5 &&
+			test31_metrics->GetLatency(DispatchPhase::kValidation).GetCount() == 5 &&
+			test31_metrics->GetLatency(DispatchPhase::kExecutor).GetCount() == 3 &&
+			root_metrics->GetErrorCount(retc::kUnknownCommand) == 1;
+
+		metrics_passed &= metrics_test.HandleCommand("stats"sv) == 0 &&
+			stats_output.str().find("test31") != std::string::npos &&
+			metrics_test.GetMetrics().Find("test31"sv)->calls == 5;
+		stats_output.str({});
+
+		metrics_passed &= metrics_test.HandleCommand("stats"sv, "-freset"sv) == 0 &&
+			stats_output.str().find("test31") != std::string::npos &&
+			metrics_test.GetMetrics().Find("test31"sv)->calls == 0;
+
+		// a path keeps a single row across swapped trees, and a node that reuses the address of a freed
+		// one is not counted as that one
+		for (const std::string_view name : { "test33"sv, "test34"sv, "test35"sv }) {
+			CommandNode swapped{};
+			(swapped >> "test31"sv) = [](const ExecutionContext&) { return 31; };
+			(swapped >> name) = [](const ExecutionContext&) { return 33; };
+			metrics_test.SetCommandNode(std::move(swapped));
+			metrics_passed &= metrics_test.HandleCommand("test31"sv) == 31 && metrics_test.HandleCommand(name) == 33;
+		}
+
+		const MetricsSnapshot swapped_metrics = metrics_test.GetMetrics();
+		metrics_passed &= std::ranges::count(swapped_metrics.nodes, "test31"sv, &NodeMetrics::path) == 1 &&
+			swapped_metrics.Find("test31"sv)->calls == 3;
+		for (const std::string_view name : { "test33"sv, "test34"sv, "test35"sv }) {
+			metrics_passed &= swapped_metrics.Find(name) != nullptr && swapped_metrics.Find(name)->calls == 1;
+		}
+	}
+	else {
+		try {
+			metrics_test.EnableMetrics();
+			metrics_passed = false;
+		}
+		catch (const std::logic_error&) {}
+	}
+
+	if (!metrics_passed) {
+		std::cerr << "metrics test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test span tracing of the dispatch phases
+	struct CollectingSink : TraceSink {
+		std::vector<Trace> traces{};
+
+		void Write(const Trace& trace) override {
+			traces.push_back(trace);
+		}
+	};
+
+	std::ostringstream chrome_output{};
+	{
+		ChromeTraceSink chrome_sink{ chrome_output };
+		const TraceSpan::clock::time_point now = TraceSpan::clock::now();
+		chrome_sink.Write(Trace{ 1, 1, 0, { TraceSpan{ kSpanDispatch, "say \"hi\"\n", now, std::chrono::nanoseconds{ 1500 } } } });
+	}
+	bool trace_passed = chrome_output.str().starts_with("{\"traceEvents\":[") &&
+		chrome_output.str().find(R"("name":"HandleCommand")") != std::string::npos &&
+		chrome_output.str().find(R"("dur":1.500)") != std::string::npos &&
+		chrome_output.str().find(R"("detail":"say \"hi\"\n","result":0)") != std::string::npos &&
+		chrome_output.str().ends_with("],\"displayTimeUnit\":\"ns\"}\n");
+
+	CommandHandler trace_test{};
+	(trace_test.GetCommandNode() >> "test32"sv)("count"_ai, "level"_o(ValueBounds{ 0, 10 })[true]) = [](const ExecutionContext&) {
+		return 32;
+	};
+
+	if constexpr (build_options::EnableTracing) {
+		const auto sink = std::make_shared<CollectingSink>();
+		trace_test.EnableTracing(sink);
+		trace_passed &= trace_test.HandleCommand("test32"sv, "3"sv, "--level"sv, "5"sv) == 32 && sink->traces.size() == 1;
+
+		std::vector<std::string_view> span_names{};
+		if (!sink->traces.empty()) {
+			for (const TraceSpan& span : sink->traces[0].spans) {
+				span_names.push_back(span.name);
+			}
+			trace_passed &= sink->traces[0].result == 32 && sink->traces[0].spans.back().detail == "test32";
+		}
+		trace_passed &= span_names == std::vector<std::string_view>{ kSpanFindNode, kSpanStringToValue, kSpanStringToValue,
+			kSpanIsValueValid, kSpanParseOption, kSpanRequiredCheck, kSpanExecutor, kSpanDispatch };
+
+		// only every third dispatch of the thread is traced
+		trace_test.EnableTracing(sink, 3);
+		sink->traces.clear();
+		for (int i = 0; i < 6; ++i) {
+			trace_test.HandleCommand("test32"sv, "3"sv);
+		}
+		trace_passed &= sink->traces.size() == 2 && sink->traces[0].result == retc::kMissingRequiredOptions;
+
+		trace_test.DisableTracing();
+		trace_test.HandleCommand("test32"sv, "3"sv, "--level"sv, "5"sv);
+		trace_passed &= sink->traces.size() == 2;
+	}
+	else {
+		try {
+			trace_test.EnableTracing(std::make_shared<CollectingSink>());
+			trace_passed = false;
+		}
+		catch (const std::logic_error&) {}
+	}
+
+	if (!trace_passed) {
+		std::cerr << "trace test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test did you mean suggestions for unknown commands and options
+	bool suggestion_passed = SuggestionIndex::GetEditDistance("status"sv, "stauts"sv, 3) == 1 &&
+		SuggestionIndex::GetEditDistance("status"sv, "stat"sv, 3) == 2 &&
+		SuggestionIndex::GetEditDistance("status"sv, "remove"sv, 2) == 3;
+
+	CommandHandler suggestion_test{};
+	CommandNode& remote_node = suggestion_test.GetCommandNode() >> "remote"sv;
+	(remote_node >> "add"sv)("name"_o(ValueType::kString), "verbose"_o(ValueType::kBool)) = [](const ExecutionContext&) {
+		return 33;
+	};
+	(remote_node >> "remove"sv) | "delete"sv = [](const ExecutionContext&) { return 0; };
+	suggestion_test.GetCommandNode() >> "restore"sv = [](const ExecutionContext&) { return 0; };
+	suggestion_test.GetCommandNode() >> "status"sv = [](const ExecutionContext&) { return 0; };
+
+	for (const bool frozen : { false, true }) {
+		if (frozen) {
+			suggestion_test.Freeze();
+		}
+
+		const std::array unknown_command{ "remote"sv, "remov"sv };
+		const std::vector<Suggestion> command_suggestions = suggestion_test.Suggest(unknown_command);
+		suggestion_passed &= suggestion_test.HandleCommand(unknown_command) == retc::kUnknownCommand &&
+			command_suggestions.size() == 1 && command_suggestions[0].name == "remove" &&
+			command_suggestions[0].distance == 1;
+
+		const std::array unknown_option{ "remote"sv, "add"sv, "--nmae"sv, "origin"sv };
+		const std::vector<Suggestion> option_suggestions = suggestion_test.Suggest(unknown_option);
+		// with verbose logging the failed dispatch suggests from the node and token it stopped at
+		suggestion_passed &= (build_options::SkipUnknownOption ||
+			suggestion_test.HandleCommand(unknown_option) == retc::kUnknownOption) &&
+			option_suggestions.size() == 1 &&
+			option_suggestions[0].name == std::string{ build_options::OptionPrefix } + "name";
+
+		const CommandNode& suggestion_root = std::as_const(suggestion_test).GetCommandNode();
+		const std::vector<Suggestion> direct = suggestion_test.SuggestCommand(suggestion_root, "remore"sv);
+		const std::vector<Suggestion> alias = suggestion_test.SuggestCommand(remote_node, "delate"sv);
+		suggestion_passed &= direct.size() == 2 && direct[0].name == "remote" && direct[1].name == "restore" &&
+			alias.size() == 1 && alias[0].name == "delete" &&
+			suggestion_test.SuggestCommand(suggestion_root, "zzz"sv).empty() &&
+			suggestion_test.Suggest(std::array{ "status"sv }).empty();
+	}
+
+	if (!suggestion_passed) {
+		std::cerr << "suggestion test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test completion of commands, options and listed values
+	CommandHandler completion_test{};
+	CommandNode& config_node = completion_test.GetCommandNode() >> "config"sv;
+	(config_node >> "set"sv)("level"_o("low"s, "lower"s, "high"s), "force"_fl) = [](const ExecutionContext&) { return 0; };
+	config_node >> "show"sv | "sh"sv = [](const ExecutionContext&) { return 0; };
+	config_node >> "shutdown"sv = [](const ExecutionContext&) { return 0; };
+	completion_test.GetCommandNode() >> "connect"sv = [](const ExecutionContext&) { return 0; };
+
+	const auto completion_texts = [&completion_test](const auto& partial_argv) {
+		std::vector<std::string> texts{};
+		for (const Completion& completion : completion_test.Complete(partial_argv)) {
+			texts.push_back(completion.text);
+		}
+		return texts;
+	};
+
+	bool completion_passed = true;
+	for (const bool frozen : { false, true }) {
+		if (frozen) {
+			completion_test.Freeze();
+		}
+
+		const std::string option_prefix{ build_options::OptionPrefix };
+		completion_passed &= completion_texts(std::array{ "co"sv }) == std::vector<std::string>{ "config", "connect" } &&
+			completion_texts(std::array{ "config"sv, "s"sv }) == std::vector<std::string>{ "set", "sh", "show", "shutdown" } &&
+			completion_texts(std::array{ "config"sv, "sho"sv }) == std::vector<std::string>{ "show" } &&
+			completion_texts(std::array{ "config"sv, "x"sv }).empty() &&
+			completion_texts(std::vector<std::string>{ "config", "set", option_prefix + "l" }) ==
+				std::vector<std::string>{ option_prefix + "level" } &&
+			completion_texts(std::vector<std::string>{ "config", "set", option_prefix + "level", "lo" }) ==
+				std::vector<std::string>{ "low", "lower" } &&
+			completion_texts(std::vector<std::string_view>{}) == std::vector<std::string>{ "config", "connect" };
+	}
+
+	// the most used commands are completed first
+	completion_test.EnableUsageCounting();
+	for (int i = 0; i < 3; ++i) {
+		completion_test.HandleCommand("config"sv, "shutdown"sv);
+	}
+	completion_test.HandleCommand("config"sv, "sh"sv);
+	const std::vector<Completion> ranked = completion_test.Complete(std::array{ "config"sv, "sh"sv }, 2);
+	completion_passed &= ranked.size() == 2 && ranked[0].text == "shutdown" && ranked[0].uses == 3 &&
+		ranked[1].text == "sh" && ranked[1].kind == CompletionKind::kAlias && ranked[1].uses == 1;
+
+	if (!completion_passed) {
+		std::cerr << "completion test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test validators specialized for the type of the supported values
+	const std::vector<int> dense_ints{ -3, 0, 5, 64, 65, 127 };
+	const std::vector<int> sparse_ints{ std::numeric_limits<int>::min(), -100000, 7, 1 << 20, std::numeric_limits<int>::max() };
+	std::vector<std::string> many_strings{};
+	for (int i = 0; i < 100; ++i) {
+		many_strings.push_back("mode" + std::to_string(i * 7));
+	}
+	many_strings.push_back("");
+
+	const SupportedValueHolder dense_holder{ dense_ints };
+	const SupportedValueHolder sparse_holder{ sparse_ints };
+	const SupportedValueHolder string_holder{ many_strings };
+	const SupportedValueHolder float_holder{ std::vector{ 0.5f, std::numeric_limits<float>::quiet_NaN(), -2.0f } };
+	const SupportedValueHolder bool_holder{ std::vector{ true } };
+	const SupportedValueHolder string_bounds{ ValueBounds{ "b"s, "d"s } };
+
+	bool validator_passed = IntSet{ dense_ints }.IsDense() && !IntSet{ sparse_ints }.IsDense() &&
+		StringSet{ many_strings }.IsHashed() && !StringSet{ { "a"s, "b"s } }.IsHashed();
+	for (int value = -200; value <= 200; ++value) {
+		validator_passed &= dense_holder.IsValid(value) == (std::ranges::find(dense_ints, value) != dense_ints.end()) &&
+			sparse_holder.IsValid(value) == (std::ranges::find(sparse_ints, value) != sparse_ints.end());
+	}
+	for (const int value : sparse_ints) {
+		validator_passed &= sparse_holder.IsValid(value) && !sparse_holder.IsValid(value == 0 ? 1 : value / 2 + 1) &&
+			!dense_holder.IsValid(value);
+	}
+	for (int i = 0; i < 700; ++i) {
+		const std::string name = "mode" + std::to_string(i);
+		validator_passed &= string_holder.IsValid(name) == (i % 7 == 0) && !string_holder.IsValid(name + "x");
+	}
+	validator_passed &= string_holder.IsValid(""sv) && !string_holder.IsValid(5) &&
+		float_holder.IsValid(-2.0f) && float_holder.IsValid(0.5f) && !float_holder.IsValid(0.0f) &&
+		!float_holder.IsValid(std::numeric_limits<float>::quiet_NaN()) &&
+		bool_holder.IsValid(true) && !bool_holder.IsValid(false) &&
+		string_bounds.IsValid("c"sv) && !string_bounds.IsValid("b"sv) && !string_bounds.IsValid("e"sv) &&
+		dense_holder.IsValid(ValueWrapper{ 64 }) && !dense_holder.IsValid(ValueWrapper{ 64.0f }) &&
+		string_holder.IsValid(ValueWrapper::Borrow("mode14"sv)) && !SupportedValueHolder{ ValueBounds{ 0, 10 } }.IsValid(5.0f);
+
+	const std::vector<ValueWrapper> listed = SupportedValueHolder{ std::vector{ 3, 1, 2 } }.GetListedValues();
+	validator_passed &= listed.size() == 3 && listed[0].GetValue<int>() == 3 && listed[2].GetValue<int>() == 2;
+
+	CommandHandler validator_test{};
+	const std::string mode_option = std::string{ build_options::OptionPrefix } + "mode";
+	(validator_test.GetCommandNode() >> "test33"sv)("mode"_o(many_strings)) = [](const ExecutionContext&) { return 33; };
+	validator_passed &= validator_test.HandleCommand(std::array{ "test33"sv, std::string_view{ mode_option }, "mode693"sv }) == 33 &&
+		validator_test.HandleCommand(std::array{ "test33"sv, std::string_view{ mode_option }, "mode694"sv }) != 33;
+
+	if (!validator_passed) {
+		std::cerr << "validator test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test 64-bit numbers, byte sizes and durations
+	const auto parsed = [](ValueType type, std::string_view str) { return detail::StringToValue(type, str); };
+	const auto bytes_of = [&parsed](std::string_view str) {
+		const std::optional<ValueWrapper> value = parsed(ValueType::kByteSize, str);
+		return value ? std::optional{ value->GetValue<ByteSize>().bytes } : std::nullopt;
+	};
+	const auto duration_of = [&parsed](std::string_view str) {
+		const std::optional<ValueWrapper> value = parsed(ValueType::kDuration, str);
+		return value ? std::optional{ value->GetValue<Duration>() } : std::nullopt;
+	};
+
+	bool wide_value_passed = parsed(ValueType::kInt64, "-9000000000000"sv)->GetValue<std::int64_t>() == -9000000000000 &&
+		parsed(ValueType::kUInt64, "18446744073709551615"sv)->GetValue<std::uint64_t>() == 18446744073709551615ull &&
+		!parsed(ValueType::kUInt64, "-1"sv) &&
+		parsed(ValueType::kDouble, "2.5e300"sv)->GetValue<double>() == 2.5e300 &&
+		bytes_of("64MiB"sv) == 64ull << 20 && bytes_of("1kb"sv) == 1000 && bytes_of("12"sv) == 12 &&
+		bytes_of("7B"sv) == 7 && !bytes_of("MiB"sv) && !bytes_of("3XB"sv) && !bytes_of("20000PiB"sv) &&
+		duration_of("250ms"sv) == std::chrono::milliseconds{ 250 } &&
+		duration_of("1h30m"sv) == std::chrono::minutes{ 90 } && duration_of("0"sv) == Duration::zero() &&
+		duration_of("2s500us"sv) == std::chrono::microseconds{ 2'000'500 } &&
+		!duration_of("5"sv) && !duration_of("1x"sv) && !duration_of("ms"sv) && !duration_of("3000000h"sv) &&
+		ValueTypeNames.at(ValueType::kDuration) == "duration"sv;
+
+	CommandHandler wide_test{};
+	CommandNode& wide_node = (wide_test.GetCommandNode() >> "test34"sv)("id"_al, "ratio"_ad,
+		"limit"_o(ValueBounds{ ByteSize{ 0 }, ByteSize{ 1ull << 30 } }),
+		"timeout"_o(ValueBounds{ Duration::zero(), Duration{ std::chrono::minutes{ 1 } } }),
+		"window"_o(Duration{ std::chrono::seconds{ 1 } }, Duration{ std::chrono::seconds{ 5 } }));
+	wide_node = [](const ExecutionContext& ctx) {
+		const bool values_match = ctx.args.find("id"sv)->second.GetValue<std::int64_t>() == 1ll << 40 &&
+			ctx.args.find("ratio"sv)->second.GetValue<double>() == 0.25 &&
+			ctx.options.find("limit"sv)->second.GetValue<ByteSize>() == ByteSize{ 512ull << 20 } &&
+			ctx.options.find("timeout"sv)->second.GetValue<Duration>() == std::chrono::seconds{ 30 };
+		return values_match ? 34 : 0;
+	};
+	const std::string limit_option = std::string{ build_options::OptionPrefix } + "limit";
+	const std::string timeout_option = std::string{ build_options::OptionPrefix } + "timeout";
+	const std::string window_option = std::string{ build_options::OptionPrefix } + "window";
+
+	// images keep the new types and their bounds
+	ExecutorRegistry wide_registry{};
+	wide_registry.Register("test34", wide_node.GetExecutor());
+	wide_registry.Bind(wide_node, "test34"sv);
+	const std::vector<std::byte> wide_bytes = CommandImage::Serialize(std::as_const(wide_test).GetCommandNode());
+	const CommandImage wide_image{ wide_bytes, wide_registry };
+
+	for (const bool from_image : { false, true }) {
+		const auto wide_dispatch = [&](std::string_view timeout, std::string_view window) {
+			const std::array input{ "test34"sv, "1099511627776"sv, "0.25"sv, std::string_view{ limit_option }, "512MiB"sv,
+				std::string_view{ timeout_option }, timeout, std::string_view{ window_option }, window };
+			return from_image ? wide_image.HandleCommand(input) : wide_test.HandleCommand(input);
+		};
+		wide_value_passed &= wide_dispatch("30s"sv, "5s"sv) == 34 &&
+			wide_dispatch("90s"sv, "5s"sv) == retc::kInvalidOptionValue &&
+			wide_dispatch("30s"sv, "2s"sv) == retc::kInvalidOptionValue &&
+			wide_dispatch("30 s"sv, "5s"sv) != 34;
+	}
+
+	if (!wide_value_passed) {
+		std::cerr << "wide value test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test list values
+	std::string long_list{};
+	std::vector<std::uint64_t> long_expected{};
+	for (std::uint64_t i = 0; i < 100; ++i) {
+		long_list += (i == 0 ? "" : ",") + std::to_string(i * 1'000'000'007);
+		long_expected.push_back(i * 1'000'000'007);
+	}
+
+	const std::optional<ValueWrapper> long_value = detail::StringToValue(ValueType::kUInt64List, long_list);
+	const std::optional<ValueWrapper> empty_value = detail::StringToValue(ValueType::kIntList, ""sv);
+	const std::array<int, 4> checked{ 1, 5, 9, 3 };
+	const std::array<int, 2> outside{ 1, 10 };
+	const SupportedValueHolder ten{ ValueBounds{ 0, 10 } };
+	const SupportedValueHolder odd{ 1, 3, 5, 7, 9 };
+
+	std::optional<ValueWrapper> names_copy{};
+	{
+		std::string names_input{ "alpha,,gamma" };
+		const std::optional<ValueWrapper> names = detail::StringToValue(ValueType::kStringList, names_input);
+		names_copy = names;
+		names_input.assign(names_input.size(), 'x');
+	}
+
+	bool list_value_passed = long_value && long_value->GetValue<std::vector<std::uint64_t>>() == long_expected &&
+		empty_value && empty_value->GetListSize() == 0 &&
+		!detail::StringToValue(ValueType::kIntList, "1,x,3"sv) &&
+		ten.AreValid(std::span<const int>{ checked }) && !ten.AreValid(std::span<const int>{ outside }) &&
+		odd.AreValid(std::span<const int>{ checked }) && !odd.AreValid(std::span<const int>{ outside }) &&
+		odd.AreValid(std::span<const int>{ outside }.subspan(0, 1)) &&
+		!names_copy->IsBorrowed() &&
+		names_copy->GetValue<std::vector<std::string_view>>() == std::vector{ "alpha"sv, ""sv, "gamma"sv } &&
+		ValueTypeNames.at(ValueType::kStringList) == "string list"sv;
+
+	bool append_threw = false;
+	try {
+		"verbose"_o(ValueType::kBool).AsList();
+	}
+	catch (const std::invalid_argument&) {
+		append_threw = true;
+	}
+	list_value_passed &= append_threw;
+
+	CommandHandler list_test{};
+	CommandNode& list_node = (list_test.GetCommandNode() >> "test35"sv)(CommandArgument{ "ids", ValueType::kIntList },
+		"port"_o(ValueBounds{ 0, 65536 }).AsList(), "tag"_o(ValueType::kStringList));
+	list_node = [](const ExecutionContext& ctx) {
+		const auto tags = ctx.options.find("tag"sv);
+		const bool values_match = ctx.args.find("ids"sv)->second.GetValue<std::vector<int>>() == std::vector{ 1, 2, 3 } &&
+			ctx.options.find("port"sv)->second.GetValue<std::vector<int>>() == std::vector{ 80, 443, 8080 } &&
+			(tags == ctx.options.end() ||
+				tags->second.GetValue<std::vector<std::string_view>>() == std::vector{ "a"sv, "b"sv });
+		return values_match ? 35 : 0;
+	};
+	const std::string port_option = std::string{ build_options::OptionPrefix } + "port";
+	const std::string tag_option = std::string{ build_options::OptionPrefix } + "tag";
+
+	ExecutorRegistry list_registry{};
+	list_registry.Register("test35", list_node.GetExecutor());
+	list_registry.Bind(list_node, "test35"sv);
+	const std::vector<std::byte> list_bytes = CommandImage::Serialize(std::as_const(list_test).GetCommandNode());
+	const CommandImage list_image{ list_bytes, list_registry };
+
+	for (const bool from_image : { false, true }) {
+		const auto list_dispatch = [&](std::string_view second_port) {
+			const std::array input{ "test35"sv, "1,2,3"sv, std::string_view{ port_option }, "80,443"sv,
+				std::string_view{ tag_option }, "a,b"sv, std::string_view{ port_option }, second_port };
+			return from_image ? list_image.HandleCommand(input) : list_test.HandleCommand(input);
+		};
+		// repeats append, and only the appended elements are checked
+		list_value_passed &= list_dispatch("8080"sv) == 35 &&
+			list_dispatch("8080,70000"sv) == retc::kInvalidOptionValue &&
+			list_dispatch("8080,y"sv) == retc::kInvalidValueParse;
+	}
+
+	if (!list_value_passed) {
+		std::cerr << "list value test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test response file expansion, nested files and the depth limit
+	CommandHandler response_test{};
+	(response_test.GetCommandNode() >> "test36"sv)("count"_ai, "name"_as) = [](const ExecutionContext& ctx) {
+		const bool values_match = ctx.args.find("name"sv)->second.GetValue<std::string>() == "two words"sv &&
+			(!build_options::CacheExtraArgs || ctx.extra_args == std::vector{ "@literal"sv, "tail"sv });
+		return values_match ? ctx.args.find("count"sv)->second.GetValue<int>() : 0;
+	};
+
+	const std::filesystem::path response_dir = std::filesystem::temp_directory_path();
+	const std::filesystem::path outer_file = response_dir / "comad_response_outer.rsp";
+	const std::filesystem::path inner_file = response_dir / "comad_response_inner.rsp";
+	const std::filesystem::path loop_file = response_dir / "comad_response_loop.rsp";
+	const std::string outer_contents = "36 'two words'\n# comment\n@'" + inner_file.string() + "'\n";
+	{
+		std::ofstream outer{ outer_file, std::ios::binary };
+		outer << outer_contents;
+		std::ofstream inner{ inner_file, std::ios::binary };
+		inner << "@@literal";
+		std::ofstream loop{ loop_file, std::ios::binary };
+		loop << "@'" << loop_file.string() << "'";
+	}
+	const std::string outer_token = "@" + outer_file.string();
+	const std::string loop_token = "@" + loop_file.string();
+	const std::string missing_token = "@" + (response_dir / "comad_response_missing.rsp").string();
+
+	// disabled, the token is passed on as it is
+	bool response_file_passed = !response_test.IsResponseFilesEnabled() &&
+		response_test.HandleCommand("test36"sv, std::string_view{ outer_token }) == retc::kInvalidValueParse;
+
+	response_test.EnableResponseFiles(4);
+	const std::array response_input{ "test36"sv, std::string_view{ outer_token }, "tail"sv };
+	response_file_passed &= response_test.HandleCommand(response_input) == 36 &&
+		response_test.HandleCommandAsync(response_input).Get() == 36 &&
+		response_test.HandleCommand("test36"sv, std::string_view{ loop_token }) == retc::kResponseFileTooDeep &&
+		response_test.HandleCommand("test36"sv, std::string_view{ missing_token }) == retc::kResponseFileError;
+
+	std::ifstream outer_after{ outer_file, std::ios::binary };
+	response_file_passed &= std::string{ std::istreambuf_iterator<char>{ outer_after }, std::istreambuf_iterator<char>{} } ==
+		outer_contents;
+	outer_after.close();
+	std::filesystem::remove(outer_file);
+	std::filesystem::remove(inner_file);
+	std::filesystem::remove(loop_file);
+
+	if (!response_file_passed) {
+		std::cerr << "response file test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
+	//test hot swapping the command tree while other threads dispatch
+	CommandHandler swap_test{};
+	const auto make_swap_tree = [&swap_test](int result) {
+		CommandNode root{};
+		(root >> "test37"sv >> "leaf"sv) = [result](const ExecutionContext&) { return result; };
+		// reloads from a command finish the command on the tree it was found in
+		(root >> "reload"sv)("value"_ai) = [&swap_test, result](const ExecutionContext& ctx) {
+			CommandNode next{};
+			const int next_result = ctx.args.find("value"sv)->second.GetValue<int>();
+			(next >> "test37"sv >> "leaf"sv) = [next_result](const ExecutionContext&) { return next_result; };
+			swap_test.SetCommandNode(std::move(next));
+			return result;
+		};
+		return root;
+	};
+
+	swap_test.SetCommandNode(make_swap_tree(37));
+	const CommandNode& swapped_leaf = std::as_const(swap_test).GetCommandNode().GetChild("test37"sv).GetChild("leaf"sv);
+	bool hot_swap_passed = swap_test.IsFrozen() && swap_test.HandleCommand("test37"sv, "leaf"sv) == 37 &&
+		&swapped_leaf.GetParent().GetParent() == &std::as_const(swap_test).GetCommandNode() &&
+		swap_test.HandleCommand("reload"sv, "38"sv) == 37 && swap_test.HandleCommand("test37"sv, "leaf"sv) == 38 &&
+		swap_test.HandleCommand("reload"sv, "0"sv) == retc::kUnknownCommand;
+
+	std::atomic<bool> swapping{ true };
+	std::atomic<int> swap_failures{ 0 };
+	std::vector<std::thread> swap_threads{};
+	for (unsigned int t = 0; t < 4; ++t) {
+		swap_threads.emplace_back([&] {
+			while (swapping.load()) {
+				const int result = swap_test.HandleCommand("test37"sv, "leaf"sv);
+				if (result != 37 && result != 38 && result != 39) {
+					swap_failures.fetch_add(1);
+				}
+			}
+		});
+	}
+	for (int i = 0; i < 1000; ++i) {
+		swap_test.SetCommandNode(make_swap_tree(37 + i % 3));
+	}
+	swapping.store(false);
+	for (std::thread& thread : swap_threads) {
+		thread.join();
+	}
+
+	// an asynchronous command keeps the tree it was dispatched on alive until it is done, however often the
+	// tree is swapped meanwhile. the marker's executor goes away with its tree
+	AsyncGate swap_gate{};
+	std::weak_ptr<int> pinned_tree{};
+	CommandNode gated_tree{};
+	{
+		auto tree_alive = std::make_shared<int>(0);
+		pinned_tree = tree_alive;
+		(gated_tree >> "marker"sv) = [tree_alive = std::move(tree_alive)](const ExecutionContext&) { return *tree_alive; };
+	}
+	CommandNode& gated_swap_node = gated_tree >> "test38"sv;
+	gated_swap_node("value"_ai) = [&swap_gate](const ExecutionContext& ctx) -> CommandTask {
+		co_await swap_gate.Wait();
+		co_return ctx.args.at("value"sv).GetValue<int>();
+	};
+	gated_swap_node.SetCachePolicy(CachePolicy{});
+	swap_test.SetCommandNode(std::move(gated_tree));
+
+	const CommandFuture swapped_out = swap_test.HandleCommandAsync(async_pool, std::array{ "test38"sv, "38"sv });
+	swap_gate.suspended.wait(false);
+	for (int i = 0; i < 3; ++i) {
+		swap_test.SetCommandNode(make_swap_tree(37));
+	}
+	hot_swap_passed &= !pinned_tree.expired() && swap_test.HandleCommand("test38"sv, "38"sv) == retc::kUnknownCommand;
+
+	async_pool.Post(swap_gate.waiting);
+	hot_swap_passed &= swapped_out.Get() == 38;
+	// the frame releases the tree right after the result is set
+	for (int i = 0; i < 1000 && !pinned_tree.expired(); ++i) {
+		std::this_thread::yield();
+		swap_test.SetCommandNode(make_swap_tree(37));
+	}
+	hot_swap_passed &= pinned_tree.expired();
+
+	// thawing hands the tree set last back for editing
+	(swap_test.GetCommandNode() >> "test37"sv >> "other"sv) = [](const ExecutionContext&) { return 40; };
+	swap_test.Freeze();
+	hot_swap_passed &= swap_failures.load() == 0 && swap_test.HandleCommand("test37"sv, "leaf"sv) == 37 + 999 % 3 &&
+		swap_test.HandleCommand("test37"sv, "other"sv) == 40;
+
+	if (!hot_swap_passed) {
+		std::cerr << "hot swap test failed"sv << std::endl << std::endl;
+		failed = true;
+	}
+
 	if (failed) {
 		std::cerr << "all tests did not succeed"sv << std::endl;
 		return -1;